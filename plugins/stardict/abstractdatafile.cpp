@@ -0,0 +1,186 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "abstractdatafile.h"
+
+#include "chunkcache.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QString>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+using namespace MulaPluginStarDict;
+
+class AbstractDataFile::Private
+{
+    public:
+        Private()
+            : fileId(ChunkCache::instance()->newFileId())
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        // Identifies the decoded chunks of this file in the ChunkCache
+        quint32 fileId;
+};
+
+AbstractDataFile::AbstractDataFile()
+    : d(new Private)
+{
+}
+
+AbstractDataFile::~AbstractDataFile()
+{
+    removeCachedChunks();
+    delete d;
+}
+
+int
+AbstractDataFile::chunkCount() const
+{
+    return 0;
+}
+
+quint64
+AbstractDataFile::chunkStart(int index) const
+{
+    Q_UNUSED(index);
+    return 0;
+}
+
+void
+AbstractDataFile::setAccessPattern(AccessPattern accessPattern)
+{
+    Q_UNUSED(accessPattern);
+}
+
+QByteArray
+AbstractDataFile::decodeChunk(int index)
+{
+    Q_UNUSED(index);
+    return QByteArray();
+}
+
+QByteArray
+AbstractDataFile::readChunks(quint64 start, unsigned long size, QByteArray *chunk)
+{
+    quint64 end = start + size;
+    int count = chunkCount();
+
+    if (size == 0 || end > chunkStart(count))
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot read beyond the end of the file (%1 > %2)").arg(end).arg(chunkStart(count));
+        return QByteArray();
+    }
+
+    // The last chunk starting at or before the offset
+    int low = 0;
+    int high = count - 1;
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (chunkStart(middle) <= start)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    QByteArray resultData;
+    ChunkCache *chunkCache = ChunkCache::instance();
+
+    for (int i = low; i < count && chunkStart(i) < end; ++i)
+    {
+        QByteArray decodedChunk = chunkCache->chunk(d->fileId, i);
+        if (decodedChunk.isNull())
+        {
+            decodedChunk = decodeChunk(i);
+            if (quint64(decodedChunk.size()) != chunkStart(i + 1) - chunkStart(i))
+            {
+                qWarning() << Q_FUNC_INFO << QString("Cannot decode chunk %1").arg(i);
+                return QByteArray();
+            }
+
+            chunkCache->insert(d->fileId, i, decodedChunk);
+        }
+
+        quint64 chunkBegin = qMax(start, chunkStart(i)) - chunkStart(i);
+        quint64 chunkEnd = qMin(end, chunkStart(i + 1)) - chunkStart(i);
+
+        // The data lies in one chunk, which the caller may keep instead of
+        // copying the data
+        if (i == low && end <= chunkStart(i + 1))
+        {
+            if (!chunk)
+                return decodedChunk.mid(chunkBegin, size);
+
+            *chunk = decodedChunk;
+            return QByteArray::fromRawData(decodedChunk.constData() + chunkBegin, size);
+        }
+
+        if (resultData.isEmpty())
+            resultData.reserve(size);
+
+        resultData.append(decodedChunk.constData() + chunkBegin, chunkEnd - chunkBegin);
+    }
+
+    return resultData;
+}
+
+void
+AbstractDataFile::removeCachedChunks()
+{
+    ChunkCache::instance()->remove(d->fileId);
+}
+
+void
+AbstractDataFile::adviseMapping(const uchar *data, quint64 size, AccessPattern accessPattern)
+{
+#ifdef Q_OS_UNIX
+    if (!data || size == 0)
+        return;
+
+    int advice = POSIX_MADV_NORMAL;
+    switch (accessPattern)
+    {
+    case NormalAccess:
+        break;
+    case RandomAccess:
+        advice = POSIX_MADV_RANDOM;
+        break;
+    case SequentialAccess:
+        advice = POSIX_MADV_SEQUENTIAL;
+        break;
+    }
+
+    // QFile::map() starts the mapping at a page boundary for the offset 0
+    int status = posix_madvise(const_cast<uchar *>(data), size, advice);
+    if (status != 0)
+        qDebug() << Q_FUNC_INFO << QString("madvise failed (%1)").arg(status);
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    Q_UNUSED(accessPattern);
+#endif
+}
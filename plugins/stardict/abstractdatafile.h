@@ -0,0 +1,192 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_ABSTRACTDATAFILE_H
+#define MULA_PLUGIN_STARDICT_ABSTRACTDATAFILE_H
+
+#include <QtCore/QByteArray>
+
+class QString;
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Random access reader of the ".dict" data file in one of its
+     * compressed or uncompressed forms
+     *
+     * The successors decide how the data is stored. The ones keeping the data
+     * in independently decodable chunks only need to describe the chunks, and
+     * can use readChunks(), which keeps the decoded chunks in the ChunkCache.
+     *
+     * \see DictionaryZip, GzipDataFile, PlainDataFile, ZstdDataFile
+     */
+
+    class AbstractDataFile
+    {
+        public:
+
+            /**
+             * The expected order of the reads, see setAccessPattern()
+             */
+
+            enum AccessPattern
+            {
+                NormalAccess,       // No particular order
+                RandomAccess,       // Single lookups, read ahead is wasted
+                SequentialAccess    // Scanning the file, e.g. the full text search
+            };
+
+            /**
+             * Constructor
+             */
+
+            AbstractDataFile();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~AbstractDataFile();
+
+            /**
+             * Opens the data file
+             *
+             * @param   fileName    The complete file path of the data file
+             *
+             * @return True if the file was opened successfully, otherwise
+             * false.
+             */
+
+            virtual bool open(const QString& fileName) = 0;
+
+            /**
+             * Closes the data file
+             */
+
+            virtual void close() = 0;
+
+            /**
+             * Returns the uncompressed data of the file at the given position
+             *
+             * \note The successors must allow several threads to read at once.
+             *
+             * @param   start   The offset of the data in the uncompressed file
+             * @param   size    The size of the data
+             * @param   chunk   If not NULL and the data lies in one chunk, it
+             * may be set to that chunk, and the returned data is then a raw
+             * view into it that stays valid as long as the chunk is kept. The
+             * uncompressed files may return a raw view into the mapped file
+             * instead, which stays valid until the file is closed.
+             *
+             * @return The data, or an empty byte array on error
+             */
+
+            virtual QByteArray read(quint64 start, unsigned long size, QByteArray *chunk = 0) = 0;
+
+            /**
+             * Returns the number of the chunks of the file
+             *
+             * @return The number of the chunks, or 0 if the file is not
+             * chunked
+             *
+             * @see chunkStart
+             */
+
+            virtual int chunkCount() const;
+
+            /**
+             * Returns the offset of the chunk in the uncompressed file. The
+             * chunks are contiguous, and chunkStart(chunkCount()) is the
+             * uncompressed size of the file.
+             *
+             * @param   index   The index of the chunk
+             *
+             * @return The uncompressed offset of the chunk
+             *
+             * @see chunkCount
+             */
+
+            virtual quint64 chunkStart(int index) const;
+
+            /**
+             * Tells the system how the mapped file is going to be read, so it
+             * can tune the read ahead. The hint is dropped when the file is
+             * closed.
+             *
+             * \note The default implementation does nothing, which suits the
+             * files that are not mapped.
+             *
+             * @param   accessPattern   The expected order of the reads
+             */
+
+            virtual void setAccessPattern(AccessPattern accessPattern);
+
+        protected:
+
+            /**
+             * Decodes the whole chunk
+             *
+             * \note This method may be called from several threads at once.
+             *
+             * @param   index   The index of the chunk
+             *
+             * @return The decoded chunk, or a null byte array on error
+             *
+             * @see readChunks
+             */
+
+            virtual QByteArray decodeChunk(int index);
+
+            /**
+             * Implements read() for the chunked files by means of
+             * chunkCount(), chunkStart() and decodeChunk(). The decoded
+             * chunks are kept in the ChunkCache.
+             *
+             * @see read
+             */
+
+            QByteArray readChunks(quint64 start, unsigned long size, QByteArray *chunk);
+
+            /**
+             * Drops the decoded chunks of the file from the ChunkCache, which
+             * the successors do when the file is closed
+             */
+
+            void removeCachedChunks();
+
+            /**
+             * Passes the access pattern to madvise() for the mapped file on
+             * the systems supporting it
+             *
+             * @param   data            The start of the mapping
+             * @param   size            The size of the mapping
+             * @param   accessPattern   The expected order of the reads
+             *
+             * @see setAccessPattern
+             */
+
+            static void adviseMapping(const uchar *data, quint64 size, AccessPattern accessPattern);
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_ABSTRACTDATAFILE_H
@@ -19,11 +19,8 @@
 
 #include "abstractdictionary.h"
 
-#include "wordentry.h"
-#include "dictionaryzip.h"
-
-#include <QtCore/QFile>
-#include <QtCore/QVector>
+#include "abstractdatafile.h"
+#include "articlecache.h"
 
 using namespace MulaPluginStarDict;
 
@@ -31,9 +28,8 @@ class AbstractDictionary::Private
 {
     public:
         Private()
-            : dictionaryFile(new QFile)
-            , compressedDictionaryFile(0)
-            , currentCacheItemIndex(0)
+            : compressedDictionaryFile(0)
+            , dictionaryId(ArticleCache::instance()->newDictionaryId())
         {
         }
 
@@ -42,108 +38,63 @@ class AbstractDictionary::Private
         }
 
         QString sameTypeSequence;
-        QFile *dictionaryFile;
-        DictionaryZip *compressedDictionaryFile;
+        QByteArray sameTypeSequenceData;
+        AbstractDataFile *compressedDictionaryFile;
+
+        // Reads the raw data of an article, which is safe for concurrent
+        // readers. The view keeps the cached chunk alive while it refers to
+        // it, or refers to the mapped file.
+        ArticleView readArticle(quint64 offset, qint32 size)
+        {
+            QByteArray chunk;
+            QByteArray data = compressedDictionaryFile->read(offset, size, &chunk);
+            return ArticleView(data, sameTypeSequenceData, chunk);
+        }
 
-        QList<WordEntry> cacheItemList;
-        int currentCacheItemIndex;
-        static const int wordDataCacheSize = 10;
+        // Identifies the articles of this dictionary in the ArticleCache
+        quint32 dictionaryId;
 };
 
 AbstractDictionary::AbstractDictionary()
     : d(new Private)
 {
-    d->cacheItemList.reserve(d->wordDataCacheSize);
 }
 
 AbstractDictionary::~AbstractDictionary()
 {
+    ArticleCache::instance()->remove(d->dictionaryId);
     delete d->compressedDictionaryFile;
-    delete d->dictionaryFile;
     delete d;
 }
 
 const QByteArray
-AbstractDictionary::wordData(quint32 indexItemOffset, qint32 indexItemSize)
+AbstractDictionary::wordData(quint64 indexItemOffset, qint32 indexItemSize)
 {
     // Check first whether or not the data is already available in the cache
-    foreach (const WordEntry& cacheItem, d->cacheItemList)
-    {
-        if (!cacheItem.data().isEmpty() && cacheItem.dataOffset() == indexItemOffset)
-            return cacheItem.data();
-    }
-
-    QByteArray resultData;
-    QByteArray originalData;
-
-    if (!d->sameTypeSequence.isEmpty())
-    {
-        if (d->dictionaryFile->isOpen())
-        {
-            d->dictionaryFile->seek(indexItemOffset);
-            originalData = d->dictionaryFile->read(indexItemSize);
-        }
-        else
-        {
-            originalData = d->compressedDictionaryFile->read(indexItemOffset, indexItemSize);
-        }
-
-        int sameTypeSequenceLength = d->sameTypeSequence.length();
-
-        int sectionSize = 0;
-        int sectionPosition = 0;
-
-        // Copy the head items.
-        foreach (const QChar& ch, d->sameTypeSequence.left(sameTypeSequenceLength - 1))
-        {
-            if (ch.isUpper())
-            {
-                sectionSize = *reinterpret_cast<quint32 *>(originalData.mid(sectionPosition).data());
-                sectionSize += sizeof(quint32);
-            }
-            else
-            {
-                sectionSize = qstrlen(originalData.mid(sectionPosition)) + 1;
-            }
-
-            resultData.append(ch);
-            resultData.append(originalData.mid(sectionPosition, sectionSize));
-            sectionPosition += sectionSize;
-        }
+    ArticleCache *articleCache = ArticleCache::instance();
+    QByteArray resultData = articleCache->article(d->dictionaryId, indexItemOffset);
+    if (!resultData.isNull())
+        return resultData;
 
-        // Calculate the last item's size.
-        sectionSize = indexItemSize - sectionPosition;
-        resultData.append(d->sameTypeSequence.at(sameTypeSequenceLength - 1));
-        if (d->sameTypeSequence.at(sameTypeSequenceLength - 1).isUpper())
-        {
-            resultData.append(reinterpret_cast<char*>(&sectionSize), sizeof(quint32));
-            resultData.append(originalData.mid(sectionPosition, sectionSize));
-        }
-        else
-        {
-            resultData.append(originalData.mid(sectionPosition, sectionSize));
-            sectionPosition += sectionSize;
-            resultData.append('\0');
-        }
-    }
-    else
-    {
-        if (d->dictionaryFile->isOpen())
-            originalData = d->dictionaryFile->read(indexItemSize);
-        else
-            originalData = d->compressedDictionaryFile->read(indexItemOffset, indexItemSize);
+    // The typed data is a copy, so it does not refer to a cached chunk or to
+    // the mapped file
+    resultData = d->readArticle(indexItemOffset, indexItemSize).toTypedData();
 
-        resultData = originalData;
-    }
+    if (!resultData.isEmpty())
+        articleCache->insert(d->dictionaryId, indexItemOffset, resultData);
 
-    d->cacheItemList[d->currentCacheItemIndex].setData(resultData);
-    d->cacheItemList[d->currentCacheItemIndex].setDataOffset(indexItemOffset);
-    ++d->currentCacheItemIndex;
+    return resultData;
+}
 
-    if (d->currentCacheItemIndex == d->wordDataCacheSize)
-        d->currentCacheItemIndex = 0;
+ArticleView
+AbstractDictionary::articleView(quint64 indexItemOffset, qint32 indexItemSize)
+{
+    // The cached articles have their types embedded
+    QByteArray cachedData = ArticleCache::instance()->article(d->dictionaryId, indexItemOffset);
+    if (!cachedData.isNull())
+        return ArticleView(cachedData);
 
-    return resultData;
+    return d->readArticle(indexItemOffset, indexItemSize);
 }
 
 bool
@@ -162,74 +113,19 @@ AbstractDictionary::containFindData()
 }
 
 bool
-AbstractDictionary::findData(const QStringList &searchWords, qint32 indexItemOffset, qint32 indexItemSize)
+AbstractDictionary::findData(const QStringList &searchWords, quint64 indexItemOffset, qint32 indexItemSize)
 {
-    int wordCount = searchWords.size();
-    QVector<bool> wordFind(wordCount, false);
-    QByteArray tmpOriginalData;
-    QByteArray originalData;
-
-    if (d->dictionaryFile->isOpen())
-    {
-        d->dictionaryFile->seek(indexItemOffset);
-        originalData = d->dictionaryFile->read(indexItemSize);
-    }
-    else
-    {
-        originalData = d->compressedDictionaryFile->read(indexItemOffset, indexItemSize);
-    }
+    QList<QByteArray> remainingWords;
+    foreach (const QString& searchWord, searchWords)
+        remainingWords.append(searchWord.toUtf8());
 
-    int sectionSize = 0;
-    int sectionPosition = 0;
-    int foundCount = 0;
+    ArticleView article = d->readArticle(indexItemOffset, indexItemSize);
 
-    if (!d->sameTypeSequence.isEmpty())
+    // Only the text sections are searched, the others are stepped over
+    // without being read
+    for (int i = 0; i < article.sectionCount() && !remainingWords.isEmpty(); ++i)
     {
-        int sameTypeSequenceLength = d->sameTypeSequence.length();
-        foreach (const QChar& ch, d->sameTypeSequence.left(sameTypeSequenceLength - 1))
-        {
-            switch (ch.toLatin1())
-            {
-            case 'm':
-            case 'l':
-            case 'g':
-            case 't':
-            case 'x':
-            case 'y':
-                sectionSize = qstrlen(originalData.mid(sectionPosition)) + 1;
-                tmpOriginalData = originalData.mid(sectionPosition, sectionSize);
-                for (int j = 0; j < wordCount; ++j)
-                {
-                    if (!wordFind.at(j) && tmpOriginalData.indexOf(searchWords.at(j)) > -1)
-                    {
-                        wordFind[j] = true;
-                        ++foundCount;
-                    }
-                }
-
-                // If everything has been found
-                if (foundCount == wordCount)
-                    return true;
-
-                sectionPosition += sectionSize;
-                break;
-
-            default:
-                if (ch.isUpper())
-                {
-                    sectionSize = *reinterpret_cast<quint32 *>(originalData.mid(sectionPosition).data());
-                    sectionSize += sizeof(quint32);
-                }
-                else
-                {
-                    sectionSize = qstrlen(originalData.mid(sectionPosition)) + 1;
-                }
-
-                sectionPosition += sectionSize;
-            }
-        }
-
-        switch (d->sameTypeSequence.at(sameTypeSequenceLength - 1).toLatin1())
+        switch (article.sectionType(i))
         {
         case 'm':
         case 'l':
@@ -237,79 +133,42 @@ AbstractDictionary::findData(const QStringList &searchWords, qint32 indexItemOff
         case 't':
         case 'x':
         case 'y':
-            sectionSize = indexItemSize - sectionSize;
-            for (int j = 0; j < wordCount; ++j)
+        {
+            QByteArray section = article.section(i);
+            for (int j = remainingWords.size() - 1; j >= 0; --j)
             {
-                if (!wordFind[j] && originalData.indexOf(searchWords.at(j), sectionPosition) > -1)
-                {
-                    wordFind[j] = true;
-                    ++foundCount;
-                }
+                if (section.indexOf(remainingWords.at(j)) > -1)
+                    remainingWords.removeAt(j);
             }
 
-            if (foundCount == wordCount)
-                return true;
-
             break;
         }
-    }
-    else
-    {
-        while (sectionPosition < indexItemSize)
-        {
-            switch (originalData.at(sectionPosition))
-            {
-            case 'm':
-            case 'l':
-            case 'g':
-            case 't':
-            case 'x':
-            case 'y':
-                sectionSize = qstrlen(originalData.mid(sectionPosition)) + 1;
-                tmpOriginalData = originalData.mid(sectionPosition, sectionSize);
-                for (int j = 0; j < wordCount; ++j)
-                {
-                    if (!wordFind.at(j) && tmpOriginalData.indexOf(searchWords.at(j)) > -1)
-                    {
-                        wordFind[j] = true;
-                        ++foundCount;
-                    }
-                }
 
-                // Everything has been found
-                if (foundCount == wordCount)
-                    return true;
-
-                break;
-            default:
-                if (QChar(originalData.at(sectionSize)).isUpper())
-                {
-                    originalData.fromRawData(reinterpret_cast<char*>(&sectionSize), 4);
-                    sectionSize += sizeof(quint32);
-                }
-                else
-                {
-                    sectionSize = qstrlen(originalData.mid(sectionPosition)) + 1;
-                }
-            }
-
-            sectionPosition += sectionSize;
+        default:
+            break;
         }
     }
 
-    return false;
+    // Everything has been found
+    return remainingWords.isEmpty();
 }
 
-DictionaryZip*
+AbstractDataFile*
 AbstractDictionary::compressedDictionaryFile() const
 {
     return d->compressedDictionaryFile;
 }
 
-QFile*
-AbstractDictionary::dictionaryFile() const
+void
+AbstractDictionary::setCompressedDictionaryFile(AbstractDataFile *compressedDictionaryFile)
 {
-    return d->dictionaryFile;
+    if (d->compressedDictionaryFile != compressedDictionaryFile)
+    {
+        delete d->compressedDictionaryFile;
+        ArticleCache::instance()->remove(d->dictionaryId);
+    }
+
+    d->compressedDictionaryFile = compressedDictionaryFile;
 }
 
 QString
@@ -322,4 +181,5 @@ void
 AbstractDictionary::setSameTypeSequence(const QString& sameTypeSequence)
 {
     d->sameTypeSequence = sameTypeSequence;
+    d->sameTypeSequenceData = sameTypeSequence.toLatin1();
 }
@@ -20,13 +20,13 @@
 #ifndef MULA_PLUGIN_STARDICT_ABSTRACTDICTIONARY_H
 #define MULA_PLUGIN_STARDICT_ABSTRACTDICTIONARY_H
 
-#include <QtCore/QStringList>
+#include "articleview.h"
 
-class QFile;
+#include <QtCore/QStringList>
 
 namespace MulaPluginStarDict
 {
-    class DictionaryZip;
+    class AbstractDataFile;
     /** 
      * \brief Represents the ".dict" file format. The .dict file is a pure data
      * sequence, as the offset and size of each word is recorded in the
@@ -184,7 +184,9 @@ namespace MulaPluginStarDict
              * fields
              *
              * \note This method takes care about the low-level the details of
-             * the same type sequence settings in the index file.
+             * the same type sequence settings in the index file. It is safe to
+             * call from several threads at once. The returned articles are
+             * kept in the ArticleCache shared by all the dictionaries.
              *
              * @param indexItemOffset   The offset value in the dictionary file
              * @param indexItemSize     The size of the desired word data
@@ -194,7 +196,27 @@ namespace MulaPluginStarDict
              * @see findData, containFindData
              */
 
-            const QByteArray wordData(quint32 indexItemOffset, qint32 indexItemSize);
+            const QByteArray wordData(quint64 indexItemOffset, qint32 indexItemSize);
+
+            /**
+             * Returns a view of the typed sections of the article, which
+             * unlike wordData() does not rebuild the article. The callers
+             * interested in some of the sections only, e.g. the text ones,
+             * can skip the others without them being copied.
+             *
+             * \note The view may refer to the mapped data file, so it must
+             * not outlive the dictionary.
+             *
+             * @param indexItemOffset   The offset value in the dictionary file
+             * @param indexItemSize     The size of the desired word data
+             *
+             * @return The view of the article, which is null if the article
+             * could not be read
+             *
+             * @see wordData
+             */
+
+            ArticleView articleView(quint64 indexItemOffset, qint32 indexItemSize);
 
             /**
              * Returns whether the dictionary contains any of the given same
@@ -223,27 +245,30 @@ namespace MulaPluginStarDict
              * @see containData, wordData
              */
 
-            bool findData(const QStringList &searchWords, qint32 indexItemOffset, qint32 indexItemSize);
+            bool findData(const QStringList &searchWords, quint64 indexItemOffset, qint32 indexItemSize);
 
             /**
-             * Returns the compressed ".dict.dz" dictionary file
+             * Returns the compressed dictionary file, or the plain ".dict"
+             * file opened by PlainDataFile
              *
              * @return The compressed dictionary file
              *
-             * @see dictionaryFile
+             * @see setCompressedDictionaryFile
              */
 
-            DictionaryZip* compressedDictionaryFile() const;
+            AbstractDataFile* compressedDictionaryFile() const;
 
             /**
-             * Returns the ".dict" dictionary file
+             * Sets the compressed dictionary file, or the plain ".dict" file
+             * opened by PlainDataFile. The dictionary takes the ownership of
+             * the file, and deletes the previous one.
              *
-             * @return The dictionary file
+             * @param compressedDictionaryFile The opened dictionary file
              *
              * @see compressedDictionaryFile
              */
 
-            QFile* dictionaryFile() const;
+            void setCompressedDictionaryFile(AbstractDataFile *compressedDictionaryFile);
 
             /**
              * Sets the value of the same type sequence
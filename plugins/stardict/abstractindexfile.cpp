@@ -29,6 +29,9 @@ class AbstractIndexFile::Private
         Private()
             : wordEntryOffset(0)
             , wordEntrySize(0)
+            , progressFunction(0)
+            , pageEntryNumber(0)
+            , indexOffsetBits(32)
         {
         }
 
@@ -36,8 +39,11 @@ class AbstractIndexFile::Private
         {
         }
 
-        quint32 wordEntryOffset;
+        quint64 wordEntryOffset;
         quint32 wordEntrySize;
+        progress_func_t progressFunction;
+        int pageEntryNumber;
+        int indexOffsetBits;
 };
 
 AbstractIndexFile::AbstractIndexFile()
@@ -47,16 +53,23 @@ AbstractIndexFile::AbstractIndexFile()
 
 AbstractIndexFile::~AbstractIndexFile()
 {
+    delete d;
 }
 
-quint32
+void
+AbstractIndexFile::prefetch(long index) const
+{
+    Q_UNUSED(index);
+}
+
+quint64
 AbstractIndexFile::wordEntryOffset() const
 {
     return d->wordEntryOffset;
 }
 
 void
-AbstractIndexFile::setWordEntryOffset(quint32 wordEntryOffset)
+AbstractIndexFile::setWordEntryOffset(quint64 wordEntryOffset)
 {
     d->wordEntryOffset = wordEntryOffset;
 }
@@ -72,3 +85,57 @@ AbstractIndexFile::setWordEntrySize(quint32 wordEntrySize)
 {
     d->wordEntrySize = wordEntrySize;
 }
+
+void
+AbstractIndexFile::setProgressFunction(progress_func_t progressFunction)
+{
+    d->progressFunction = progressFunction;
+}
+
+AbstractIndexFile::progress_func_t
+AbstractIndexFile::progressFunction() const
+{
+    return d->progressFunction;
+}
+
+void
+AbstractIndexFile::setPageEntryNumber(int pageEntryNumber)
+{
+    d->pageEntryNumber = pageEntryNumber;
+}
+
+int
+AbstractIndexFile::pageEntryNumber() const
+{
+    return d->pageEntryNumber;
+}
+
+void
+AbstractIndexFile::setIndexOffsetBits(int indexOffsetBits)
+{
+    d->indexOffsetBits = indexOffsetBits;
+}
+
+int
+AbstractIndexFile::indexOffsetBits() const
+{
+    return d->indexOffsetBits;
+}
+
+void
+AbstractIndexFile::setPageCacheSize(int pageCacheSize)
+{
+    Q_UNUSED(pageCacheSize);
+}
+
+quint64
+AbstractIndexFile::pageCacheHitCount() const
+{
+    return 0;
+}
+
+quint64
+AbstractIndexFile::pageCacheMissCount() const
+{
+    return 0;
+}
@@ -29,6 +29,7 @@ namespace MulaPluginStarDict
     class AbstractIndexFile
     {
         public:
+            typedef void (*progress_func_t)(void);
 
             /**
              * Constructor
@@ -54,13 +55,24 @@ namespace MulaPluginStarDict
 
             virtual bool load(const QString& filePath) = 0;
 
+            /**
+             * Returns the number of the word entries found in the loaded index
+             * file, which the word count of the ".ifo" file is checked against
+             *
+             * @return The number of the word entries
+             */
+
+            virtual long wordCount() const = 0;
+
             /**
              * Returns the word data according to the relevant index
              *
              * \note Since it is an abstract base class, the real
              * implementation is up to the successors whether to return the
              * word directly, or to use some caching mechanism or something
-             * else.
+             * else. The returned data may be a non-owning view into the
+             * internal storage of the index file, hence it should be copied
+             * if it needs to outlive the next call.
              *
              * @param   index   The index of the desired word
              *
@@ -69,6 +81,37 @@ namespace MulaPluginStarDict
 
             virtual QByteArray key(long index) = 0;
 
+            /**
+             * Returns the word data like key(), but without setting the
+             * position of the word data
+             *
+             * \note Unlike key(), this method may be called from several
+             * threads at once, which the parallel scans of the dictionary
+             * manager rely on. It must not run together with key() though.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return  The word data
+             *
+             * @see key
+             */
+
+            virtual QByteArray keyData(long index) = 0;
+
+            /**
+             * Returns the collation key of the word data according to the
+             * relevant index as returned by stardictCollationKey()
+             *
+             * \note The returned data may be a non-owning view into the
+             * internal storage of the index file, similarly to key().
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return  The collation key of the word data
+             */
+
+            virtual QByteArray collationKey(long index) = 0;
+
             /**
              * Returns the index of the word data where it has been found. The
              * method will also return the fact whether or not the desired word
@@ -79,20 +122,176 @@ namespace MulaPluginStarDict
              * index and the found information directly, or to use some caching
              * mechanism or something else.
              *
-             * @param   word    The word data to look up
+             * @param   word        The word data to look up
+             * @param   nextIndex   If not NULL, it is set to the index of the
+             * first word entry not less than the desired word, even if the
+             * word could not be found
              *
              * @return The index where the desired word occurs among the word
              * entries, or -1 if there is no such a word.
              */
 
-            virtual int lookup(const QByteArray& word) = 0;
+            virtual int lookup(const QByteArray& word, int *nextIndex = 0) = 0;
+
+            /**
+             * Returns the offset of the word data in the ".dict" file
+             *
+             * \note Unlike key(), this method does not change
+             * wordEntryOffset(), and it is safe to call from several threads
+             * at once.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return  The offset of the word data
+             *
+             * @see dataSize
+             */
+
+            virtual quint64 dataOffset(long index) const = 0;
+
+            /**
+             * Returns the size of the word data in the ".dict" file
+             *
+             * \note Like dataOffset(), it is safe to call from several threads
+             * at once.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return  The size of the word data
+             *
+             * @see dataOffset
+             */
+
+            virtual quint32 dataSize(long index) const = 0;
+
+            /**
+             * Brings the word entry into memory ahead of a later key() call.
+             * It is safe to call from another thread than the one calling
+             * key(). The default implementation does nothing, which suits the
+             * index files kept in memory.
+             *
+             * @param   index   The index of the desired word
+             */
 
-            virtual quint32 wordEntryOffset() const;
-            virtual void setWordEntryOffset(quint32 wordEntryOffset);
+            virtual void prefetch(long index) const;
+
+            virtual quint64 wordEntryOffset() const;
+            virtual void setWordEntryOffset(quint64 wordEntryOffset);
 
             virtual quint32 wordEntrySize() const;
             virtual void setWordEntrySize(quint32 wordEntrySize);
 
+            /**
+             * Sets the function called regularly while a long loading is in
+             * progress
+             *
+             * @param   progressFunction    The progress function, or NULL
+             *
+             * @see progressFunction
+             */
+
+            void setProgressFunction(progress_func_t progressFunction);
+
+            /**
+             * Returns the function called regularly while a long loading is in
+             * progress
+             *
+             * @return  The progress function, or NULL if there is none
+             *
+             * @see setProgressFunction
+             */
+
+            progress_func_t progressFunction() const;
+
+            /**
+             * Sets the number of the word entries on a page of the index. The
+             * larger pages make the page directory smaller at the expense of
+             * more comparisons on the page itself.
+             *
+             * \note It has to be set before loading the index file.
+             *
+             * @param   pageEntryNumber The number of the word entries on a
+             * page, or 0 for the default
+             *
+             * @see pageEntryNumber
+             */
+
+            void setPageEntryNumber(int pageEntryNumber);
+
+            /**
+             * Returns the number of the word entries on a page of the index
+             *
+             * @return  The number of the word entries on a page, or 0 for the
+             * default
+             *
+             * @see setPageEntryNumber
+             */
+
+            int pageEntryNumber() const;
+
+            /**
+             * Sets the size of the data offsets in the word entries as given
+             * by the "idxoffsetbits" option of the ".ifo" file
+             *
+             * \note It has to be set before loading the index file.
+             *
+             * @param   indexOffsetBits The size of the data offsets in bits,
+             * either 32 or 64
+             *
+             * @see indexOffsetBits
+             */
+
+            void setIndexOffsetBits(int indexOffsetBits);
+
+            /**
+             * Returns the size of the data offsets in the word entries, the
+             * default is 32.
+             *
+             * @return  The size of the data offsets in bits
+             *
+             * @see setIndexOffsetBits
+             */
+
+            int indexOffsetBits() const;
+
+            /**
+             * Sets the maximum number of the index pages kept in memory at
+             * the same time, if the index file keeps the pages in a cache at
+             * all. The least recently used page is dropped first.
+             *
+             * \note The base implementation does nothing since it is up to
+             * the successors how the word data is stored.
+             *
+             * @param   pageCacheSize   The maximum number of the cached pages,
+             * or 0 for the default
+             *
+             * @see pageCacheHitCount, pageCacheMissCount
+             */
+
+            virtual void setPageCacheSize(int pageCacheSize);
+
+            /**
+             * Returns the number of the word data accesses served from the
+             * page cache
+             *
+             * @return  The number of the page cache hits
+             *
+             * @see pageCacheMissCount, setPageCacheSize
+             */
+
+            virtual quint64 pageCacheHitCount() const;
+
+            /**
+             * Returns the number of the word data accesses which needed
+             * loading a page into the page cache
+             *
+             * @return  The number of the page cache misses
+             *
+             * @see pageCacheHitCount, setPageCacheSize
+             */
+
+            virtual quint64 pageCacheMissCount() const;
+
         private:
             class Private;
             Private *const d;
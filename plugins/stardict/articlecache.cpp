@@ -0,0 +1,66 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "articlecache.h"
+
+using namespace MulaPluginStarDict;
+
+Q_GLOBAL_STATIC(ArticleCache, globalArticleCache)
+
+namespace
+{
+    const qint64 defaultMaximumSize = 16 * 1024 * 1024;
+
+    // The short articles are dominated by the size of the key, the byte
+    // array and the cache node
+    const int entryOverhead = 64;
+}
+
+ArticleCache::ArticleCache()
+    : ShardedCache(defaultMaximumSize, entryOverhead)
+{
+}
+
+ArticleCache::~ArticleCache()
+{
+}
+
+ArticleCache*
+ArticleCache::instance()
+{
+    return globalArticleCache();
+}
+
+quint32
+ArticleCache::newDictionaryId()
+{
+    return newOwnerId();
+}
+
+QByteArray
+ArticleCache::article(quint32 dictionaryId, quint64 offset)
+{
+    return object(dictionaryId, offset);
+}
+
+void
+ArticleCache::insert(quint32 dictionaryId, quint64 offset, const QByteArray& article)
+{
+    ShardedCache::insert(dictionaryId, offset, article);
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_ARTICLECACHE_H
+#define MULA_PLUGIN_STARDICT_ARTICLECACHE_H
+
+#include "shardedcache.h"
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Process wide cache of the articles returned by
+     * AbstractDictionary::wordData()
+     *
+     * The frequently looked up articles are served from memory without
+     * reading the data file at all. The entries are keyed by the identifier
+     * of the dictionary, as returned by newDictionaryId(), and the offset of
+     * the article in the data file. The articles of all the dictionaries
+     * share one memory budget, and the least recently used articles are
+     * dropped once it is exceeded.
+     *
+     * Like the ChunkCache, the cache is split into shards with their own lock
+     * and their own part of the budget.
+     *
+     * \see ChunkCache
+     */
+
+    class ArticleCache : public ShardedCache
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            ArticleCache();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~ArticleCache();
+
+            /**
+             * Returns the cache shared by all the dictionaries
+             *
+             * @return The global article cache
+             */
+
+            static ArticleCache *instance();
+
+            /**
+             * Returns a new identifier for a dictionary whose articles are
+             * cached
+             *
+             * \note The identifiers are never reused, so a deleted dictionary
+             * cannot leave stale articles to another one.
+             *
+             * @return The dictionary identifier
+             */
+
+            quint32 newDictionaryId();
+
+            /**
+             * Returns the cached article, and marks it as the most recently
+             * used one
+             *
+             * @param   dictionaryId    The identifier of the dictionary
+             * @param   offset          The offset of the article in the data
+             * file
+             *
+             * @return The article, or a null byte array if the article is not
+             * cached
+             *
+             * @see insert
+             */
+
+            QByteArray article(quint32 dictionaryId, quint64 offset);
+
+            /**
+             * Inserts the article into the cache, and evicts the least
+             * recently used articles of its shard if the budget is exceeded
+             *
+             * @param   dictionaryId    The identifier of the dictionary
+             * @param   offset          The offset of the article in the data
+             * file
+             * @param   article         The article, which must not refer to
+             * the memory of the data file
+             *
+             * @see article
+             */
+
+            void insert(quint32 dictionaryId, quint64 offset, const QByteArray& article);
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_ARTICLECACHE_H
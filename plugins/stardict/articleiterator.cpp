@@ -0,0 +1,217 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "articleiterator.h"
+
+#include "abstractdatafile.h"
+#include "dictionary.h"
+
+#include <QtCore/QVector>
+
+#include <algorithm>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    struct Entry
+    {
+        quint64 dataOffset;
+        quint32 dataSize;
+        qint32 index;
+    };
+
+    bool operator<(const Entry& left, const Entry& right)
+    {
+        if (left.dataOffset != right.dataOffset)
+            return left.dataOffset < right.dataOffset;
+
+        return left.index < right.index;
+    }
+}
+
+class ArticleIterator::Private
+{
+    public:
+        Private()
+            : dictionary(0)
+            , dataFile(0)
+            , position(0)
+            , chunkIndex(-1)
+            , chunkBegin(0)
+            , chunkEnd(0)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        // Reads the data of the entry, sliced out of the kept chunk whenever
+        // it lies in there
+        QByteArray readData(const Entry& entry)
+        {
+            quint64 entryEnd = entry.dataOffset + entry.dataSize;
+            if (!chunk.isEmpty() && entry.dataOffset >= chunkBegin && entryEnd <= chunkEnd)
+                return QByteArray::fromRawData(chunk.constData() + (entry.dataOffset - chunkBegin), entry.dataSize);
+
+            QByteArray entryChunk;
+            QByteArray data = dataFile->read(entry.dataOffset, entry.dataSize, &entryChunk);
+
+            int count = dataFile->chunkCount();
+            if (entryChunk.isEmpty() || count == 0)
+                return data;
+
+            // The read data lies in one chunk, which follows the kept one in
+            // most of the cases
+            int index = qMax(chunkIndex, 0);
+            if (dataFile->chunkStart(index) > entry.dataOffset)
+                index = 0;
+
+            while (index < count - 1 && dataFile->chunkStart(index + 1) <= entry.dataOffset)
+                ++index;
+
+            chunk = entryChunk;
+            chunkIndex = index;
+            chunkBegin = dataFile->chunkStart(index);
+            chunkEnd = dataFile->chunkStart(index + 1);
+
+            return data;
+        }
+
+        Dictionary *dictionary;
+        AbstractDataFile *dataFile;
+        QByteArray sameTypeSequence;
+
+        QVector<Entry> entries;
+        int position;
+
+        QByteArray data;
+
+        // The last decoded chunk and its range in the uncompressed file
+        QByteArray chunk;
+        int chunkIndex;
+        quint64 chunkBegin;
+        quint64 chunkEnd;
+};
+
+ArticleIterator::ArticleIterator(Dictionary *dictionary)
+    : d(new Private)
+{
+    d->dictionary = dictionary;
+    if (!dictionary->isLoaded())
+        return;
+
+    d->dataFile = dictionary->compressedDictionaryFile();
+    d->sameTypeSequence = dictionary->sameTypeSequence().toLatin1();
+
+    int count = dictionary->articleCount();
+    d->entries.resize(count);
+
+    bool sorted = true;
+    for (int i = 0; i < count; ++i)
+    {
+        Entry& entry = d->entries[i];
+        entry.dataOffset = dictionary->dataOffset(i);
+        entry.dataSize = dictionary->dataSize(i);
+        entry.index = i;
+
+        if (i > 0 && entry.dataOffset < d->entries.at(i - 1).dataOffset)
+            sorted = false;
+    }
+
+    // The data is usually written in the order of the index
+    if (!sorted)
+        std::sort(d->entries.begin(), d->entries.end());
+
+    d->dataFile->setAccessPattern(AbstractDataFile::SequentialAccess);
+}
+
+ArticleIterator::~ArticleIterator()
+{
+    if (d->dataFile)
+        d->dataFile->setAccessPattern(AbstractDataFile::NormalAccess);
+
+    delete d;
+}
+
+bool
+ArticleIterator::next()
+{
+    if (!hasNext())
+        return false;
+
+    d->data = d->readData(d->entries.at(d->position));
+    ++d->position;
+    return true;
+}
+
+bool
+ArticleIterator::hasNext() const
+{
+    return d->position < d->entries.size();
+}
+
+void
+ArticleIterator::toFront()
+{
+    d->position = 0;
+    d->data.clear();
+}
+
+int
+ArticleIterator::position() const
+{
+    return d->position;
+}
+
+int
+ArticleIterator::count() const
+{
+    return d->entries.size();
+}
+
+long
+ArticleIterator::index() const
+{
+    if (d->position == 0)
+        return -1;
+
+    return d->entries.at(d->position - 1).index;
+}
+
+QString
+ArticleIterator::key() const
+{
+    if (d->position == 0)
+        return QString();
+
+    return d->dictionary->key(index());
+}
+
+ArticleView
+ArticleIterator::articleView() const
+{
+    if (d->position == 0 || d->data.isEmpty())
+        return ArticleView();
+
+    // The view keeps the chunk alive, or the mapping for the files that are
+    // not compressed
+    return ArticleView(d->data, d->sameTypeSequence, d->chunk);
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_ARTICLEITERATOR_H
+#define MULA_PLUGIN_STARDICT_ARTICLEITERATOR_H
+
+#include "articleview.h"
+
+#include <QtCore/QString>
+
+namespace MulaPluginStarDict
+{
+    class Dictionary;
+
+    /**
+     * \brief Streams all the articles of a dictionary in the order of their
+     * word data
+     *
+     * The word entries are visited by their offset in the data file rather
+     * than by their position in the index, so the data file is read from the
+     * start to the end. The decoded chunk is kept between the entries, and
+     * the articles lying in it are sliced out without another lookup, thus
+     * every chunk is decoded once. The articles are not put into the
+     * ArticleCache.
+     *
+     * \code
+     * ArticleIterator iterator(dictionary);
+     * while (iterator.next())
+     *     export(iterator.key(), iterator.articleView());
+     * \endcode
+     *
+     * \note The iterator uses the dictionary like key() does, so it must not
+     * be used from another thread at the same time. The dictionary must stay
+     * loaded while the iterator exists.
+     *
+     * \see Dictionary, ArticleView
+     */
+
+    class ArticleIterator
+    {
+        public:
+
+            /**
+             * Constructor, which orders the word entries of the dictionary by
+             * the offsets of their data
+             *
+             * @param   dictionary  The loaded dictionary to go through
+             */
+
+            explicit ArticleIterator(Dictionary *dictionary);
+
+            /**
+             * Destructor
+             */
+
+            virtual ~ArticleIterator();
+
+            /**
+             * Advances to the next word entry, and reads its article
+             *
+             * @return True if there was a next entry, otherwise false
+             */
+
+            bool next();
+
+            /**
+             * Returns whether there are more word entries after the current
+             * one
+             *
+             * @return True if next() would advance, otherwise false
+             */
+
+            bool hasNext() const;
+
+            /**
+             * Moves the iterator before the first word entry
+             */
+
+            void toFront();
+
+            /**
+             * Returns the number of the word entries visited so far
+             *
+             * @return The position of the iterator
+             *
+             * @see count
+             */
+
+            int position() const;
+
+            /**
+             * Returns the number of the word entries of the dictionary
+             *
+             * @return The number of the entries
+             *
+             * @see position
+             */
+
+            int count() const;
+
+            /**
+             * Returns the index of the current word entry in the dictionary
+             *
+             * @return The index of the entry, or -1 before the first next()
+             */
+
+            long index() const;
+
+            /**
+             * Returns the headword of the current word entry
+             *
+             * @return The headword
+             */
+
+            QString key() const;
+
+            /**
+             * Returns the article of the current word entry
+             *
+             * \note The view shares the decoded chunk instead of copying the
+             * data, and stays valid after the iterator advances.
+             *
+             * @return The view of the article, or a null view if the data
+             * could not be read
+             */
+
+            ArticleView articleView() const;
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_ARTICLEITERATOR_H
@@ -0,0 +1,232 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "articleview.h"
+
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+#include <string.h>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    struct Section
+    {
+        char type;
+        int start;
+        int size;
+    };
+}
+
+class ArticleView::Private : public QSharedData
+{
+    public:
+        Private()
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        // Locates all the sections of the data
+        void locateSections();
+
+        QByteArray data;
+        QByteArray sameTypeSequence;
+        QByteArray holder;
+
+        // The sections, located once by the constructor so that the shared
+        // data is never modified afterwards
+        QVector<Section> sections;
+};
+
+void
+ArticleView::Private::locateSections()
+{
+    if (data.isEmpty())
+        return;
+
+    const char *begin = data.constData();
+    int dataSize = data.size();
+    int position = 0;
+
+    forever
+    {
+        int sectionIndex = sections.size();
+
+        Section section;
+        bool lastSection = false;
+
+        if (sameTypeSequence.isEmpty())
+        {
+            if (position >= dataSize)
+                return;
+
+            section.type = begin[position++];
+        }
+        else
+        {
+            if (sectionIndex >= sameTypeSequence.size())
+                return;
+
+            section.type = sameTypeSequence.at(sectionIndex);
+
+            // The size or the terminator of the last section is omitted
+            lastSection = (sectionIndex == sameTypeSequence.size() - 1);
+        }
+
+        if (lastSection)
+        {
+            section.start = position;
+            section.size = dataSize - position;
+            position = dataSize;
+        }
+        else if (section.type >= 'A' && section.type <= 'Z')
+        {
+            // The size is a network byte ordered 32 bits number
+            if (dataSize - position < int(sizeof(quint32)))
+                return;
+
+            quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(begin + position));
+            section.start = position + sizeof(quint32);
+            section.size = qMin<quint32>(size, dataSize - section.start);
+            position = section.start + section.size;
+        }
+        else
+        {
+            const char *terminator = static_cast<const char *>(memchr(begin + position, '\0', dataSize - position));
+            section.start = position;
+            section.size = terminator ? terminator - (begin + position) : dataSize - position;
+            position = section.start + section.size + 1;
+        }
+
+        sections.append(section);
+
+        if (position >= dataSize && (sameTypeSequence.isEmpty() || lastSection || position > dataSize))
+            return;
+    }
+}
+
+ArticleView::ArticleView()
+    : d(new Private)
+{
+}
+
+ArticleView::ArticleView(const QByteArray& data, const QByteArray& sameTypeSequence, const QByteArray& holder)
+    : d(new Private)
+{
+    d->data = data;
+    d->sameTypeSequence = sameTypeSequence;
+    d->holder = holder;
+    d->locateSections();
+}
+
+ArticleView::ArticleView(const ArticleView &other)
+    : d(other.d)
+{
+}
+
+ArticleView::~ArticleView()
+{
+}
+
+ArticleView&
+ArticleView::operator=(const ArticleView &other)
+{
+    d = other.d;
+    return *this;
+}
+
+bool
+ArticleView::isNull() const
+{
+    return d->data.isNull();
+}
+
+int
+ArticleView::sectionCount() const
+{
+    return d->sections.size();
+}
+
+char
+ArticleView::sectionType(int index) const
+{
+    if (index < 0 || index >= d->sections.size())
+        return '\0';
+
+    return d->sections.at(index).type;
+}
+
+QByteArray
+ArticleView::section(int index) const
+{
+    if (index < 0 || index >= d->sections.size())
+        return QByteArray();
+
+    const Section& section = d->sections.at(index);
+    return QByteArray::fromRawData(d->data.constData() + section.start, section.size);
+}
+
+int
+ArticleView::indexOf(char type, int from) const
+{
+    for (int i = qMax(from, 0); i < d->sections.size(); ++i)
+    {
+        if (d->sections.at(i).type == type)
+            return i;
+    }
+
+    return -1;
+}
+
+QByteArray
+ArticleView::toTypedData() const
+{
+    if (d->sameTypeSequence.isEmpty())
+        return QByteArray(d->data.constData(), d->data.size());
+
+    QByteArray result;
+    result.reserve(d->data.size() + 5 * d->sameTypeSequence.size());
+
+    int count = sectionCount();
+    for (int i = 0; i < count; ++i)
+    {
+        const Section& section = d->sections.at(i);
+        result.append(section.type);
+
+        if (section.type >= 'A' && section.type <= 'Z')
+        {
+            uchar size[sizeof(quint32)];
+            qToBigEndian<quint32>(section.size, size);
+            result.append(reinterpret_cast<const char *>(size), sizeof(size));
+            result.append(d->data.constData() + section.start, section.size);
+        }
+        else
+        {
+            result.append(d->data.constData() + section.start, section.size);
+            result.append('\0');
+        }
+    }
+
+    return result;
+}
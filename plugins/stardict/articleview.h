@@ -0,0 +1,161 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_ARTICLEVIEW_H
+#define MULA_PLUGIN_STARDICT_ARTICLEVIEW_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSharedDataPointer>
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Read-only view of the typed sections of an article
+     *
+     * The view works directly on the raw bytes of the article as stored in
+     * the ".dict" file, either with the type of every section given by the
+     * "sametypesequence" of the dictionary, or with the type characters
+     * embedded in the data. See AbstractDictionary for the section types.
+     *
+     * The sections are located once by the constructor. The lower case
+     * sections are found by their terminating '\0', and the upper case ones,
+     * e.g. the 'W' sounds and the 'P' pictures, are stepped over by their
+     * size, so their content is never read or copied unless the caller asks
+     * for that very section. section() returns raw views into the article,
+     * which stay valid as long as the view or one of its copies exists.
+     *
+     * \note The view is immutable once constructed, so the copies of a view
+     * can be used from several threads at once.
+     *
+     * \see AbstractDictionary::articleView
+     */
+
+    class ArticleView
+    {
+        public:
+
+            /**
+             * Constructor of a null view
+             */
+
+            ArticleView();
+
+            /**
+             * Constructor
+             *
+             * @param   data                The raw article
+             * @param   sameTypeSequence    The types of the sections, or an
+             * empty array if the types are embedded in the data
+             * @param   holder              The storage that data may refer
+             * to, which is kept alive as long as the view
+             */
+
+            ArticleView(const QByteArray& data, const QByteArray& sameTypeSequence = QByteArray(),
+                        const QByteArray& holder = QByteArray());
+
+            /**
+             * Copy Constructor
+             */
+
+            ArticleView(const ArticleView &other);
+
+            /**
+             * Destructor
+             */
+
+            virtual ~ArticleView();
+
+            /**
+             * Assignment operator
+             */
+
+            ArticleView& operator=(const ArticleView &other);
+
+            /**
+             * Returns whether the view was constructed without any data, for
+             * example because the article could not be read
+             *
+             * @return True if the view has no data, otherwise false
+             */
+
+            bool isNull() const;
+
+            /**
+             * Returns the number of the sections
+             *
+             * @return The number of the sections
+             */
+
+            int sectionCount() const;
+
+            /**
+             * Returns the type character of the section
+             *
+             * @param   index   The index of the section
+             *
+             * @return The type of the section, or '\0' if there is no such
+             * section
+             *
+             * @see section
+             */
+
+            char sectionType(int index) const;
+
+            /**
+             * Returns the content of the section without its type character,
+             * size or terminating '\0'
+             *
+             * @param   index   The index of the section
+             *
+             * @return A raw view of the content, or a null byte array if there
+             * is no such section
+             *
+             * @see sectionType
+             */
+
+            QByteArray section(int index) const;
+
+            /**
+             * Returns the index of the next section of the given type
+             *
+             * @param   type    The type character of the section
+             * @param   from    The index of the section to start from
+             *
+             * @return The index of the section, or -1 if not found
+             */
+
+            int indexOf(char type, int from = 0) const;
+
+            /**
+             * Returns the article in the form with the embedded type
+             * characters, as returned by AbstractDictionary::wordData(). The
+             * data is copied, so it does not refer to the holder.
+             *
+             * @return The typed article
+             */
+
+            QByteArray toTypedData() const;
+
+        private:
+            class Private;
+            QSharedDataPointer<Private> d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_ARTICLEVIEW_H
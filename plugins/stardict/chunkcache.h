@@ -0,0 +1,109 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_CHUNKCACHE_H
+#define MULA_PLUGIN_STARDICT_CHUNKCACHE_H
+
+#include "shardedcache.h"
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Process wide cache of the inflated dictzip chunks
+     *
+     * The chunks of all the opened ".dict.dz" files share one memory budget,
+     * and the least recently used chunks are dropped once it is exceeded.
+     * The entries are keyed by the identifier of the file, as returned by
+     * newFileId(), and the index of the chunk in that file.
+     *
+     * The cache is split into shards with their own lock and their own part
+     * of the budget, so concurrent readers rarely wait for each other. The
+     * chunks are implicitly shared byte arrays, thus the callers can keep a
+     * chunk alive and slice articles out of it without copying the data,
+     * even if the chunk is evicted in the meantime.
+     *
+     * \see DictionaryZip
+     */
+
+    class ChunkCache : public ShardedCache
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            ChunkCache();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~ChunkCache();
+
+            /**
+             * Returns the cache shared by all the dictionaries
+             *
+             * @return The global chunk cache
+             */
+
+            static ChunkCache *instance();
+
+            /**
+             * Returns a new identifier for a file whose chunks are cached
+             *
+             * \note The identifiers are never reused, so a closed file cannot
+             * see the stale chunks of another one.
+             *
+             * @return The file identifier
+             */
+
+            quint32 newFileId();
+
+            /**
+             * Returns the cached chunk, and marks it as the most recently used
+             * one
+             *
+             * @param   fileId      The identifier of the file
+             * @param   chunkIndex  The index of the chunk in the file
+             *
+             * @return The inflated chunk, or a null byte array if the chunk is
+             * not cached
+             *
+             * @see insert
+             */
+
+            QByteArray chunk(quint32 fileId, int chunkIndex);
+
+            /**
+             * Inserts the inflated chunk into the cache, and evicts the least
+             * recently used chunks of its shard if the budget is exceeded
+             *
+             * @param   fileId      The identifier of the file
+             * @param   chunkIndex  The index of the chunk in the file
+             * @param   chunk       The inflated chunk
+             *
+             * @see chunk
+             */
+
+            void insert(quint32 fileId, int chunkIndex, const QByteArray& chunk);
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_CHUNKCACHE_H
@@ -20,29 +20,137 @@
 #include "dictionary.h"
 
 #include "dictionaryzip.h"
+#include "distance.h"
+#include "file.h"
+#include "fuzzyindex.h"
+#include "gzipdatafile.h"
+#include "matchheap.h"
+#include "ngramindex.h"
+#include "plaindatafile.h"
 #include "stardictdictionaryinfo.h"
 #include "indexfile.h"
 #include "offsetcachefile.h"
+#include "wildcardpattern.h"
 
+#ifdef HAVE_ZSTD
+#include "zstddatafile.h"
+#endif
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QScopedPointer>
+#include <QtCore/QWaitCondition>
 #include <QtCore/QFile>
+#include <QtCore/QRegExp>
 #include <QtCore/QDebug>
 
 using namespace MulaPluginStarDict;
 
+static AbstractDataFile *
+openDataFile(AbstractDataFile *dataFile, const QString& filePath)
+{
+    if (QFile::exists(filePath) && dataFile->open(filePath))
+        return dataFile;
+
+    delete dataFile;
+    return 0;
+}
+
+// Opens the first usable data file of the dictionary, trying the compressed
+// forms first.
+static AbstractDataFile *
+openDataFile(const QString& dictionaryFilePath)
+{
+    AbstractDataFile *result = openDataFile(new DictionaryZip, dictionaryFilePath + ".dz");
+
+    // Plain gzip files are sometimes named ".dz" as well
+    if (!result)
+        result = openDataFile(new GzipDataFile, dictionaryFilePath + ".dz");
+
+#ifdef HAVE_ZSTD
+    if (!result)
+        result = openDataFile(new ZstdDataFile, dictionaryFilePath + ".zst");
+#endif
+
+    if (!result)
+        result = openDataFile(new GzipDataFile, dictionaryFilePath + ".gz");
+
+    if (!result)
+        result = openDataFile(new PlainDataFile, dictionaryFilePath);
+
+    return result;
+}
+
 class Dictionary::Private
 {
     public:
         Private()
+            : progressFunction(0)
+            , pageCacheSize(0)
+            , ngramIndex(0)
+            , loaded(0)
+            , failed(0)
         {
         }
 
         ~Private()
         {
+            delete ngramIndex.loadAcquire();
+        }
+
+        // Returns the first word entry of the range that does not compare
+        // less than the ascii prefix, or with upper, greater than it
+        long prefixBound(const QByteArray& prefix, long first, long last, bool upper) const
+        {
+            while (first < last)
+            {
+                long middle = first + (last - first) / 2;
+                QByteArray word = indexFile->keyData(middle);
+                int result = stardictAsciiPrefixCompare(word.constData(), word.size(), prefix.constData(), prefix.size());
+
+                if (result < 0 || (upper && result == 0))
+                    first = middle + 1;
+                else
+                    last = middle;
+            }
+
+            return first;
+        }
+
+        void applyPageCacheSize()
+        {
+            indexFile->setPageCacheSize(pageCacheSize);
+            if (!synonymFile.isNull())
+                synonymFile->setPageCacheSize(pageCacheSize);
         }
 
         StarDictDictionaryInfo dictionaryInfo;
         QScopedPointer<AbstractIndexFile> indexFile;
+        QScopedPointer<OffsetCacheFile> synonymFile;
+        FuzzyIndex fuzzyIndex;
+        AbstractIndexFile::progress_func_t progressFunction;
+
+        // Set by setPageCacheSize() from any thread, and applied to the files
+        // once they are published, guarded by the mutex
+        int pageCacheSize;
+        QMutex pageCacheMutex;
+
+        // Set with release semantics once built, while the pattern lookups
+        // may already run in other threads
+        QAtomicPointer<NgramIndex> ngramIndex;
+
+        // Set with release semantics once the files are usable, so the
+        // readers in other threads see the fully constructed index
+        QAtomicInt loaded;
+
+        // Set once loadFiles() has given up on the files
+        QAtomicInt failed;
+
+        // Wakes up the threads in waitForLoaded() once loadFiles() finishes
+        QMutex loadMutex;
+        QWaitCondition loadCondition;
 };
 
 Dictionary::Dictionary()
@@ -52,6 +160,7 @@ Dictionary::Dictionary()
 
 Dictionary::~Dictionary()
 {
+    delete d;
 }
 
 int
@@ -75,7 +184,7 @@ Dictionary::ifoFilePath() const
 QString
 Dictionary::key(long index) const
 {
-    if (d->indexFile.isNull())
+    if (!isLoaded())
         return QString();
 
     return d->indexFile->key(index);
@@ -85,79 +194,167 @@ QString
 Dictionary::data(long index)
 {
     Q_UNUSED(index);
-    if (d->indexFile.isNull())
+    if (!isLoaded())
         return QString();
 
     return AbstractDictionary::wordData(d->indexFile->wordEntryOffset(), d->indexFile->wordEntrySize());
 }
 
+ArticleView
+Dictionary::articleView(long index)
+{
+    if (!isLoaded())
+        return ArticleView();
+
+    // Looking up the key sets the position of the word data
+    d->indexFile->key(index);
+    return AbstractDictionary::articleView(d->indexFile->wordEntryOffset(), d->indexFile->wordEntrySize());
+}
+
+qint64
+Dictionary::prefetch(long index)
+{
+    if (!isLoaded() || index < 0 || index >= articleCount())
+        return 0;
+
+    d->indexFile->prefetch(index);
+
+    quint64 offset = dataOffset(index);
+    quint32 size = dataSize(index);
+
+    QByteArray chunk;
+    QByteArray data = compressedDictionaryFile()->read(offset, size, &chunk);
+
+    // The uncompressed data is only a view into the mapping, whose pages are
+    // read once touched
+    const int pageSize = 4096;
+    const volatile char *bytes = data.constData();
+    for (int i = 0; i < data.size(); i += pageSize)
+        (void)bytes[i];
+
+    return size;
+}
+
+quint64
+Dictionary::dataOffset(long index) const
+{
+    if (!isLoaded())
+        return 0;
+
+    return d->indexFile->dataOffset(index);
+}
+
+quint32
+Dictionary::dataSize(long index) const
+{
+    if (!isLoaded())
+        return 0;
+
+    return d->indexFile->dataSize(index);
+}
+
 WordEntry
 Dictionary::wordEntry(long index)
 {
-    if (d->indexFile.isNull())
+    if (!isLoaded())
         return WordEntry();
 
+    // The key may be a view into the index file, the entry keeps its own copy
+    QByteArray key = d->indexFile->key(index);
+
     WordEntry wordEntry;
-    wordEntry.setData(d->indexFile->key(index));
+    wordEntry.setData(QByteArray(key.constData(), key.size()));
     wordEntry.setDataOffset(d->indexFile->wordEntryOffset());
     wordEntry.setDataSize(d->indexFile->wordEntrySize());
 
+    QByteArray collationKey = d->indexFile->collationKey(index);
+    wordEntry.setCollationKey(QByteArray(collationKey.constData(), collationKey.size()));
+
     return wordEntry;
 }
 
+QByteArray
+Dictionary::collationKey(long index) const
+{
+    if (!isLoaded())
+        return QByteArray();
+
+    return d->indexFile->collationKey(index);
+}
+
 int
-Dictionary::lookup(const QString& word)
+Dictionary::lookup(const QString& word, int *nextIndex)
 {
-    if (d->indexFile.isNull())
+    if (!isLoaded())
+        return -1;
+
+    QByteArray utf8Word = word.toUtf8();
+    int index = d->indexFile->lookup(utf8Word, nextIndex);
+    if (index != -1 || d->synonymFile.isNull())
+        return index;
+
+    // The synonym entries point to the original word entry in the index file
+    int synonymIndex = d->synonymFile->lookup(utf8Word);
+    if (synonymIndex == -1)
         return -1;
 
-    return d->indexFile->lookup(word.toUtf8());
+    d->synonymFile->key(synonymIndex);
+    index = d->synonymFile->wordEntryOffset();
+
+    return index < articleCount() ? index : -1;
 }
 
 bool
 Dictionary::load(const QString& ifoFilePath)
 {
-    if (!loadIfoFile(ifoFilePath))
-        return false;
+    return loadIfoFile(ifoFilePath) && loadFiles();
+}
 
-    QString completeFilePath = ifoFilePath;
-    completeFilePath.replace(completeFilePath.length() - sizeof("ifo") + 1, sizeof("ifo") - 1, "dict.dz");
+bool
+Dictionary::loadFiles()
+{
+    if (isLoaded())
+        return true;
 
-    if (QFile(completeFilePath).exists())
+    d->failed.storeRelease(0);
+    if (!openFiles())
     {
-        DictionaryZip *dictionaryZip = compressedDictionaryFile();
-        if (!dictionaryZip)
-        {
-            delete dictionaryZip;
-            dictionaryZip = 0;
-        }
-
-        dictionaryZip = new DictionaryZip();
-        if (!dictionaryZip->open(completeFilePath, 0))
-        {
-            qDebug() << "Failed to open file:" << completeFilePath;
-            return false;
-        }
+        QMutexLocker loadLocker(&d->loadMutex);
+        d->failed.storeRelease(1);
+        d->loadCondition.wakeAll();
+        return false;
     }
-    else
-    {
-        completeFilePath.chop(sizeof(".dz"));
 
-        QFile *uncompressedDictionaryFile = dictionaryFile();
-        if (uncompressedDictionaryFile)
-        {
-            delete uncompressedDictionaryFile;
-            uncompressedDictionaryFile = 0;
-        }
+    // The size may have been set while the files were being opened
+    QMutexLocker locker(&d->pageCacheMutex);
+    d->applyPageCacheSize();
 
-        uncompressedDictionaryFile = new QFile(completeFilePath);
-        if( uncompressedDictionaryFile->open( QIODevice::ReadOnly ) )
-        {
-            qDebug() << "Failed to open file:" << completeFilePath;
-            return -1;
-        }
+    QMutexLocker loadLocker(&d->loadMutex);
+    d->loaded.storeRelease(1);
+    d->loadCondition.wakeAll();
+
+    return true;
+}
+
+bool
+Dictionary::openFiles()
+{
+    const QString ifoFilePath = d->dictionaryInfo.ifoFilePath();
+    if (ifoFilePath.isEmpty())
+        return false;
+
+    QString completeFilePath = ifoFilePath;
+    completeFilePath.replace(completeFilePath.length() - sizeof("ifo") + 1, sizeof("ifo") - 1, "dict");
+
+    AbstractDataFile *dataFile = openDataFile(completeFilePath);
+    if (!dataFile)
+    {
+        qDebug() << "Failed to open the data file:" << completeFilePath;
+        return false;
     }
 
+    setCompressedDictionaryFile(dataFile);
+
     completeFilePath = ifoFilePath;
     completeFilePath.replace(completeFilePath.length() - sizeof("ifo") + 1, sizeof("ifo") - 1, "idx.gz");
 
@@ -167,16 +364,123 @@ Dictionary::load(const QString& ifoFilePath)
     }
     else
     {
-        completeFilePath.chop(sizeof(".gz"));
+        completeFilePath.chop(sizeof(".gz") - 1);
         d->indexFile.reset(new OffsetCacheFile);
     }
 
+    d->indexFile->setProgressFunction(d->progressFunction);
+    d->indexFile->setIndexOffsetBits(d->dictionaryInfo.indexOffsetBits());
     if (!d->indexFile->load(completeFilePath))
         return false;
 
+    // The word entries are looked up by the word count of the ".ifo" file,
+    // which must not reach beyond the index
+    if (d->indexFile->wordCount() != articleCount())
+    {
+        qDebug() << "The word count of the ifo file does not match the index file:" << completeFilePath
+            << articleCount() << "!=" << d->indexFile->wordCount();
+        return false;
+    }
+
+    // Built before the dictionary is usable, as the index file cannot be
+    // read from two threads
+    if (!d->fuzzyIndex.load(completeFilePath))
+    {
+        d->fuzzyIndex.beginBuild();
+        for (int i = 0; i < articleCount(); ++i)
+            d->fuzzyIndex.addWord(QString::fromUtf8(d->indexFile->key(i)), i);
+
+        d->fuzzyIndex.endBuild();
+        d->fuzzyIndex.save(completeFilePath);
+    }
+
+    completeFilePath = ifoFilePath;
+    completeFilePath.replace(completeFilePath.length() - sizeof("ifo") + 1, sizeof("ifo") - 1, "syn");
+
+    d->synonymFile.reset();
+    if (QFile(completeFilePath).exists())
+    {
+        d->synonymFile.reset(new OffsetCacheFile);
+        d->synonymFile->setSynonymFile(true);
+        d->synonymFile->setProgressFunction(d->progressFunction);
+
+        // The dictionary is still usable without its synonyms
+        if (!d->synonymFile->load(completeFilePath))
+        {
+            qDebug() << "Failed to load the synonym file:" << completeFilePath;
+            d->synonymFile.reset();
+        }
+    }
+
     return true;
 }
 
+const FuzzyIndex *
+Dictionary::fuzzyIndex() const
+{
+    if (!isLoaded() || d->fuzzyIndex.isEmpty())
+        return 0;
+
+    return &d->fuzzyIndex;
+}
+
+bool
+Dictionary::isLoaded() const
+{
+    return d->loaded.loadAcquire() != 0;
+}
+
+bool
+Dictionary::hasLoadFailed() const
+{
+    return d->failed.loadAcquire() != 0;
+}
+
+bool
+Dictionary::waitForLoaded() const
+{
+    QMutexLocker locker(&d->loadMutex);
+    while (!isLoaded() && !hasLoadFailed())
+        d->loadCondition.wait(&d->loadMutex);
+
+    return isLoaded();
+}
+
+void
+Dictionary::setProgressFunction(AbstractIndexFile::progress_func_t progressFunction)
+{
+    d->progressFunction = progressFunction;
+}
+
+void
+Dictionary::setPageCacheSize(int pageCacheSize)
+{
+    QMutexLocker locker(&d->pageCacheMutex);
+    d->pageCacheSize = pageCacheSize;
+
+    // The files being loaded get the size when they are published
+    if (isLoaded())
+        d->applyPageCacheSize();
+}
+
+quint64
+Dictionary::pageCacheHitCount() const
+{
+    if (!isLoaded())
+        return 0;
+
+    return d->indexFile->pageCacheHitCount();
+}
+
+quint64
+Dictionary::pageCacheMissCount() const
+{
+    if (!isLoaded())
+        return 0;
+
+    return d->indexFile->pageCacheMissCount();
+}
+
 bool
 Dictionary::loadIfoFile(const QString& ifoFilePath)
 {
@@ -193,18 +497,160 @@ Dictionary::loadIfoFile(const QString& ifoFilePath)
 
 QVector<int>
 Dictionary::lookupPattern(const QString& pattern, int maximumIndexListSize)
+{
+    if (!isLoaded())
+        return QVector<int>();
+
+    return lookupPattern(pattern, maximumIndexListSize, 0, articleCount());
+}
+
+QVector<int>
+Dictionary::lookupPattern(const QString& pattern, int maximumIndexListSize, long first, long last)
 {
     QVector<int> indexList;
+    if (!isLoaded())
+        return indexList;
 
-    QRegExp rx(pattern);
-    rx.setPatternSyntax(QRegExp::Wildcard);
+    first = qMax<long>(first, 0);
+    last = qMin<long>(last, articleCount());
 
-    for (int i = 0; i < articleCount() && indexList.size() < maximumIndexListSize - 1; ++i)
+    WildcardPattern wildcardPattern(pattern);
+    if (!wildcardPattern.isValid())
     {
-        if (rx.exactMatch(key(i)))
+        // The character sets and the very long patterns are left to QRegExp
+        QRegExp rx(pattern);
+        rx.setPatternSyntax(QRegExp::Wildcard);
+
+        for (long i = first; i < last && indexList.size() < maximumIndexListSize - 1; ++i)
+        {
+            if (rx.exactMatch(QString::fromUtf8(d->indexFile->keyData(i))))
+                indexList.append(i);
+        }
+
+        return indexList;
+    }
+
+    // The words starting with the ascii part of the literal prefix are
+    // contiguous in the sorted index. StarDict only ignores the case of the
+    // ascii letters when sorting, so the rest of the prefix is left to the
+    // automaton.
+    QByteArray literalPrefix = wildcardPattern.literalPrefix();
+    int asciiPrefixLength = 0;
+    while (asciiPrefixLength < literalPrefix.size() && uchar(literalPrefix.at(asciiPrefixLength)) < 0x80)
+        ++asciiPrefixLength;
+
+    literalPrefix.truncate(asciiPrefixLength);
+
+    if (!literalPrefix.isEmpty())
+    {
+        first = d->prefixBound(literalPrefix, first, last, false);
+        last = d->prefixBound(literalPrefix, first, last, true);
+    }
+    else
+    {
+        QVector<quint32> candidates;
+        NgramIndex *ngramIndex = d->ngramIndex.loadAcquire();
+        if (ngramIndex && ngramIndex->candidates(wildcardPattern.literals(), first, last, &candidates))
+        {
+            foreach (quint32 candidate, candidates)
+            {
+                if (indexList.size() >= maximumIndexListSize - 1)
+                    break;
+
+                if (wildcardPattern.exactMatch(d->indexFile->keyData(candidate)))
+                    indexList.append(candidate);
+            }
+
+            return indexList;
+        }
+    }
+
+    for (long i = first; i < last && indexList.size() < maximumIndexListSize - 1; ++i)
+    {
+        if (wildcardPattern.exactMatch(d->indexFile->keyData(i)))
             indexList.append(i);
     }
 
     return indexList;
 }
 
+bool
+Dictionary::buildNgramIndex()
+{
+    if (!isLoaded())
+        return false;
+
+    if (d->ngramIndex.loadAcquire())
+        return true;
+
+    // The lookups fall back to checking every word entry without it
+    NgramIndex *ngramIndex = new NgramIndex;
+    if (!ngramIndex->build(d->indexFile.data(), articleCount()))
+    {
+        qDebug() << "The trigram index exceeds its memory budget:" << ifoFilePath();
+        delete ngramIndex;
+        return false;
+    }
+
+    if (!d->ngramIndex.testAndSetOrdered(0, ngramIndex))
+        delete ngramIndex;
+
+    return true;
+}
+
+QVector<FuzzyIndex::Match>
+Dictionary::lookupSimilar(const QString& word, int limit, int maximumCount, long first, long last)
+{
+    if (!isLoaded() || word.isEmpty() || maximumCount <= 0)
+        return QVector<FuzzyIndex::Match>();
+
+    // The words are measured in batches, which the SSE2 kernel of
+    // EditDistance scores at once
+    EditDistance editDistance;
+    QString candidateWords[EditDistance::batchSize];
+    QString lowerCandidateWords[EditDistance::batchSize];
+    long candidateIndexes[EditDistance::batchSize];
+    int candidateDistances[EditDistance::batchSize];
+    int candidateCount = 0;
+
+    // The distance limit tightens as the heap fills up with closer matches
+    MatchHeap matchHeap(maximumCount, limit);
+
+    last = qMin<long>(last, articleCount());
+    for (long i = qMax<long>(first, 0); i <= last; ++i)
+    {
+        if (i < last)
+        {
+            // skip too long or too short words
+            QString candidateWord = QString::fromUtf8(d->indexFile->keyData(i));
+            if (qAbs(candidateWord.length() - word.length()) >= matchHeap.limit())
+                continue;
+
+            candidateWords[candidateCount] = candidateWord;
+            lowerCandidateWords[candidateCount] = candidateWord.toLower();
+            candidateIndexes[candidateCount] = i;
+            if (++candidateCount < EditDistance::batchSize)
+                continue;
+        }
+
+        // The batch is measured against the limit from before the batch,
+        // the heap checks the matches against the current one
+        editDistance.calEditDistances(word, lowerCandidateWords, candidateCount, matchHeap.limit(), candidateDistances);
+
+        for (int candidate = 0; candidate < candidateCount; ++candidate)
+        {
+            int distance = candidateDistances[candidate];
+
+            // when the word has one or two characters we need less fuzzy.
+            if (distance >= word.length())
+                continue;
+
+            matchHeap.insert(candidateIndexes[candidate], distance, candidateWords[candidate]);
+        }
+
+        candidateCount = 0;
+    }
+
+    return matchHeap.matches();
+}
+
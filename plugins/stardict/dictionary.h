@@ -22,6 +22,8 @@
 
 #include "abstractdictionary.h"
 
+#include "abstractindexfile.h"
+#include "fuzzyindex.h"
 #include "wordentry.h"
 
 #include <QtCore/QString>
@@ -45,15 +47,93 @@ namespace MulaPluginStarDict
             virtual ~Dictionary();
 
             /**
-             * Loads the ".ifo" file
+             * Loads the ".ifo" file, and then the data, index and synonym
+             * files of the dictionary
              *
              * @param ifoFilePath Path of the ".ifo" file
              *
              * @return True if the loading was successful, otherwise false.
+             *
+             * @see loadIfoFile, loadFiles
              */
 
             bool load(const QString& ifoFilePath);
 
+            /**
+             * Loads the ".ifo" file while marking the dictionary non-tree one
+             *
+             * \note The ".ifo" file is small, so this method is cheap. The
+             * name and the article count of the dictionary are available
+             * afterwards, but the words are not until loadFiles() finishes.
+             *
+             * @param ifoFilePath Path of the ".ifo" file
+             *
+             * @return True if the loading was successful, otherwise false.
+             *
+             * @see load, loadFiles, ifoFilePath
+             */
+
+            bool loadIfoFile(const QString& ifoFilePath);
+
+            /**
+             * Loads the data, index and synonym files of the dictionary whose
+             * ".ifo" file has already been loaded by loadIfoFile()
+             *
+             * \note This is the expensive part of the loading, so it may be
+             * run in a worker thread. The other methods must not be called
+             * meanwhile, except the ones that do not need the files: see
+             * isLoaded().
+             *
+             * @return True if the loading was successful, otherwise false.
+             *
+             * @see load, loadIfoFile, isLoaded
+             */
+
+            bool loadFiles();
+
+            /**
+             * Returns whether or not the files of the dictionary have been
+             * loaded successfully
+             *
+             * \note This method is safe to call from any thread. Until it
+             * returns true, only articleCount(), dictionaryName(),
+             * ifoFilePath() and this method may be used while the files are
+             * being loaded in another thread.
+             *
+             * @return True if the files are loaded, otherwise false
+             *
+             * @see loadFiles
+             */
+
+            bool isLoaded() const;
+
+            /**
+             * Returns whether or not the last loadFiles() call failed
+             *
+             * \note This method is safe to call from any thread.
+             *
+             * @return True if the files could not be loaded, otherwise false
+             *
+             * @see loadFiles, isLoaded
+             */
+
+            bool hasLoadFailed() const;
+
+            /**
+             * Blocks until the pending or running loadFiles() call has
+             * finished, whether it succeeded or not
+             *
+             * \note This method is safe to call from any thread, but only once
+             * loadFiles() has been called or scheduled, otherwise it never
+             * returns.
+             *
+             * @return True if the files are loaded, otherwise false
+             *
+             * @see loadFiles, isLoaded, hasLoadFailed
+             */
+
+            bool waitForLoaded() const;
+
             /**
              * Returns the count of the word entries in the ".idx" file.
              *
@@ -97,6 +177,22 @@ namespace MulaPluginStarDict
 
             QString key(long index) const;
 
+            /**
+             * Returns the collation key of the word data according to the
+             * relevant index as returned by stardictCollationKey()
+             *
+             * \note If the index file is not loaded properly yet, this method
+             * returns an empty byte array.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return  The collation key of the desired word data
+             *
+             * @see key
+             */
+
+            QByteArray collationKey(long index) const;
+
             /**
              * Returns the desired word data of the dictionary with all its
              * fields
@@ -115,6 +211,72 @@ namespace MulaPluginStarDict
 
             QString data(long index);
 
+            /**
+             * Returns a view of the typed sections of the word data, which the
+             * callers can go through without the whole article being rebuilt
+             * or copied
+             *
+             * \note If the index file is not loaded properly yet, this method
+             * returns a null view.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return The view of the word data
+             *
+             * @see data, AbstractDictionary::articleView
+             */
+
+            ArticleView articleView(long index);
+
+            /**
+             * Brings the word entry and its word data into memory ahead of a
+             * later key() and data() call. The index file is touched, and the
+             * data is decoded into the ChunkCache, or paged in if the data
+             * file is not compressed.
+             *
+             * \note Unlike key() and data(), this method is safe to call from
+             * a background thread while the dictionary is used.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return The size of the prefetched word data
+             *
+             * @see Prefetcher
+             */
+
+            qint64 prefetch(long index);
+
+            /**
+             * Returns the offset of the word data in the uncompressed data
+             * file, without looking up the key
+             *
+             * \note Like prefetch(), this method is safe to call from any
+             * thread. It returns 0 if the index file is not loaded yet.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return The offset of the word data
+             *
+             * @see dataSize, ArticleIterator
+             */
+
+            quint64 dataOffset(long index) const;
+
+            /**
+             * Returns the size of the word data, without looking up the key
+             *
+             * \note Like prefetch(), this method is safe to call from any
+             * thread. It returns 0 if the index file is not loaded yet.
+             *
+             * @param   index   The index of the desired word
+             *
+             * @return The size of the word data
+             *
+             * @see dataOffset, ArticleIterator
+             */
+
+            quint32 dataSize(long index) const;
+
             /**
              * Returns the word entry according to the desired index value
              *
@@ -131,15 +293,20 @@ namespace MulaPluginStarDict
             WordEntry wordEntry(long index);
 
             /**
-             * Returns the index of the word data where it has been found.
+             * Returns the index of the word data where it has been found. If
+             * the word is not in the index file, but the dictionary has a
+             * ".syn" synonym file with the word, the index of the original
+             * word entry is returned.
              *
-             * @param   word    The word data to look up
+             * @param   word        The word data to look up
+             * @param   nextIndex   If not NULL, it is set to the index of the
+             * first word entry not less than the desired word
              *
              * @return The index where the desired word occurs among the word
              * entries, or -1 if there is no such a word.
              */
 
-            int lookup(const QString& word);
+            int lookup(const QString& word, int *nextIndex = 0);
 
             /**
              * Returns the list of indices matched against the desired word data
@@ -157,20 +324,134 @@ namespace MulaPluginStarDict
 
             QVector<int> lookupPattern(const QString& pattern, int maximumIndexListSize);
 
-        private:
             /**
-             * Loads the ".ifo" file while marking the dictionary non-tree one
+             * Returns the indices of the words matching the pattern in the
+             * given range of the word entries, for the scans split into
+             * several ranges
              *
-             * \note This method is only for internal usage.
+             * The pattern is compiled into a WildcardPattern, which matches
+             * the utf-8 encoded words as they are. If the pattern starts with
+             * a literal text, only the words starting with it are checked,
+             * which are found by binary search. Otherwise the words are
+             * filtered by the trigrams of the literal texts of the pattern,
+             * see NgramIndex, once buildNgramIndex() has built it.
              *
-             * @param ifoFilePath Path of the ".ifo" file
+             * \note Unlike the other overload, this method may be called from
+             * several threads at once, see AbstractIndexFile::keyData().
              *
-             * @return True if the loading was successful, otherwise false.
+             * @param   pattern                 The pattern to look up
+             * @param   maximumIndexListSize    The maximum index list count for
+             * returning, one more than the number of the returned indices
+             * @param   first                   The first word entry to check
+             * @param   last                    The word entry after the last
+             * one to check
              *
-             * @see load, ifoFilePath
+             * @return The indices in ascending order
              */
 
-            bool loadIfoFile(const QString& ifoFilePath);
+            QVector<int> lookupPattern(const QString& pattern, int maximumIndexListSize, long first, long last);
+
+            /**
+             * Builds the trigram index of the pattern lookups starting with a
+             * wildcard, see NgramIndex
+             *
+             * \note It takes a while on large dictionaries, thus the manager
+             * runs it in the background once the dictionary is loaded, and
+             * the pattern lookups check every word entry until it is done. It
+             * may be called from any thread once the files are loaded.
+             *
+             * @return True if the index is built, false if the files are not
+             * loaded or the index would exceed its memory budget
+             *
+             * @see lookupPattern
+             */
+
+            bool buildNgramIndex();
+
+            /**
+             * Measures the edit distance of the words in the given range of
+             * the word entries from the given word, for the similar word
+             * lookups of the dictionaries without a fuzzy index. Only the
+             * distances below the limit and the length of the word are
+             * accepted, and the closest maximumCount words are kept, the
+             * earlier word entry winning among the equally distant ones.
+             *
+             * \note This method may be called from several threads at once,
+             * see AbstractIndexFile::keyData().
+             *
+             * @param   word            The lowercase looked up word
+             * @param   limit           The exclusive limit of the distance
+             * @param   maximumCount    The maximum number of the matches
+             * @param   first           The first word entry to check
+             * @param   last            The word entry after the last one to
+             * check
+             *
+             * @return The matches ordered by their distance and index
+             *
+             * @see fuzzyIndex, FuzzyIndex::lookup
+             */
+
+            QVector<FuzzyIndex::Match> lookupSimilar(const QString& word, int limit, int maximumCount, long first, long last);
+
+            /**
+             * Returns the BK-tree of the headwords for the similar word
+             * lookups, which is built or loaded together with the index file
+             *
+             * @return The fuzzy index, or NULL if the dictionary is not loaded
+             * or the index could not be built
+             *
+             * @see FuzzyIndex
+             */
+
+            const FuzzyIndex *fuzzyIndex() const;
+
+            /**
+             * Sets the function called regularly while the index file is
+             * being loaded
+             *
+             * @param   progressFunction    The progress function, or NULL
+             */
+
+            void setProgressFunction(AbstractIndexFile::progress_func_t progressFunction);
+
+            /**
+             * Sets the maximum number of the index pages kept in memory if the
+             * index file cannot be mapped
+             *
+             * \note It may be called while the files are loaded in the
+             * background, they get the size once they are usable.
+             *
+             * @param   pageCacheSize   The maximum number of the cached pages,
+             * or 0 for the default
+             *
+             * @see AbstractIndexFile::setPageCacheSize
+             */
+
+            void setPageCacheSize(int pageCacheSize);
+
+            /**
+             * Returns the number of the page cache hits of the index file
+             *
+             * @return  The number of the page cache hits
+             *
+             * @see pageCacheMissCount
+             */
+
+            quint64 pageCacheHitCount() const;
+
+            /**
+             * Returns the number of the page cache misses of the index file
+             *
+             * @return  The number of the page cache misses
+             *
+             * @see pageCacheHitCount
+             */
+
+            quint64 pageCacheMissCount() const;
+
+        private:
+            // Opens the files for loadFiles()
+            bool openFiles();
 
             class Private;
             Private *const d;
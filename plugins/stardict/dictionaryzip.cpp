@@ -19,7 +19,7 @@
 
 #include "dictionaryzip.h"
 
-#include "dictionarycache.h"
+#include "mappedfile.h"
 
 #include <QtCore/QtGlobal>
 
@@ -27,26 +27,23 @@
 #include <QtCore/QString>
 #include <QtCore/QFileInfo>
 #include <QtCore/QDateTime>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 
 #include <zlib.h>
 
 #include <sys/stat.h>
+#include <string.h>
 
 using namespace MulaPluginStarDict;
 
-#define USE_CACHE 1
-
 #define BUFFERSIZE 10240
 
-/*
- * Output buffer must be greater than or
- * equal to 110% of input buffer size, plus
- * 12 bytes.
-*/
-#define OUT_BUFFER_SIZE 0xffffL
-
-#define IN_BUFFER_SIZE ((unsigned long)((double)(OUT_BUFFER_SIZE - 12) * 0.89))
-
 /* For gzip-compatible header, as defined in RFC 1952 */
 
 /* Magic for GZIP (rfc1952)                */
@@ -116,15 +113,179 @@ enum DictionaryFormat {
     DICTIONARY_DZIP       = 3,
 };
 
+// The multi-byte fields of the gzip header are little endian
+static bool
+readLittleEndian(QFile& file, int byteCount, quint32 *value)
+{
+    uchar byte;
+
+    *value = 0;
+    for (int i = 0; i < byteCount; ++i)
+    {
+        if (file.read(reinterpret_cast<char*>(&byte), 1) != 1)
+        {
+            qWarning() << "Invalid ZIP file. Unexpected end of file.";
+            return false;
+        }
+
+        *value |= quint32(byte) << i*8;
+    }
+
+    return true;
+}
+
+// Inflates one chunk with the given stream, which must be initialized or
+// reset, and returns the number of the inflated bytes, or -1 on error
+static int
+inflateChunk(z_stream *zStream, const uchar *input, uInt inputSize, char *output, uInt outputSize)
+{
+    zStream->next_in = const_cast<Bytef *>(input);
+    zStream->avail_in = inputSize;
+    zStream->next_out = reinterpret_cast<Bytef *>(output);
+    zStream->avail_out = outputSize;
+
+    int status = inflate( zStream, Z_PARTIAL_FLUSH );
+    if (status != Z_OK && status != Z_STREAM_END)
+    {
+        qWarning() << Q_FUNC_INFO << QString("inflate: %1").arg(zStream->msg);
+        return -1;
+    }
+
+    if (zStream->avail_in)
+    {
+        qWarning() << Q_FUNC_INFO << QString("inflate did not flush (%1 pending, %2 avail)").arg(zStream->avail_in).arg(zStream->avail_out);
+    }
+
+    return outputSize - zStream->avail_out;
+}
+
+namespace
+{
+    // Keeps the idle inflate states of all the readers, so the chunks are
+    // inflated concurrently without allocating a new state for each of them
+    class InflaterPool
+    {
+        public:
+            InflaterPool()
+                : m_maximumIdleCount(2 * QThread::idealThreadCount())
+            {
+            }
+
+            ~InflaterPool()
+            {
+                foreach (z_stream *zStream, m_idleStreams)
+                {
+                    inflateEnd( zStream );
+                    delete zStream;
+                }
+            }
+
+            // Returns a state ready for inflating a new chunk, or NULL
+            z_stream *acquire()
+            {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    if (!m_idleStreams.isEmpty())
+                        return m_idleStreams.takeLast();
+                }
+
+                z_stream *zStream = new z_stream;
+                zStream->zalloc = NULL;
+                zStream->zfree = NULL;
+                zStream->opaque = NULL;
+                zStream->next_in = 0;
+                zStream->avail_in = 0;
+
+                if (inflateInit2( zStream, -15 ) != Z_OK)
+                {
+                    qWarning() << Q_FUNC_INFO << QString("Cannot initialize inflation engine: %1").arg(zStream->msg);
+                    delete zStream;
+                    return NULL;
+                }
+
+                return zStream;
+            }
+
+            void release(z_stream *zStream)
+            {
+                // Every chunk starts at a full flush point, so it can be
+                // inflated without the preceding ones
+                inflateReset( zStream );
+
+                {
+                    QMutexLocker locker(&m_mutex);
+                    if (m_idleStreams.size() < m_maximumIdleCount)
+                    {
+                        m_idleStreams.append(zStream);
+                        return;
+                    }
+                }
+
+                inflateEnd( zStream );
+                delete zStream;
+            }
+
+        private:
+            QMutex m_mutex;
+            QList<z_stream *> m_idleStreams;
+            int m_maximumIdleCount;
+    };
+}
+
+Q_GLOBAL_STATIC(InflaterPool, inflaterPool)
+
+namespace
+{
+    // Inflates a whole chunk of a large read straight into its place in the
+    // output buffer, with an inflate state taken from the pool
+    class ChunkInflater : public QRunnable
+    {
+        public:
+            ChunkInflater(const uchar *input, uInt inputSize, char *output, uInt outputSize,
+                          QSemaphore *finished, QAtomicInt *failed)
+                : m_input(input)
+                , m_inputSize(inputSize)
+                , m_output(output)
+                , m_outputSize(outputSize)
+                , m_finished(finished)
+                , m_failed(failed)
+            {
+            }
+
+            void run()
+            {
+                z_stream *zStream = inflaterPool()->acquire();
+                if (!zStream)
+                {
+                    m_failed->storeRelease(1);
+                }
+                else
+                {
+                    // The chunks in the middle of the read must be complete
+                    if (inflateChunk(zStream, m_input, m_inputSize, m_output, m_outputSize) != int(m_outputSize))
+                        m_failed->storeRelease(1);
+
+                    inflaterPool()->release(zStream);
+                }
+
+                m_finished->release();
+            }
+
+        private:
+            const uchar *m_input;
+            uInt m_inputSize;
+            char *m_output;
+            uInt m_outputSize;
+            QSemaphore *m_finished;
+            QAtomicInt *m_failed;
+    };
+}
+
 class DictionaryZip::Private
 {
     public:
         Private()
-            : start(0)
-            , end(0)
-            , size(0)
-            , type(DICTIONARY_UNKNOWN)
-            , initialized(0)
+            : type(DICTIONARY_UNKNOWN)
             , headerLength(GZ_XLEN - 1)
             , extraLength(0)
             , subLength(0)
@@ -147,13 +308,10 @@ class DictionaryZip::Private
         {
         }
 
-        unsigned char *start;	    /* start of mmap'd area */
-        unsigned char *end;	    /* end of mmap'd area */
-        unsigned long size;		        /* size of mmap */
+        // Reads spanning at least that many chunks are inflated in parallel
+        static const int parallelChunkCount = 4;
 
         int type;
-        z_stream zStream;
-        int initialized;
 
         int headerLength;
         int extraLength;
@@ -167,16 +325,13 @@ class DictionaryZip::Private
         int chunkLength;
         int chunkCount;
         int *chunks;
-        unsigned long *offsets;	/* Sum-scan of chunks. */
+        quint64 *offsets;	/* Sum-scan of chunks. */
         QString originalFileName;
         QString comment;
         unsigned long crc;
         unsigned long originalLength;
         unsigned long compressedLength;
-        QList<DictionaryCache> cache;
-        QFile mapFile;
-
-        static const int dictionaryCacheSize = 5;
+        MappedFile dataFile;
 };
 
 DictionaryZip::DictionaryZip()
@@ -187,6 +342,7 @@ DictionaryZip::DictionaryZip()
 DictionaryZip::~DictionaryZip()
 {
     close();
+    delete d;
 }
 
 int
@@ -200,7 +356,7 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
     int i;
     unsigned long crc = crc32( 0L, Z_NULL, 0 );
     int count;
-    unsigned long offset;
+    quint64 offset;
 
     QFile file(fileName);
     if( !file.open( QIODevice::ReadOnly ) )
@@ -249,16 +405,10 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
         return -1;
     }
 
-    time_t mtime = 0;
-    char chtime;
-    for(int i = 0; i < 4; ++i) {
-        if (file.read( &chtime, 1 ) < 0) {
-            qWarning() << "Invalid ZIP file. Unexpected end of file.";
-            return -1;
-        } else {
-            mtime |= chtime << i*8;
-        }
-    }
+    quint32 mtime;
+    if (!readLittleEndian(file, 4, &mtime))
+        return -1;
+
     d->mtime.setTime_t(mtime);
 
     if (file.read( &d->extraFlags, 1 ) < 0) {
@@ -273,18 +423,12 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
 
     if (d->flags & GZ_FEXTRA)
     {
-        d->extraLength = 0;
-        char extraLength;
-        for(int i = 0; i < 2; ++i) {
-            if (file.read( &extraLength, 1 ) < 0) {
-                qWarning() << "Invalid ZIP file. Unexpected end of file.";
-                return -1;
-            } else {
-                d->extraLength |= extraLength << i*8;
-            }
-        }
+        quint32 extraLength;
+        if (!readLittleEndian(file, 2, &extraLength))
+            return -1;
 
-        d->headerLength += extraLength + 2;
+        d->extraLength = extraLength;
+        d->headerLength += d->extraLength + 2;
 
         if (file.read( &si1, 1 ) < 0) {
             qWarning() << "Invalid ZIP file. Unexpected end of file.";
@@ -296,58 +440,38 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
             return -1;
         }
 
-        if (uchar(si1) == GZ_RND_S1 || uchar(si2) == GZ_RND_S2)
+        if (uchar(si1) == GZ_RND_S1 && uchar(si2) == GZ_RND_S2)
         {
-            d->subLength = 0;
-            char subLength;
-            for(int i = 0; i < 2; ++i) {
-                if (file.read( &subLength, 1 ) < 0) {
-                    qWarning() << "Invalid ZIP file. Unexpected end of file.";
-                    return -1;
-                } else {
-                    d->subLength |= subLength << i*8;
-                }
-            }
+            quint32 subLength;
+            if (!readLittleEndian(file, 2, &subLength))
+                return -1;
 
-            d->version = 0;
-            char version;
-            for(int i = 0; i < 2; ++i) {
-                if (file.read( &version, 1 ) < 0) {
-                    qWarning() << "Invalid ZIP file. Unexpected end of file.";
-                    return -1;
-                } else {
-                    d->version |= version << i*8;
-                }
-            }
+            d->subLength = subLength;
+
+            quint32 version;
+            if (!readLittleEndian(file, 2, &version))
+                return -1;
+
+            d->version = version;
 
             if (d->version != 1)
             {
                 qDebug() << Q_FUNC_INFO << QString("dzip header version %1 not supported").arg(d->version);
             }
 
-            d->chunkLength = 0;
-            char chunkLength;
-            for(int i = 0; i < 2; ++i) {
-                if (file.read( &chunkLength, 1 ) < 0) {
-                    qWarning() << "Invalid ZIP file. Unexpected end of file.";
-                    return -1;
-                } else {
-                    d->chunkLength |= chunkLength << i*8;
-                }
-            }
+            quint32 chunkLength;
+            if (!readLittleEndian(file, 2, &chunkLength))
+                return -1;
 
-            d->chunkCount = 0;
-            char chunkCount;
-            for(int i = 0; i < 2; ++i) {
-                if (file.read( &chunkCount, 1 ) < 0) {
-                    qWarning() << "Invalid ZIP file. Unexpected end of file.";
-                    return -1;
-                } else {
-                    d->chunkCount |= chunkCount << i*8;
-                }
-            }
+            d->chunkLength = chunkLength;
+
+            quint32 chunkCount;
+            if (!readLittleEndian(file, 2, &chunkCount))
+                return -1;
 
-            if (d->chunkCount <= 0)
+            d->chunkCount = chunkCount;
+
+            if (d->chunkCount <= 0 || d->chunkLength <= 0)
             {
                 file.close();
                 return 5; // TODO: const or enum value for this ?
@@ -355,31 +479,27 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
 
             d->chunks = (int *)malloc(sizeof( d->chunks[0] ) * d->chunkCount );
 
-            char chunk;
+            quint32 chunk;
             for (int j = 0; j < d->chunkCount; ++j)
             {
-                d->chunks[j] = 0;
-                for(int i = 0; i < 2; ++i) {
-                    if (file.read( &chunk, 1 ) < 0) {
-                        qWarning() << "Invalid ZIP file. Unexpected end of file.";
-                        return -1;
-                    } else {
-                        d->chunks[j] |= chunk << i*8;
-                    }
-                }
+                if (!readLittleEndian(file, 2, &chunk))
+                    return -1;
+
+                d->chunks[j] = chunk;
             }
             d->type = DICTIONARY_DZIP;
         }
         else
         {
-            file.seek(d->headerLength);
+            file.seek(d->headerLength + 1);
         }
     }
 
     if (d->flags & GZ_FNAME)
     { /* FIXME! Add checking against header len */
         int i = 0;
-        while (file.read(&buffer[i++], 1) && !file.atEnd());
+        while (i < BUFFERSIZE - 1 && file.read(&buffer[i], 1) == 1 && buffer[i] != '\0')
+            ++i;
         buffer[i] = '\0';
 
         d->originalFileName = buffer;
@@ -393,7 +513,8 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
     if (d->flags & GZ_COMMENT)
     { /* FIXME! Add checking for header len */
         int i = 0;
-        while (file.read(&buffer[i++], 1) && !file.atEnd());
+        while (i < BUFFERSIZE - 1 && file.read(&buffer[i], 1) == 1 && buffer[i] != '\0')
+            ++i;
         buffer[i] = '\0';
         d->comment = buffer;
         d->headerLength += d->comment.length() + 1;
@@ -416,32 +537,23 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
 
     file.seek(file.size() - 8);
 
-    d->crc = 0;
-    char chcrc;
-    for(int i = 0; i < 4; ++i) {
-        if (file.read(&chcrc, 1 ) < 0) {
-            qWarning() << "Invalid ZIP file. Unexpected end of file.";
-            return -1;
-        } else {
-            d->crc |= chcrc << i*8;
-        }
-    }
+    quint32 trailerCrc;
+    if (!readLittleEndian(file, 4, &trailerCrc))
+        return -1;
 
-    d->originalLength = 0;
-    char length;
-    for(int i = 0; i < 4; ++i) {
-        if (file.read( &length, 1 ) < 0) {
-            qWarning() << "Invalid ZIP file. Unexpected end of file.";
-            return -1;
-        } else {
-            d->originalLength |= length << i*8;
-        }
-    }
+    d->crc = trailerCrc;
+
+    // The length modulo 2^32 as stored in the gzip trailer
+    quint32 originalLength;
+    if (!readLittleEndian(file, 4, &originalLength))
+        return -1;
+
+    d->originalLength = originalLength;
 
     d->compressedLength = file.pos();
 
     /* Compute offsets */
-    d->offsets = (unsigned long *)malloc( sizeof( d->offsets[0] ) * d->chunkCount );
+    d->offsets = (quint64 *)malloc( sizeof( d->offsets[0] ) * d->chunkCount );
 
     for (offset = d->headerLength + 1, i = 0; i < d->chunkCount; ++i)
     {
@@ -454,10 +566,14 @@ DictionaryZip::readHeader(const QString &fileName, int computeCRC)
 }
 
 bool
-DictionaryZip::open(const QString& fileName, int computeCRC)
+DictionaryZip::open(const QString& fileName)
 {
-    d->initialized = 0;
+    return open(fileName, 0);
+}
 
+bool
+DictionaryZip::open(const QString& fileName, int computeCRC)
+{
     if (!QFileInfo(fileName).isFile())
     {
         qDebug() << Q_FUNC_INFO << QString("%1 is not a regular file -- ignoring").arg(fileName);
@@ -470,89 +586,47 @@ DictionaryZip::open(const QString& fileName, int computeCRC)
         return false;
     }
 
-    QFile file(fileName);
-    if( !file.open( QIODevice::ReadOnly ) )
-    {
-        qDebug() << "Failed to open file:" << fileName;
-        return -1;
-    }
-
-    d->size = file.size();
-
-    d->mapFile.setFileName(fileName);
-    if( !d->mapFile.open( QIODevice::ReadOnly ) )
-    {
-        qDebug() << "Failed to open file:" << fileName;
-        return -1;
-    }
-
-    uchar *data = d->mapFile.map(0, d->size);
-    if (data == NULL)
+    if (d->type == DICTIONARY_GZIP)
     {
-        qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(fileName);
+        qDebug() << Q_FUNC_INFO << QString("\"%1\" has no dzip chunk table").arg(fileName);
         return false;
     }
 
-    d->start = data;
-    d->end = d->start + d->size;
-
-    for (int j = 0; j < d->dictionaryCacheSize; ++j)
+    if (d->type == DICTIONARY_TEXT)
     {
-        DictionaryCache dictionaryCache;
-        dictionaryCache.setChunk(-1);
-        dictionaryCache.setStamp(-1);
-        dictionaryCache.setByteArray(NULL);
-        dictionaryCache.setCount(0);
-
-        d->cache.append(dictionaryCache);
+        qDebug() << Q_FUNC_INFO << QString("\"%1\" is not compressed").arg(fileName);
+        return false;
     }
 
-    return true;
+    return d->dataFile.open(fileName);
 }
 
 void
 DictionaryZip::close()
 {
     if (d->chunks)
+    {
         ::free(d->chunks);
+        d->chunks = 0;
+    }
 
     if (d->offsets)
-        ::free(d->offsets);
-
-    if (d->initialized)
     {
-        if (inflateEnd( &d->zStream ))
-        {
-            qDebug() << Q_FUNC_INFO << QString("Cannot shut down inflation engine: %1").arg(d->zStream.msg);
-        }
+        ::free(d->offsets);
+        d->offsets = 0;
     }
 
-    /* for (int i = 0; i < DICTIONARY_CACHE_SIZE; ++i)
-    {
-        if (d->cache[i].inBuffer)
-            ::free(d->cache[i].inBuffer);
-    } */
+    removeCachedChunks();
+
+    d->dataFile.close();
 }
 
 QByteArray
-DictionaryZip::read(unsigned long start, unsigned long size)
+DictionaryZip::read(quint64 start, unsigned long size, QByteArray *chunk)
 {
-    unsigned long end;
-    int count;
-    QByteArray inByteArray;
-    QByteArray outByteArray;
-    int firstChunk;
-    int lastChunk;
-    int firstOffset;
-    int lastOffset;
-    int found;
-    int target;
-    int lastStamp;
-    static int stamp = 0;
+    quint64 end = start + size;
     QByteArray resultString;
 
-    end = start + size;
-
     switch (d->type)
     {
     case DICTIONARY_GZIP:
@@ -560,131 +634,143 @@ DictionaryZip::read(unsigned long start, unsigned long size)
         qWarning() << "Use plain text (for performance) or dzip format (for space savings).";
         break;
 
-    case DICTIONARY_TEXT:
-        resultString = QByteArray::fromRawData(reinterpret_cast<char*>(d->start), size);
-        break;
-
     case DICTIONARY_DZIP:
-        if (!d->initialized)
+    {
+        if (size == 0)
+            break;
+
+        int firstChunk = start / d->chunkLength;
+        int lastChunk = (end - 1) / d->chunkLength;
+
+        if (lastChunk >= d->chunkCount || lastChunk - firstChunk + 1 < d->parallelChunkCount)
+            return readChunks(start, size, chunk);
+
+        // The chunks in the middle of a large read are independent of each
+        // other, so they are inflated by the pool straight into their place
+        // in the result, or by this thread if the pool is full. They are not
+        // cached, so that one long article does not flush the hot chunks out
+        // of the ChunkCache. The first and the last chunks are usually shared
+        // with the neighbouring articles, so they are read through the cache
+        // meanwhile.
+        quint64 inputStart = d->offsets[firstChunk + 1];
+        quint64 inputSize = d->offsets[lastChunk - 1] + d->chunks[lastChunk - 1] - inputStart;
+        QByteArray input = d->dataFile.read(inputStart, inputSize);
+        if (quint64(input.size()) != inputSize)
         {
-            ++d->initialized;
-            d->zStream.zalloc = NULL;
-            d->zStream.zfree = NULL;
-            d->zStream.opaque = NULL;
-            d->zStream.next_in = 0;
-            d->zStream.avail_in = 0;
-            d->zStream.next_out = NULL;
-            d->zStream.avail_out = 0;
-
-            if (inflateInit2( &d->zStream, -15 ) != Z_OK)
-            {
-                qWarning() << Q_FUNC_INFO << QString("Cannot initialize inflation engine: %1").arg(d->zStream.msg);
-            }
+            qWarning() << Q_FUNC_INFO << QString("Chunks %1 to %2 are beyond the end of the file").arg(firstChunk + 1).arg(lastChunk - 1);
+            break;
         }
 
-        firstChunk = start / d->chunkLength;
-        firstOffset = start - firstChunk * d->chunkLength;
-        lastChunk = end / d->chunkLength;
-        lastOffset = end - lastChunk * d->chunkLength;
-        //PRINTF(DBG_UNZIP,
-        // ("   start = %lu, end = %lu\n"
-        //"firstChunk = %d, firstOffset = %d,"
-        //" lastChunk = %d, lastOffset = %d\n",
-        //start, end, firstChunk, firstOffset, lastChunk, lastOffset ));
-        for (int i = firstChunk; i <= lastChunk; ++i)
+        resultString.resize(size);
+        char *output = resultString.data();
+
+        QSemaphore finished;
+        QAtomicInt failed;
+        int taskCount = 0;
+
+        for (int i = firstChunk + 1; i < lastChunk; ++i)
         {
-            /* Access cache */
-            found = 0;
-            target = 0;
-            lastStamp = INT_MAX;
-            for (int j = 0; j < d->dictionaryCacheSize; ++j)
+            const uchar *chunkInput = reinterpret_cast<const uchar *>(input.constData()) + (d->offsets[i] - inputStart);
+            ChunkInflater *chunkInflater = new ChunkInflater(chunkInput, d->chunks[i],
+                                                             output + (quint64(i) * d->chunkLength - start), d->chunkLength,
+                                                             &finished, &failed);
+            ++taskCount;
+            if (!QThreadPool::globalInstance()->tryStart(chunkInflater))
             {
-#if USE_CACHE
-                if (d->cache.at(j).chunk() == i)
-                {
-                    found = 1;
-                    target = j;
-                    break;
-                }
-#endif
-                if (d->cache.at(j).stamp() < lastStamp)
-                {
-                    lastStamp = d->cache.at(j).stamp();
-                    target = j;
-                }
+                chunkInflater->run();
+                delete chunkInflater;
             }
+        }
 
-            d->cache[target].setStamp(++stamp);
-            if (found)
-            {
-                count = d->cache.at(target).count();
-                inByteArray = d->cache.at(target).byteArray();
-            }
-            else
-            {
-                d->cache[target].setChunk(i);
+        // The edge chunk is kept by readChunks() only until the next call, so
+        // each edge is copied at once
+        QByteArray edgeChunk;
+        quint64 headSize = quint64(firstChunk + 1) * d->chunkLength - start;
+        QByteArray head = readChunks(start, headSize, &edgeChunk);
+        if (quint64(head.size()) == headSize)
+            memcpy(output, head.constData(), headSize);
+        else
+            failed.storeRelease(1);
 
-                inByteArray = d->cache.at(target).byteArray();
+        quint64 tailStart = quint64(lastChunk) * d->chunkLength;
+        QByteArray tail = readChunks(tailStart, end - tailStart, &edgeChunk);
+        if (quint64(tail.size()) == end - tailStart)
+            memcpy(output + (tailStart - start), tail.constData(), end - tailStart);
+        else
+            failed.storeRelease(1);
 
-                if (d->chunks[i] >= OUT_BUFFER_SIZE )
-                {
-                    qDebug() << Q_FUNC_INFO << QString("chunks[%1] = %2 >= %3 (OUT_BUFFER_SIZE)").arg(i).arg(d->chunks[i]).arg(OUT_BUFFER_SIZE);
-                }
+        finished.acquire(taskCount);
 
-                outByteArray = QByteArray::fromRawData(reinterpret_cast<char*>(d->start + d->offsets[i]), d->chunks[i]);
+        if (failed.loadAcquire())
+        {
+            qWarning() << Q_FUNC_INFO << QString("Cannot inflate chunks %1 to %2").arg(firstChunk).arg(lastChunk);
+            return QByteArray();
+        }
 
-                d->zStream.next_in = (Bytef *)outByteArray.data();
-                d->zStream.avail_in = d->chunks[i];
-                d->zStream.next_out = (Bytef *)inByteArray.data();
-                d->zStream.avail_out = IN_BUFFER_SIZE;
+        return resultString;
+    }
 
-                if (inflate( &d->zStream, Z_PARTIAL_FLUSH ) != Z_OK)
-                {
-                    qWarning() << Q_FUNC_INFO << QString("inflate: %1").arg(d->zStream.msg);
-                }
+    case DICTIONARY_TEXT:
+    case DICTIONARY_UNKNOWN:
+        qWarning() << Q_FUNC_INFO << "Cannot read unknown file type";
+        break;
+    }
 
-                if (d->zStream.avail_in)
-                {
-                    qWarning() << Q_FUNC_INFO << QString("inflate did not flush (%1 pending, %2 avail)").arg(d->zStream.avail_in).arg(d->zStream.avail_out);
-                }
+    return resultString;
+}
 
-                count = IN_BUFFER_SIZE - d->zStream.avail_out;
+int
+DictionaryZip::chunkCount() const
+{
+    return (d->type == DICTIONARY_DZIP && d->offsets) ? d->chunkCount : 0;
+}
 
-                d->cache[target].setCount(count);
-            }
+quint64
+DictionaryZip::chunkStart(int index) const
+{
+    if (index < d->chunkCount)
+        return quint64(index) * d->chunkLength;
 
-            if (i == firstChunk)
-            {
-                if (i == lastChunk)
-                {
-                    inByteArray.append(inByteArray.mid(firstOffset, lastOffset - firstOffset));
-                }
-                else
-                {
-                    if (count != d->chunkLength )
-                    {
-                        qDebug() << Q_FUNC_INFO << QString("Length = %1 instead of %2").arg(count).arg(d->chunkLength);
-                    }
+    // The gzip trailer keeps the uncompressed size modulo 4 GB only, and the
+    // last chunk is the only one that may be shorter
+    quint64 lastChunkStart = quint64(d->chunkCount - 1) * d->chunkLength;
+    quint64 size = (lastChunkStart & ~quint64(0xffffffff)) | (d->originalLength & 0xffffffff);
+    if (size <= lastChunkStart)
+        size += quint64(1) << 32;
 
-                    inByteArray.append(inByteArray.mid(firstOffset, d->chunkLength - firstOffset));
-                }
-            }
-            else if (i == lastChunk)
-            {
-                inByteArray.append(inByteArray.left(lastOffset));
-            }
-            else
-            {
-                Q_ASSERT(count == d->chunkLength);
-                inByteArray.append(inByteArray.left(d->chunkLength));
-            }
-        }
-        break;
+    return size;
+}
 
-    case DICTIONARY_UNKNOWN:
-        qWarning() << Q_FUNC_INFO << "Cannot read unknown file type";
-        break;
+QByteArray
+DictionaryZip::decodeChunk(int index)
+{
+    QByteArray input = d->dataFile.read(d->offsets[index], d->chunks[index]);
+    if (input.size() != d->chunks[index])
+    {
+        qWarning() << Q_FUNC_INFO << QString("Chunk %1 is beyond the end of the file").arg(index);
+        return QByteArray();
     }
 
-    return resultString;
+    z_stream *zStream = inflaterPool()->acquire();
+    if (!zStream)
+        return QByteArray();
+
+    // Concurrent readers missing the same chunk both inflate it, which is
+    // cheaper than making them wait for each other
+    QByteArray result;
+    result.resize(d->chunkLength);
+
+    int count = inflateChunk(zStream, reinterpret_cast<const uchar *>(input.constData()), input.size(), result.data(), d->chunkLength);
+    inflaterPool()->release(zStream);
+    if (count < 0)
+        return QByteArray();
+
+    result.resize(count);
+    return result;
+}
+
+void
+DictionaryZip::setAccessPattern(AccessPattern accessPattern)
+{
+    adviseMapping(d->dataFile.data(), d->dataFile.size(), accessPattern);
 }
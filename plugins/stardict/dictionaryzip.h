@@ -20,6 +20,8 @@
 #ifndef MULA_PLUGIN_STARDICT_DICTIONARYZIP_LIB
 #define MULA_PLUGIN_STARDICT_DICTIONARYZIP_LIB
 
+#include "abstractdatafile.h"
+
 #include <QtCore/QString>
 
 namespace MulaPluginStarDict
@@ -36,19 +38,60 @@ namespace MulaPluginStarDict
      * For more information about dictzip, refer to DICT project, please see:
      * http://www.dict.org
      *
+     * \note Once the file is opened, read() is safe to call from several
+     * threads at once. The header and the chunk offsets are not modified
+     * afterwards, the inflate states are pooled, and the inflated chunks are
+     * kept in the concurrent ChunkCache.
+     *
      * \see Indexfile
      */
 
-    class DictionaryZip
+    class DictionaryZip : public AbstractDataFile
     {
         public:
             DictionaryZip();
             virtual ~DictionaryZip();
 
+            /**
+             * Opens the ".dict.dz" file
+             *
+             * \note Plain gzip files without the dictzip chunk table are
+             * refused, as they are read by GzipDataFile, and so are the
+             * uncompressed files read by PlainDataFile.
+             *
+             * @param   fileName    The complete file path of the data file
+             *
+             * @return True if the file was opened successfully, otherwise
+             * false.
+             */
+
+            bool open(const QString& fileName);
             bool open(const QString& fileName, int computeCRC);
             void close();
 
-            QByteArray read(unsigned long start, unsigned long size);
+            /**
+             * Returns the uncompressed data of the file at the given position
+             *
+             * \note The inflated dictzip chunks are kept in the ChunkCache
+             * shared by all the dictionaries.
+             *
+             * @param   start   The offset of the data in the uncompressed file
+             * @param   size    The size of the data
+             * @param   chunk   If not NULL and the data lies in one chunk, it
+             * is set to that chunk, and the returned data is a raw view into
+             * it that stays valid as long as the chunk is kept
+             *
+             * @return The data, or an empty byte array on error
+             */
+
+            QByteArray read(quint64 start, unsigned long size, QByteArray *chunk = 0);
+
+            int chunkCount() const;
+            quint64 chunkStart(int index) const;
+            void setAccessPattern(AccessPattern accessPattern);
+
+        protected:
+            QByteArray decodeChunk(int index);
 
         private:
             int readHeader(const QString &filename, int computeCRC);
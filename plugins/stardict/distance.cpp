@@ -50,8 +50,14 @@ The Levenshtein distance algorithm has been used in:
 #include "distance.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <QtCore/QString>
+#include <QtCore/QVarLengthArray>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define OPTIMIZE_ED
 /*
@@ -71,6 +77,7 @@ EditDistance::EditDistance()
 {
     currentelements = 2500; // It's enough for most conditions :-)
     d = (int*)malloc(sizeof(int) * currentelements);
+    memset(latin1Masks, 0, sizeof(latin1Masks));
 }
 
 EditDistance::~EditDistance()
@@ -80,58 +87,269 @@ EditDistance::~EditDistance()
         free(d);
 }
 
-#ifdef OPTIMIZE_ED
-int EditDistance::calEditDistance(QString s, QString t, const int limit)
-/*Compute levenshtein distance between s and t, this is using QUICK algorithm*/
+int EditDistance::calEditDistance(const QString& s, const QString& t, const int limit)
+{
+    return calEditDistance(s.constData(), s.length(), t.constData(), t.length(), limit);
+}
+
+int EditDistance::calEditDistance(const QChar *s, int n, const QChar *t, int m, const int limit)
+{
+    // Remove leftmost and rightmost matching portion of strings
+    while ( n && m && (*s == *t) )
+    {
+        ++s;
+        ++t;
+        --n;
+        --m;
+    }
+
+    while ( n && m && (s[n - 1] == t[m - 1]) )
+    {
+        --n;
+        --m;
+    }
+
+    if ( m == 0 || n == 0 )
+        return (m + n);
+
+    // s is the shorter one from now on
+    if ( m < n )
+    {
+        qSwap(s, t);
+        qSwap(n, m);
+    }
+
+    if ( m - n >= limit )
+        return m - n;
+
+    if ( n <= 64 )
+        return bitParallelEditDistance(s, n, t, m, limit);
+
+    return matrixEditDistance(s, n, t, m, limit);
+}
+
+void EditDistance::calEditDistances(const QString& s, const QString *t, int count, const int limit, int *distances)
 {
-    int n = 0;
-    int m = 0;
-    int iLenDif;
-    int k;
     int i = 0;
-    int j;
-    int cost;
 
-    // Remove leftmost matching portion of strings
-    while ( !s.at(i).isNull() && (s.at(i) == t.at(i)) )
-        ++i;
+#ifdef __SSE2__
+    const int n = s.length();
+    if ( n > 0 && n <= 16 )
+    {
+        for ( ; i + batchSize <= count; i += batchSize )
+            batchEditDistances(s.constData(), n, t + i, distances + i);
+    }
+#endif
+
+    for ( ; i < count; ++i )
+        distances[i] = calEditDistance(s, t[i], limit);
+}
 
-    s = s.mid(i);
-    t = t.mid(i);
+/*
+Bit-parallel computation of the distance with the transposition extension
+of Myers' algorithm from:
+Hyyrö, Heikki : "A Bit-Vector Algorithm for Computing Levenshtein and
+Damerau Edit Distances"
+(Nordic Journal of Computing, 10(1):29-39, 2003)
+The column of the dynamic programming matrix is kept as the vertical
+positive and negative differences in one bit each, with the pattern s in
+at most 64 bits.
+*/
+int EditDistance::bitParallelEditDistance(const QChar *s, int n, const QChar *t, int m, const int limit)
+{
+    // The match masks of the characters of s, the rare ones beyond Latin-1
+    // in a short list
+    QVarLengthArray<QChar, 8> otherCharacters;
+    QVarLengthArray<quint64, 8> otherMasks;
 
-    while (!s.at(n).isNull())
+    for (int i = 0; i < n; ++i)
     {
-        ++n;
+        ushort character = s[i].unicode();
+        if ( character < 256 )
+        {
+            latin1Masks[character] |= quint64(1) << i;
+            continue;
+        }
+
+        int k = otherCharacters.indexOf(s[i]);
+        if ( k < 0 )
+        {
+            otherCharacters.append(s[i]);
+            otherMasks.append(0);
+            k = otherCharacters.size() - 1;
+        }
+
+        otherMasks[k] |= quint64(1) << i;
     }
 
-    while (!t.at(m).isNull())
+    const quint64 lastBit = quint64(1) << (n - 1);
+    quint64 vp = ~quint64(0);
+    quint64 vn = 0;
+    quint64 d0 = 0;
+    quint64 previousPm = 0;
+    int distance = n;
+
+    for (int j = 0; j < m; ++j)
     {
-        ++m;
+        quint64 pm = 0;
+        ushort character = t[j].unicode();
+        if ( character < 256 )
+        {
+            pm = latin1Masks[character];
+        }
+        else
+        {
+            int k = otherCharacters.indexOf(t[j]);
+            if ( k >= 0 )
+                pm = otherMasks[k];
+        }
+
+        d0 = ((((~d0) & pm) << 1) & previousPm) | (((pm & vp) + vp) ^ vp) | pm | vn;
+        quint64 hp = vn | ~(d0 | vp);
+        quint64 hn = d0 & vp;
+
+        if ( hp & lastBit )
+            ++distance;
+        else if ( hn & lastBit )
+            --distance;
+
+        quint64 x = (hp << 1) | 1;
+        vn = x & d0;
+        vp = (hn << 1) | ~(x | d0);
+        previousPm = pm;
+
+        // test if the distance cannot get below the limit anymore, it drops
+        // at most by one for each remaining character
+        if ( distance - (m - j - 1) >= limit )
+        {
+            distance -= m - j - 1;
+            break;
+        }
     }
 
-    // Remove rightmost matching portion of strings by decrement n and m.
-    while ( n && m && (s.at(n - 1) == t.at(m - 1)) )
+    // Leave the table clean for the next call
+    for (int i = 0; i < n; ++i)
     {
-        --n;
-        --m;
+        if ( s[i].unicode() < 256 )
+            latin1Masks[s[i].unicode()] = 0;
     }
 
-    if ( m == 0 || n == 0 || d == (int*)0 )
-        return (m + n);
+    return distance;
+}
 
-    if ( m < n )
+#ifdef __SSE2__
+/*
+The same algorithm for batchSize strings t at once, each of them in a 16 bit
+lane, thus s can be at most 16 characters long. The strings of t are not
+trimmed, and the exact distances are returned.
+*/
+void EditDistance::batchEditDistances(const QChar *s, int n, const QString *t, int *distances)
+{
+    quint16 masks[256];
+    memset(masks, 0, sizeof(masks));
+
+    QVarLengthArray<QChar, 8> otherCharacters;
+    QVarLengthArray<quint16, 8> otherMasks;
+
+    for (int i = 0; i < n; ++i)
     {
-        const QString temp = s;
-        int itemp = n;
-        s = t;
-        t = temp;
-        n = m;
-        m = itemp;
+        ushort character = s[i].unicode();
+        if ( character < 256 )
+        {
+            masks[character] |= 1 << i;
+            continue;
+        }
+
+        int k = otherCharacters.indexOf(s[i]);
+        if ( k < 0 )
+        {
+            otherCharacters.append(s[i]);
+            otherMasks.append(0);
+            k = otherCharacters.size() - 1;
+        }
+
+        otherMasks[k] |= 1 << i;
     }
 
+    int maximumLength = 0;
+    for (int k = 0; k < batchSize; ++k)
+        maximumLength = qMax(maximumLength, t[k].length());
+
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i lastBitShift = _mm_cvtsi32_si128(n - 1);
+    const __m128i lengths = _mm_setr_epi16(t[0].length(), t[1].length(), t[2].length(), t[3].length(),
+                                           t[4].length(), t[5].length(), t[6].length(), t[7].length());
+    __m128i vp = ones;
+    __m128i vn = _mm_setzero_si128();
+    __m128i d0 = _mm_setzero_si128();
+    __m128i previousPm = _mm_setzero_si128();
+    __m128i distance = _mm_set1_epi16(n);
+
+    for (int j = 0; j < maximumLength; ++j)
+    {
+        quint16 laneMasks[batchSize];
+        for (int k = 0; k < batchSize; ++k)
+        {
+            laneMasks[k] = 0;
+            if ( j >= t[k].length() )
+                continue;
+
+            ushort character = t[k].at(j).unicode();
+            if ( character < 256 )
+            {
+                laneMasks[k] = masks[character];
+            }
+            else
+            {
+                int index = otherCharacters.indexOf(t[k].at(j));
+                if ( index >= 0 )
+                    laneMasks[k] = otherMasks[index];
+            }
+        }
+
+        __m128i pm = _mm_loadu_si128(reinterpret_cast<const __m128i *>(laneMasks));
+        __m128i transposition = _mm_and_si128(_mm_slli_epi16(_mm_andnot_si128(d0, pm), 1), previousPm);
+        __m128i sum = _mm_add_epi16(_mm_and_si128(pm, vp), vp);
+        d0 = _mm_or_si128(_mm_or_si128(transposition, _mm_xor_si128(sum, vp)), _mm_or_si128(pm, vn));
+
+        __m128i hp = _mm_or_si128(vn, _mm_andnot_si128(_mm_or_si128(d0, vp), ones));
+        __m128i hn = _mm_and_si128(d0, vp);
+
+        // The lanes whose string has ended keep their distance
+        __m128i active = _mm_cmpgt_epi16(lengths, _mm_set1_epi16(j));
+        __m128i increment = _mm_and_si128(_mm_and_si128(_mm_srl_epi16(hp, lastBitShift), one), active);
+        __m128i decrement = _mm_and_si128(_mm_and_si128(_mm_srl_epi16(hn, lastBitShift), one), active);
+        distance = _mm_sub_epi16(_mm_add_epi16(distance, increment), decrement);
+
+        __m128i x = _mm_or_si128(_mm_slli_epi16(hp, 1), one);
+        vn = _mm_and_si128(x, d0);
+        vp = _mm_or_si128(_mm_slli_epi16(hn, 1), _mm_andnot_si128(_mm_or_si128(x, d0), ones));
+        previousPm = pm;
+    }
+
+    qint16 laneDistances[batchSize];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(laneDistances), distance);
+
+    for (int k = 0; k < batchSize; ++k)
+        distances[k] = laneDistances[k];
+}
+#endif
+
+#ifdef OPTIMIZE_ED
+int EditDistance::matrixEditDistance(const QChar *s, int n, const QChar *t, int m, const int limit)
+/*Compute levenshtein distance between the trimmed s and t, this is using QUICK algorithm*/
+{
+    int iLenDif;
+    int k;
+    int i;
+    int j;
+    int cost;
+
+    if ( d == (int*)0 )
+        return (m + n);
+
     iLenDif = m - n;
-    if ( iLenDif >= limit )
-        return iLenDif;
     // step 1
     ++n;
     ++m;
@@ -241,3 +459,79 @@ int EditDistance::CalEditDistance(const char *s, const char *t, const int limit)
     }
 }
 #endif
+
+int EditDistance::damerauLevenshteinDistance(const QChar *s, int n, const QChar *t, int m)
+/*Lowrance-Wagner algorithm, a transposed pair may have other characters inserted in between*/
+{
+    if ( n == 0 || m == 0 )
+        return (m + n);
+
+    const int columns = m + 2;
+    const int infinity = m + n;
+    QVarLengthArray<int, 1024> h((n + 2) * columns);
+
+    h[0] = infinity;
+    for (int i = 0; i <= n; ++i)
+    {
+        h[(i + 1) * columns] = infinity;
+        h[(i + 1) * columns + 1] = i;
+    }
+
+    for (int j = 0; j <= m; ++j)
+    {
+        h[j + 1] = infinity;
+        h[columns + j + 1] = j;
+    }
+
+    // The last row of every character of s seen so far, the words are short
+    // so a linear search is fine
+    QVarLengthArray<QChar, 64> lastRowCharacters;
+    QVarLengthArray<int, 64> lastRows;
+
+    for (int i = 1; i <= n; ++i)
+    {
+        int lastMatchColumn = 0;
+        for (int j = 1; j <= m; ++j)
+        {
+            int lastMatchRow = 0;
+            for (int k = 0; k < lastRowCharacters.size(); ++k)
+            {
+                if (lastRowCharacters[k] == t[j - 1])
+                {
+                    lastMatchRow = lastRows[k];
+                    break;
+                }
+            }
+
+            int cost = 1;
+            int previousMatchColumn = lastMatchColumn;
+            if ( s[i - 1] == t[j - 1] )
+            {
+                cost = 0;
+                lastMatchColumn = j;
+            }
+
+            int value = qMin(qMin(h[i * columns + j] + cost, h[(i + 1) * columns + j] + 1), h[i * columns + j + 1] + 1);
+            value = qMin(value, h[lastMatchRow * columns + previousMatchColumn]
+                         + (i - lastMatchRow - 1) + 1 + (j - previousMatchColumn - 1));
+
+            h[(i + 1) * columns + j + 1] = value;
+        }
+
+        int k = 0;
+        while (k < lastRowCharacters.size() && lastRowCharacters[k] != s[i - 1])
+            ++k;
+
+        if (k == lastRowCharacters.size())
+        {
+            lastRowCharacters.append(s[i - 1]);
+            lastRows.append(i);
+        }
+        else
+        {
+            lastRows[k] = i;
+        }
+    }
+
+    return h[(n + 1) * columns + m + 1];
+}
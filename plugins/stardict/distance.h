@@ -22,15 +22,46 @@
 
 #include <QtCore/QtGlobal>
 
+class QChar;
+class QString;
+
 class EditDistance
 {
     public:
         EditDistance();
         virtual ~EditDistance();
 
-        int calEditDistance( QString s, QString t, const int limit );
+        /*
+         * Returns the edit distance of s and t, a transposition of two
+         * adjacent characters counting as one edit. Once the distance is
+         * known to reach the limit, a value of at least the limit is
+         * returned early.
+         */
+        int calEditDistance( const QString& s, const QString& t, const int limit );
+        int calEditDistance( const QChar *s, int n, const QChar *t, int m, const int limit );
+
+        /*
+         * Computes the distances of s from the count strings of t into
+         * distances. On SSE2 capable processors, batchSize strings are
+         * measured at once if s is at most 16 characters long.
+         */
+        void calEditDistances( const QString& s, const QString *t, int count, const int limit, int *distances );
+
+        static const int batchSize = 8;
+
+        /*
+         * Unrestricted Damerau-Levenshtein distance, which unlike the optimal
+         * string alignment of calEditDistance() is a metric, thus usable for
+         * the BK-tree of the FuzzyIndex. It never exceeds calEditDistance().
+         */
+        static int damerauLevenshteinDistance( const QChar *s, int n, const QChar *t, int m );
 
     private:
+        /* s is not longer than t, and at most 64 characters long */
+        int bitParallelEditDistance( const QChar *s, int n, const QChar *t, int m, const int limit );
+        void batchEditDistances( const QChar *s, int n, const QString *t, int *distances );
+        int matrixEditDistance( const QChar *s, int n, const QChar *t, int m, const int limit );
+
         /*Gets the minimum of three values */
         inline int minimum( const int a, const int b, const int c )
         {
@@ -39,6 +70,9 @@ class EditDistance
 
         int *d;
         int currentelements;
+
+        // The match masks of the pattern, all zero between the calls
+        quint64 latin1Masks[256];
 };
 
 #endif
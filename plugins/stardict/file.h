@@ -20,8 +20,12 @@
 #ifndef MULA_PLUGIN_STARDICT_FILE
 #define MULA_PLUGIN_STARDICT_FILE
 
+#include <QtCore/QByteArray>
+#include <QtCore/QChar>
 #include <QtCore/QString>
 
+#include <string.h>
+
 const int invalidIndex = -1;
 
 static inline int stardictStringCompare(QString string1, QString string2)
@@ -30,4 +34,273 @@ static inline int stardictStringCompare(QString string1, QString string2)
     return retval ? retval : string1.compare(string2);
 }
 
+/**
+ * Returns the next utf-16 code unit of the utf-8 encoded string, optionally
+ * case folded, in the same way as QString::fromUtf8() and the case insensitive
+ * QString::compare() would see it. Invalid sequences are decoded as the
+ * replacement character. The low surrogate of a supplementary character is
+ * kept in the pending argument until the next call.
+ *
+ * @return Whether or not there was a code unit left in the string
+ */
+
+static inline bool stardictNextUtf16Unit(const uchar *&position, const uchar *end,
+                                         ushort& pending, bool caseFolded, ushort& unit)
+{
+    if (pending)
+    {
+        unit = pending;
+        pending = 0;
+        return true;
+    }
+
+    if (position == end)
+        return false;
+
+    uint codePoint = *position++;
+
+    if (codePoint < 0x80)
+    {
+        if (caseFolded && codePoint >= 'A' && codePoint <= 'Z')
+            codePoint += 'a' - 'A';
+
+        unit = codePoint;
+        return true;
+    }
+
+    int continuationCount;
+    uint minimum;
+
+    if ((codePoint & 0xe0) == 0xc0)
+    {
+        continuationCount = 1;
+        minimum = 0x80;
+        codePoint &= 0x1f;
+    }
+    else if ((codePoint & 0xf0) == 0xe0)
+    {
+        continuationCount = 2;
+        minimum = 0x800;
+        codePoint &= 0x0f;
+    }
+    else if ((codePoint & 0xf8) == 0xf0)
+    {
+        continuationCount = 3;
+        minimum = 0x10000;
+        codePoint &= 0x07;
+    }
+    else
+    {
+        unit = QChar::ReplacementCharacter;
+        return true;
+    }
+
+    const uchar *sequence = position;
+    for (int i = 0; i < continuationCount; ++i, ++sequence)
+    {
+        if (sequence == end || (*sequence & 0xc0) != 0x80)
+        {
+            unit = QChar::ReplacementCharacter;
+            return true;
+        }
+
+        codePoint = (codePoint << 6) | (*sequence & 0x3f);
+    }
+
+    if (codePoint < minimum || codePoint > QChar::LastValidCodePoint
+            || (codePoint >= 0xd800 && codePoint <= 0xdfff))
+    {
+        unit = QChar::ReplacementCharacter;
+        return true;
+    }
+
+    position = sequence;
+
+    if (caseFolded)
+        codePoint = QChar::toCaseFolded(codePoint);
+
+    if (QChar::requiresSurrogates(codePoint))
+    {
+        unit = QChar::highSurrogate(codePoint);
+        pending = QChar::lowSurrogate(codePoint);
+    }
+    else
+    {
+        unit = codePoint;
+    }
+
+    return true;
+}
+
+/**
+ * Compares the utf-8 encoded strings code unit by code unit as if they were
+ * decoded into QStrings first
+ */
+
+static inline int stardictUtf8Compare(const char *string1, int length1,
+                                      const char *string2, int length2, bool caseFolded)
+{
+    const uchar *position1 = reinterpret_cast<const uchar*>(string1);
+    const uchar *position2 = reinterpret_cast<const uchar*>(string2);
+    const uchar *end1 = position1 + length1;
+    const uchar *end2 = position2 + length2;
+    ushort pending1 = 0;
+    ushort pending2 = 0;
+    ushort unit1;
+    ushort unit2;
+
+    forever
+    {
+        // Plain ascii words are compared without any decoding
+        while (!pending1 && !pending2 && position1 != end1 && position2 != end2
+               && *position1 < 0x80 && *position2 < 0x80)
+        {
+            unit1 = *position1++;
+            unit2 = *position2++;
+
+            if (caseFolded)
+            {
+                if (unit1 >= 'A' && unit1 <= 'Z')
+                    unit1 += 'a' - 'A';
+
+                if (unit2 >= 'A' && unit2 <= 'Z')
+                    unit2 += 'a' - 'A';
+            }
+
+            if (unit1 != unit2)
+                return int(unit1) - int(unit2);
+        }
+
+        bool isUnit1 = stardictNextUtf16Unit(position1, end1, pending1, caseFolded, unit1);
+        bool isUnit2 = stardictNextUtf16Unit(position2, end2, pending2, caseFolded, unit2);
+
+        if (!isUnit1 || !isUnit2)
+            return int(isUnit1) - int(isUnit2);
+
+        if (unit1 != unit2)
+            return int(unit1) - int(unit2);
+    }
+}
+
+/**
+ * The byte level equivalent of the QString based stardictStringCompare() for
+ * the utf-8 encoded word data of the index files. It returns a value with the
+ * same sign without converting the words into QStrings.
+ */
+
+static inline int stardictStringCompare(const QByteArray& string1, const QByteArray& string2)
+{
+    int retval = stardictUtf8Compare(string1.constData(), string1.size(), string2.constData(), string2.size(), true);
+    return retval ? retval : stardictUtf8Compare(string1.constData(), string1.size(), string2.constData(), string2.size(), false);
+}
+
+/**
+ * Compares the beginning of the word with the ascii prefix, ignoring the case
+ * of the ascii letters like g_ascii_strcasecmp() does, which StarDict sorts
+ * the index files with. The words of a sorted index starting with the prefix,
+ * regardless of the case, are contiguous, and the ones before them compare
+ * less.
+ *
+ * @return 0 if the word starts with the prefix, otherwise the sign of the
+ * comparison
+ */
+
+static inline int stardictAsciiPrefixCompare(const char *word, int wordLength,
+                                             const char *prefix, int prefixLength)
+{
+    for (int i = 0; i < prefixLength; ++i)
+    {
+        if (i == wordLength)
+            return -1;
+
+        uchar wordByte = word[i];
+        uchar prefixByte = prefix[i];
+
+        if (wordByte >= 'A' && wordByte <= 'Z')
+            wordByte += 'a' - 'A';
+
+        if (prefixByte >= 'A' && prefixByte <= 'Z')
+            prefixByte += 'a' - 'A';
+
+        if (wordByte != prefixByte)
+            return int(wordByte) - int(prefixByte);
+    }
+
+    return 0;
+}
+
+/**
+ * Appends the utf-16 code unit in a variable length encoding that keeps the
+ * numeric order of the units when the bytes are compared.
+ */
+
+static inline void stardictAppendCollationUnit(QByteArray& collationKey, ushort unit)
+{
+    if (unit < 0x80)
+    {
+        collationKey.append(char(unit));
+    }
+    else if (unit < 0x800)
+    {
+        collationKey.append(char(0xc0 | (unit >> 6)));
+        collationKey.append(char(0x80 | (unit & 0x3f)));
+    }
+    else
+    {
+        collationKey.append(char(0xe0 | (unit >> 12)));
+        collationKey.append(char(0x80 | ((unit >> 6) & 0x3f)));
+        collationKey.append(char(0x80 | (unit & 0x3f)));
+    }
+}
+
+/**
+ * Returns the collation key of the utf-8 encoded word. The key consists of the
+ * case folded code units of the word, a '\0' separator and the code units of
+ * the word as they are. Comparing two keys byte by byte with
+ * stardictCollationKeyCompare() gives the same order as
+ * stardictStringCompare() does for the words themselves.
+ *
+ * @param   word    The utf-8 encoded word
+ * @param   length  The length of the word in bytes
+ *
+ * @return The collation key of the word
+ */
+
+static inline QByteArray stardictCollationKey(const char *word, int length)
+{
+    QByteArray collationKey;
+    collationKey.reserve(2 * length + 1);
+
+    for (int caseFolded = 1; caseFolded >= 0; --caseFolded)
+    {
+        const uchar *position = reinterpret_cast<const uchar*>(word);
+        const uchar *end = position + length;
+        ushort pending = 0;
+        ushort unit;
+
+        while (stardictNextUtf16Unit(position, end, pending, caseFolded, unit))
+            stardictAppendCollationUnit(collationKey, unit);
+
+        if (caseFolded)
+            collationKey.append('\0');
+    }
+
+    return collationKey;
+}
+
+static inline QByteArray stardictCollationKey(const QByteArray& word)
+{
+    return stardictCollationKey(word.constData(), word.size());
+}
+
+/**
+ * Compares two collation keys returned by stardictCollationKey()
+ */
+
+static inline int stardictCollationKeyCompare(const QByteArray& collationKey1, const QByteArray& collationKey2)
+{
+    int retval = memcmp(collationKey1.constData(), collationKey2.constData(), qMin(collationKey1.size(), collationKey2.size()));
+    return retval ? retval : collationKey1.size() - collationKey2.size();
+}
+
 #endif // MULA_PLUGIN_STARDICT_FILE
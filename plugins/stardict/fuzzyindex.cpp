@@ -0,0 +1,370 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "fuzzyindex.h"
+
+#include "distance.h"
+#include "indexcache.h"
+#include "matchheap.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QString>
+#include <QtCore/QVarLengthArray>
+
+#include <string.h>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    const char fuzzyIndexMagic[32] = "Mula's StarDict fuzzy index";
+    const quint32 fuzzyIndexVersion = 2;
+    const quint32 fuzzyIndexByteOrderMark = 0x01020304;
+
+    // The header of the cached tree, followed by the nodes and then the
+    // UTF-16 text of the headwords
+    struct FuzzyIndexHeader
+    {
+        char magic[32];
+        quint32 version;
+        quint32 byteOrderMark;
+        quint32 nodeCount;
+        quint32 textSize;
+        qint64 indexModified;
+        quint64 indexSize;
+    };
+
+    // The root is the node 0, thus 0 marks the missing children and siblings
+    struct FuzzyIndexNode
+    {
+        quint32 wordIndex;
+        quint32 textOffset;
+        quint32 firstChild;
+        quint32 nextSibling;
+        quint16 textLength;
+        quint16 distance;   // From the parent node
+    };
+
+    qint64 fuzzyIndexSize(const FuzzyIndexHeader *header)
+    {
+        return sizeof(FuzzyIndexHeader) + qint64(header->nodeCount) * sizeof(FuzzyIndexNode)
+               + qint64(header->textSize) * sizeof(QChar);
+    }
+}
+
+class FuzzyIndex::Private
+{
+    public:
+        Private()
+            : mappedData(0)
+            , nodeTable(0)
+            , textTable(0)
+            , nodeCount(0)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        void reset()
+        {
+            if (mappedData)
+                mapFile.unmap(mappedData);
+
+            mappedData = 0;
+            mapFile.close();
+            nodes.clear();
+            text.clear();
+            previousWord.clear();
+
+            nodeTable = 0;
+            textTable = 0;
+            nodeCount = 0;
+        }
+
+        int distance(const QChar *word, int wordLength, const FuzzyIndexNode& node) const
+        {
+            return EditDistance::damerauLevenshteinDistance(word, wordLength, textTable + node.textOffset, node.textLength);
+        }
+
+        QFile mapFile;
+        uchar *mappedData;
+
+        // The tree is built into these vectors if it is not mapped
+        QVector<FuzzyIndexNode> nodes;
+        QVector<QChar> text;
+
+        // The last headword added, for skipping the repeated ones
+        QString previousWord;
+
+        const FuzzyIndexNode *nodeTable;
+        const QChar *textTable;
+        quint32 nodeCount;
+};
+
+FuzzyIndex::FuzzyIndex()
+    : d(new Private)
+{
+}
+
+FuzzyIndex::~FuzzyIndex()
+{
+    d->reset();
+    delete d;
+}
+
+bool
+FuzzyIndex::load(const QString& indexFilePath)
+{
+    QFileInfo indexFileInfo(indexFilePath);
+
+    foreach (const QString& cacheLocation, IndexCache::cacheLocations(indexFilePath, "fzi"))
+    {
+        if (!QFile::exists(cacheLocation))
+            continue;
+
+        d->reset();
+        d->mapFile.setFileName(cacheLocation);
+        if (!d->mapFile.open(QIODevice::ReadOnly))
+        {
+            qDebug() << "Failed to open file:" << cacheLocation;
+            continue;
+        }
+
+        if (d->mapFile.size() < qint64(sizeof(FuzzyIndexHeader)))
+            continue;
+
+        d->mappedData = d->mapFile.map(0, d->mapFile.size());
+        if (d->mappedData == NULL)
+        {
+            qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(cacheLocation);
+            continue;
+        }
+
+        const FuzzyIndexHeader *header = reinterpret_cast<const FuzzyIndexHeader *>(d->mappedData);
+        if (qstrncmp(header->magic, fuzzyIndexMagic, sizeof(header->magic)) != 0
+                || header->version != fuzzyIndexVersion
+                || header->byteOrderMark != fuzzyIndexByteOrderMark
+                || header->indexModified != indexFileInfo.lastModified().toMSecsSinceEpoch()
+                || header->indexSize != quint64(indexFileInfo.size())
+                || d->mapFile.size() != fuzzyIndexSize(header))
+        {
+            qDebug() << "Outdated cache file:" << cacheLocation;
+            continue;
+        }
+
+        d->nodeCount = header->nodeCount;
+        d->nodeTable = reinterpret_cast<const FuzzyIndexNode *>(d->mappedData + sizeof(FuzzyIndexHeader));
+        d->textTable = reinterpret_cast<const QChar *>(d->nodeTable + d->nodeCount);
+        return true;
+    }
+
+    d->reset();
+    return false;
+}
+
+bool
+FuzzyIndex::save(const QString& indexFilePath)
+{
+    if (d->nodes.isEmpty())
+        return false;
+
+    QFileInfo indexFileInfo(indexFilePath);
+
+    FuzzyIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    qstrncpy(header.magic, fuzzyIndexMagic, sizeof(header.magic));
+    header.version = fuzzyIndexVersion;
+    header.byteOrderMark = fuzzyIndexByteOrderMark;
+    header.nodeCount = d->nodes.size();
+    header.textSize = d->text.size();
+    header.indexModified = indexFileInfo.lastModified().toMSecsSinceEpoch();
+    header.indexSize = indexFileInfo.size();
+
+    foreach (const QString& cacheLocation, IndexCache::cacheLocations(indexFilePath, "fzi"))
+    {
+        // Replaced by renaming, as other processes may have the old file
+        // mapped
+        QSaveFile file(cacheLocation);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            qDebug() << "Failed to open file for writing:" << cacheLocation;
+            continue;
+        }
+
+        qint64 nodesSize = qint64(d->nodes.size()) * sizeof(FuzzyIndexNode);
+        qint64 textSize = qint64(d->text.size()) * sizeof(QChar);
+        if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+                || file.write(reinterpret_cast<const char *>(d->nodes.constData()), nodesSize) != nodesSize
+                || file.write(reinterpret_cast<const char *>(d->text.constData()), textSize) != textSize
+                || !file.commit())
+        {
+            qDebug() << "Failed to write the cache file:" << cacheLocation;
+            continue;
+        }
+
+        qDebug() << "Save to cache" << cacheLocation;
+        return true;
+    }
+
+    return false;
+}
+
+void
+FuzzyIndex::beginBuild()
+{
+    d->reset();
+}
+
+void
+FuzzyIndex::addWord(const QString& word, long index)
+{
+    // The same headword in a row is added once, like the scans of the index
+    // return it once
+    if (word == d->previousWord)
+        return;
+
+    d->previousWord = word;
+
+    QString lowerWord = word.toLower();
+    if (lowerWord.isEmpty() || lowerWord.length() > 0xffff)
+        return;
+
+    FuzzyIndexNode node;
+    node.wordIndex = index;
+    node.textOffset = d->text.size();
+    node.firstChild = 0;
+    node.nextSibling = 0;
+    node.textLength = lowerWord.length();
+    node.distance = 0;
+
+    if (!d->nodes.isEmpty())
+    {
+        // The distances are measured against the text built so far
+        d->textTable = d->text.constData();
+
+        quint32 current = 0;
+        forever
+        {
+            int distance = d->distance(lowerWord.constData(), lowerWord.length(), d->nodes.at(current));
+
+            // The headwords differing only in case are chained as the
+            // children at distance 0, and share the text of the first one
+            if (distance == 0)
+                node.textOffset = d->nodes.at(current).textOffset;
+
+            quint32 previousChild = 0;
+            quint32 child = d->nodes.at(current).firstChild;
+            while (child != 0 && d->nodes.at(child).distance != distance)
+            {
+                previousChild = child;
+                child = d->nodes.at(child).nextSibling;
+            }
+
+            if (child != 0)
+            {
+                current = child;
+                continue;
+            }
+
+            node.distance = distance;
+            if (previousChild != 0)
+                d->nodes[previousChild].nextSibling = d->nodes.size();
+            else
+                d->nodes[current].firstChild = d->nodes.size();
+
+            break;
+        }
+    }
+
+    if (node.textOffset == quint32(d->text.size()))
+    {
+        for (int i = 0; i < lowerWord.length(); ++i)
+            d->text.append(lowerWord.at(i));
+    }
+
+    d->nodes.append(node);
+}
+
+void
+FuzzyIndex::endBuild()
+{
+    d->previousWord.clear();
+    d->nodes.squeeze();
+    d->text.squeeze();
+
+    d->nodeTable = d->nodes.constData();
+    d->textTable = d->text.constData();
+    d->nodeCount = d->nodes.size();
+}
+
+bool
+FuzzyIndex::isEmpty() const
+{
+    return d->nodeCount == 0;
+}
+
+QVector<FuzzyIndex::Match>
+FuzzyIndex::lookup(const QString& word, int limit, int maximumCount) const
+{
+    QString lowerWord = word.toLower();
+    if (d->nodeCount == 0 || lowerWord.isEmpty() || maximumCount <= 0)
+        return QVector<Match>();
+
+    EditDistance editDistance;
+
+    // Every word entry has one node at most, so the matches need no
+    // deduplication
+    MatchHeap matchHeap(maximumCount, limit);
+
+    QVarLengthArray<quint32, 256> pendingNodes;
+    pendingNodes.append(0);
+
+    while (!pendingNodes.isEmpty())
+    {
+        const FuzzyIndexNode& node = d->nodeTable[pendingNodes.last()];
+        pendingNodes.removeLast();
+
+        int currentLimit = matchHeap.limit();
+        int distance = d->distance(lowerWord.constData(), lowerWord.length(), node);
+        if (distance < currentLimit)
+        {
+            // The Damerau-Levenshtein distance may be below the optimal
+            // string alignment distance of the earlier lookups
+            int matchDistance = editDistance.calEditDistance(d->textTable + node.textOffset, node.textLength,
+                                                             lowerWord.constData(), lowerWord.length(), currentLimit);
+
+            if (matchDistance < lowerWord.length())
+                matchHeap.insert(node.wordIndex, matchDistance);
+        }
+
+        // Only the subtrees that can hold a word within the limit
+        for (quint32 child = node.firstChild; child != 0; child = d->nodeTable[child].nextSibling)
+        {
+            if (qAbs(int(d->nodeTable[child].distance) - distance) < matchHeap.limit())
+                pendingNodes.append(child);
+        }
+    }
+
+    return matchHeap.matches();
+}
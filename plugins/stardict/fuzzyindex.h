@@ -0,0 +1,168 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_FUZZYINDEX_H
+#define MULA_PLUGIN_STARDICT_FUZZYINDEX_H
+
+#include <QtCore/QVector>
+
+class QString;
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief BK-tree of the lowercase headwords of a dictionary for the
+     * similar word lookups
+     *
+     * Every node of the tree holds a headword, and its children are keyed by
+     * their edit distance from it. Thanks to the triangle inequality, a lookup
+     * within the distance r only descends into the children whose key is
+     * within r of the distance of the looked up word from the node, which is
+     * a small part of the tree for the distances the fuzzy lookup uses. The
+     * tree is built with the unrestricted Damerau-Levenshtein distance, which
+     * is a metric, and the matches are then measured with the optimal string
+     * alignment distance of EditDistance::calEditDistance() like before.
+     *
+     * The tree is cached next to the ".oft" files of the index, see
+     * IndexCache::cacheLocations(), and the cache is mapped on the later
+     * loads.
+     *
+     * \note The headwords differing only in case are chained below the first
+     * of them at the distance 0, so the lookups return all of them, like the
+     * scans of the index do.
+     *
+     * \see Dictionary::fuzzyIndex
+     */
+
+    class FuzzyIndex
+    {
+        public:
+
+            /**
+             * A headword found by lookup()
+             */
+
+            struct Match
+            {
+                long index;     // The index of the word entry
+                int distance;   // The edit distance from the looked up word
+            };
+
+            /**
+             * Constructor
+             */
+
+            FuzzyIndex();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~FuzzyIndex();
+
+            /**
+             * Maps the cached tree of the index file if it is up to date
+             *
+             * @param   indexFilePath   The complete file path of the index
+             * file
+             *
+             * @return True if the cache was loaded successfully, otherwise
+             * false.
+             *
+             * @see save
+             */
+
+            bool load(const QString& indexFilePath);
+
+            /**
+             * Writes the tree built by endBuild() into the cache
+             *
+             * @param   indexFilePath   The complete file path of the index
+             * file
+             *
+             * @return True if the cache was written successfully, otherwise
+             * false.
+             *
+             * @see load
+             */
+
+            bool save(const QString& indexFilePath);
+
+            /**
+             * Starts building a new tree, and drops the current one
+             *
+             * @see addWord, endBuild
+             */
+
+            void beginBuild();
+
+            /**
+             * Inserts the headword into the tree being built. The headword
+             * is skipped if it is the same as the previous one.
+             *
+             * @param   word    The headword
+             * @param   index   The index of the word entry
+             *
+             * @see beginBuild, endBuild
+             */
+
+            void addWord(const QString& word, long index);
+
+            /**
+             * Finishes building the tree, which can be looked up and saved
+             * afterwards
+             *
+             * @see beginBuild, addWord
+             */
+
+            void endBuild();
+
+            /**
+             * Returns whether the tree is loaded or built
+             *
+             * @return True if the tree has no headwords, otherwise false
+             */
+
+            bool isEmpty() const;
+
+            /**
+             * Returns the headwords closest to the given word, which is
+             * lowercased. Only the distances below the limit and the length
+             * of the word are accepted, and once maximumCount headwords are
+             * found, only the ones closer than the farthest of them replace
+             * it.
+             *
+             * \note This method is safe to call from several threads at once.
+             *
+             * @param   word            The looked up word
+             * @param   limit           The exclusive limit of the distance
+             * @param   maximumCount    The maximum number of the matches
+             *
+             * @return The matches ordered by their distance and index
+             */
+
+            QVector<Match> lookup(const QString& word, int limit, int maximumCount) const;
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_FUZZYINDEX_H
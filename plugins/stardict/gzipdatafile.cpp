@@ -0,0 +1,542 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "gzipdatafile.h"
+
+#include "indexcache.h"
+#include "mappedfile.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+#include <zlib.h>
+
+#include <string.h>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    const char gzipIndexMagic[16] = "StarDict gzidx";
+    const quint32 gzipIndexVersion = 2;
+
+    // Deflate refers back at most that many bytes of the output
+    const int windowSize = 32768;
+
+    // The default distance of the access points in the uncompressed data
+    const int defaultSpanSize = 1024 * 1024;
+
+    // The data was compressed with a full flush at every access point, thus
+    // no windows are stored
+    const quint32 gzipIndexNoWindows = 0x1;
+
+    // The header of the cached access points, followed by the access points
+    // and their windows of windowSize bytes each
+    struct GzipIndexHeader
+    {
+        char magic[16];
+        quint32 version;
+        quint32 pointCount;
+        quint32 spanSize;
+        quint32 flags;
+        qint64 dataModified;
+        quint64 dataSize;
+        quint64 uncompressedSize;
+    };
+
+    struct GzipAccessPoint
+    {
+        quint64 out;        // Offset in the uncompressed data
+        quint64 in;         // Offset of the first full byte in the file
+        quint32 bits;       // Bits of the byte before "in" still to inflate
+        quint32 reserved;
+    };
+
+    qint64 gzipIndexSize(quint32 pointCount, quint32 flags)
+    {
+        int pointWindowSize = (flags & gzipIndexNoWindows) ? 0 : windowSize;
+        return sizeof(GzipIndexHeader) + qint64(pointCount) * (sizeof(GzipAccessPoint) + pointWindowSize);
+    }
+
+    bool writeIndex(const QString& fileName, QByteArray& indexBuffer)
+    {
+        GzipIndexHeader *indexHeader = reinterpret_cast<GzipIndexHeader *>(indexBuffer.data());
+        indexHeader->dataModified = QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+
+        foreach (const QString& cacheLocation, IndexCache::cacheLocations(fileName, "gzidx"))
+        {
+            // Replaced by renaming, as other processes may have the old file
+            // mapped
+            QSaveFile file(cacheLocation);
+            if (!file.open(QIODevice::WriteOnly))
+            {
+                qDebug() << "Failed to open file for writing:" << cacheLocation;
+                continue;
+            }
+
+            if (file.write(indexBuffer) != indexBuffer.size() || !file.commit())
+            {
+                qDebug() << "Failed to write the cache file:" << cacheLocation;
+                continue;
+            }
+
+            qDebug() << "Save to cache" << cacheLocation;
+            return true;
+        }
+
+        return false;
+    }
+}
+
+class GzipDataFile::Private
+{
+    public:
+        Private()
+            : indexData(0)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        const GzipIndexHeader *header() const
+        {
+            return reinterpret_cast<const GzipIndexHeader *>(indexData);
+        }
+
+        const GzipAccessPoint *points() const
+        {
+            return reinterpret_cast<const GzipAccessPoint *>(indexData + sizeof(GzipIndexHeader));
+        }
+
+        const char *window(int index) const
+        {
+            return indexData + sizeof(GzipIndexHeader) + header()->pointCount * sizeof(GzipAccessPoint)
+                + qint64(index) * windowSize;
+        }
+
+        bool loadIndex(const QString& fileName);
+        bool buildIndex();
+        void saveIndex(const QString& fileName);
+
+        MappedFile dataFile;
+
+        // Either the mapped cache file or the freshly built buffer
+        QFile indexFile;
+        QByteArray indexBuffer;
+        const char *indexData;
+};
+
+bool
+GzipDataFile::Private::loadIndex(const QString& fileName)
+{
+    QFileInfo fileInfo(fileName);
+
+    foreach (const QString& cacheLocation, IndexCache::cacheLocations(fileName, "gzidx"))
+    {
+        if (!QFile::exists(cacheLocation))
+            continue;
+
+        indexFile.close();
+        indexFile.setFileName(cacheLocation);
+        if (!indexFile.open(QIODevice::ReadOnly))
+        {
+            qDebug() << "Failed to open file:" << cacheLocation;
+            continue;
+        }
+
+        if (indexFile.size() < qint64(sizeof(GzipIndexHeader)))
+            continue;
+
+        const uchar *mappedData = indexFile.map(0, indexFile.size());
+        if (mappedData == NULL)
+        {
+            qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(cacheLocation);
+            continue;
+        }
+
+        const GzipIndexHeader *cachedHeader = reinterpret_cast<const GzipIndexHeader *>(mappedData);
+        if (qstrncmp(cachedHeader->magic, gzipIndexMagic, sizeof(cachedHeader->magic)) != 0
+                || cachedHeader->version != gzipIndexVersion
+                || ((cachedHeader->flags & gzipIndexNoWindows) == 0 && cachedHeader->spanSize != quint32(defaultSpanSize))
+                || cachedHeader->dataModified != fileInfo.lastModified().toMSecsSinceEpoch()
+                || cachedHeader->dataSize != dataFile.size()
+                || cachedHeader->pointCount == 0
+                || indexFile.size() != gzipIndexSize(cachedHeader->pointCount, cachedHeader->flags))
+        {
+            qDebug() << "Outdated cache file:" << cacheLocation;
+            indexFile.unmap(const_cast<uchar *>(mappedData));
+            continue;
+        }
+
+        indexData = reinterpret_cast<const char *>(mappedData);
+        return true;
+    }
+
+    indexFile.close();
+    return false;
+}
+
+bool
+GzipDataFile::Private::buildIndex()
+{
+    QVector<GzipAccessPoint> accessPoints;
+    QByteArray windows;
+    QByteArray window(windowSize, '\0');
+
+    z_stream zStream;
+    zStream.zalloc = NULL;
+    zStream.zfree = NULL;
+    zStream.opaque = NULL;
+    zStream.next_in = 0;
+    zStream.avail_in = 0;
+
+    // Inflate the gzip header as well, so the offsets are file positions
+    if (inflateInit2( &zStream, 15 + 32 ) != Z_OK)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot initialize inflation engine: %1").arg(zStream.msg);
+        return false;
+    }
+
+    QByteArray input;
+    quint64 position = 0;
+    quint64 totalIn = 0;
+    quint64 totalOut = 0;
+    quint64 lastOut = 0;
+    int status = Z_OK;
+
+    // Every member starts with an access point, so that no span crosses the
+    // end of a member, which the raw inflation of a span could not go past
+    bool memberStart = true;
+
+    zStream.avail_out = 0;
+    for (;;)
+    {
+        if (zStream.avail_in == 0)
+        {
+            input = dataFile.read(position, 1 << 20);
+            if (input.isEmpty())
+                break;
+
+            zStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.constData()));
+            zStream.avail_in = input.size();
+            position += input.size();
+        }
+
+        // The output cycles through the window, so the last 32 KB of the
+        // uncompressed data are always at hand
+        if (zStream.avail_out == 0)
+        {
+            zStream.next_out = reinterpret_cast<Bytef *>(window.data());
+            zStream.avail_out = windowSize;
+        }
+
+        totalIn += zStream.avail_in;
+        totalOut += zStream.avail_out;
+        status = inflate( &zStream, Z_BLOCK );
+        totalIn -= zStream.avail_in;
+        totalOut -= zStream.avail_out;
+
+        if (status == Z_STREAM_END)
+        {
+            // Concatenated gzip members, as written by pigz for instance,
+            // anything else after the last member is ignored like gzip does
+            QByteArray magic = dataFile.read(totalIn, 2);
+            if (magic.size() < 2 || uchar(magic.at(0)) != 0x1f || uchar(magic.at(1)) != 0x8b)
+                break;
+
+            inflateReset( &zStream );
+            status = Z_OK;
+            memberStart = true;
+            continue;
+        }
+
+        if (status != Z_OK && status != Z_BUF_ERROR)
+        {
+            qWarning() << Q_FUNC_INFO << QString("inflate: %1").arg(zStream.msg);
+            break;
+        }
+
+        // The access point of an empty member gives way to the next member
+        if (memberStart && (zStream.data_type & 128) && !accessPoints.isEmpty() && accessPoints.last().out == totalOut)
+        {
+            accessPoints.removeLast();
+            windows.chop(windowSize);
+        }
+
+        // At the end of the gzip header of a member, or at the end of a
+        // deflate block, but not the last one
+        if ((zStream.data_type & 128) && !(zStream.data_type & 64)
+                && (memberStart || totalOut - lastOut > quint64(defaultSpanSize)))
+        {
+            GzipAccessPoint accessPoint;
+            accessPoint.out = totalOut;
+            accessPoint.in = totalIn;
+            accessPoint.bits = zStream.data_type & 7;
+            accessPoint.reserved = 0;
+            accessPoints.append(accessPoint);
+
+            int left = zStream.avail_out;
+            windows.append(window.constData() + windowSize - left, left);
+            windows.append(window.constData(), windowSize - left);
+
+            lastOut = totalOut;
+        }
+
+        if (zStream.data_type & 128)
+            memberStart = false;
+    }
+
+    inflateEnd( &zStream );
+
+    if (status != Z_STREAM_END || accessPoints.isEmpty())
+    {
+        qWarning() << Q_FUNC_INFO << "Cannot index the truncated or corrupt gzip file";
+        return false;
+    }
+
+    GzipIndexHeader indexHeader;
+    memset(&indexHeader, 0, sizeof(indexHeader));
+    qstrncpy(indexHeader.magic, gzipIndexMagic, sizeof(indexHeader.magic));
+    indexHeader.version = gzipIndexVersion;
+    indexHeader.pointCount = accessPoints.size();
+    indexHeader.spanSize = defaultSpanSize;
+    indexHeader.dataSize = dataFile.size();
+    indexHeader.uncompressedSize = totalOut;
+
+    indexBuffer.reserve(gzipIndexSize(indexHeader.pointCount, indexHeader.flags));
+    indexBuffer.append(reinterpret_cast<const char *>(&indexHeader), sizeof(indexHeader));
+    indexBuffer.append(reinterpret_cast<const char *>(accessPoints.constData()), accessPoints.size() * sizeof(GzipAccessPoint));
+    indexBuffer.append(windows);
+
+    indexData = indexBuffer.constData();
+    return true;
+}
+
+void
+GzipDataFile::Private::saveIndex(const QString& fileName)
+{
+    writeIndex(fileName, indexBuffer);
+    indexData = indexBuffer.constData();
+}
+
+GzipDataFile::GzipDataFile()
+    : d(new Private)
+{
+}
+
+GzipDataFile::~GzipDataFile()
+{
+    close();
+    delete d;
+}
+
+int
+GzipDataFile::spanSize()
+{
+    return defaultSpanSize;
+}
+
+bool
+GzipDataFile::saveFlushedIndex(const QString& fileName, const QVector<quint64>& chunkStarts,
+                               const QVector<quint64>& chunkOffsets, quint64 uncompressedSize)
+{
+    if (chunkStarts.isEmpty() || chunkStarts.size() != chunkOffsets.size() || chunkStarts.first() != 0)
+    {
+        qWarning() << Q_FUNC_INFO << "Invalid chunk table";
+        return false;
+    }
+
+    GzipIndexHeader indexHeader;
+    memset(&indexHeader, 0, sizeof(indexHeader));
+    qstrncpy(indexHeader.magic, gzipIndexMagic, sizeof(indexHeader.magic));
+    indexHeader.version = gzipIndexVersion;
+    indexHeader.pointCount = chunkStarts.size();
+    indexHeader.spanSize = uncompressedSize / chunkStarts.size();
+    indexHeader.flags = gzipIndexNoWindows;
+    indexHeader.dataSize = QFileInfo(fileName).size();
+    indexHeader.uncompressedSize = uncompressedSize;
+
+    QByteArray indexBuffer;
+    indexBuffer.reserve(gzipIndexSize(indexHeader.pointCount, indexHeader.flags));
+    indexBuffer.append(reinterpret_cast<const char *>(&indexHeader), sizeof(indexHeader));
+
+    for (int i = 0; i < chunkStarts.size(); ++i)
+    {
+        GzipAccessPoint accessPoint;
+        accessPoint.out = chunkStarts.at(i);
+        accessPoint.in = chunkOffsets.at(i);
+        accessPoint.bits = 0;
+        accessPoint.reserved = 0;
+        indexBuffer.append(reinterpret_cast<const char *>(&accessPoint), sizeof(accessPoint));
+    }
+
+    return writeIndex(fileName, indexBuffer);
+}
+
+bool
+GzipDataFile::open(const QString& fileName)
+{
+    close();
+
+    if (!d->dataFile.open(fileName))
+        return false;
+
+    QByteArray magic = d->dataFile.read(0, 2);
+    if (magic.size() < 2 || uchar(magic.at(0)) != 0x1f || uchar(magic.at(1)) != 0x8b)
+    {
+        qDebug() << Q_FUNC_INFO << QString("\"%1\" not in gzip format").arg(fileName);
+        close();
+        return false;
+    }
+
+    if (d->loadIndex(fileName))
+        return true;
+
+    if (!d->buildIndex())
+    {
+        close();
+        return false;
+    }
+
+    d->saveIndex(fileName);
+    return true;
+}
+
+void
+GzipDataFile::close()
+{
+    removeCachedChunks();
+
+    d->indexData = 0;
+    d->indexBuffer.clear();
+    d->indexFile.close();
+    d->dataFile.close();
+}
+
+QByteArray
+GzipDataFile::read(quint64 start, unsigned long size, QByteArray *chunk)
+{
+    if (!d->indexData)
+        return QByteArray();
+
+    return readChunks(start, size, chunk);
+}
+
+int
+GzipDataFile::chunkCount() const
+{
+    return d->indexData ? d->header()->pointCount : 0;
+}
+
+quint64
+GzipDataFile::chunkStart(int index) const
+{
+    if (index >= chunkCount())
+        return d->indexData ? d->header()->uncompressedSize : 0;
+
+    return d->points()[index].out;
+}
+
+QByteArray
+GzipDataFile::decodeChunk(int index)
+{
+    const GzipAccessPoint& accessPoint = d->points()[index];
+    quint64 outputSize = chunkStart(index + 1) - accessPoint.out;
+
+    if (accessPoint.in > d->dataFile.size() || (accessPoint.bits && accessPoint.in == 0))
+        return QByteArray();
+
+    // The access point may be in the middle of a byte
+    QByteArray previousByte;
+    if (accessPoint.bits)
+    {
+        previousByte = d->dataFile.read(accessPoint.in - 1, 1);
+        if (previousByte.size() != 1)
+            return QByteArray();
+    }
+
+    z_stream zStream;
+    zStream.zalloc = NULL;
+    zStream.zfree = NULL;
+    zStream.opaque = NULL;
+    zStream.next_in = 0;
+    zStream.avail_in = 0;
+
+    if (inflateInit2( &zStream, -15 ) != Z_OK)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot initialize inflation engine: %1").arg(zStream.msg);
+        return QByteArray();
+    }
+
+    if (accessPoint.bits)
+        inflatePrime( &zStream, accessPoint.bits, uchar(previousByte.at(0)) >> (8 - accessPoint.bits) );
+
+    if (accessPoint.out != 0 && (d->header()->flags & gzipIndexNoWindows) == 0)
+        inflateSetDictionary( &zStream, reinterpret_cast<const Bytef *>(d->window(index)), windowSize );
+
+    QByteArray result;
+    result.resize(outputSize);
+
+    zStream.next_out = reinterpret_cast<Bytef *>(result.data());
+    zStream.avail_out = outputSize;
+
+    // The input is taken in slices, which are only copied if the file is
+    // not mapped
+    QByteArray input;
+    quint64 position = accessPoint.in;
+    int status = Z_OK;
+    while (zStream.avail_out != 0 && status == Z_OK)
+    {
+        if (zStream.avail_in == 0)
+        {
+            input = d->dataFile.read(position, 1 << 16);
+            if (input.isEmpty())
+                break;
+
+            zStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.constData()));
+            zStream.avail_in = input.size();
+            position += input.size();
+        }
+
+        status = inflate( &zStream, Z_NO_FLUSH );
+    }
+
+    inflateEnd( &zStream );
+
+    if (zStream.avail_out != 0)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot inflate the span at %1").arg(accessPoint.out);
+        return QByteArray();
+    }
+
+    return result;
+}
+
+void
+GzipDataFile::setAccessPattern(AccessPattern accessPattern)
+{
+    adviseMapping(d->dataFile.data(), d->dataFile.size(), accessPattern);
+}
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_GZIPDATAFILE_H
+#define MULA_PLUGIN_STARDICT_GZIPDATAFILE_H
+
+#include "abstractdatafile.h"
+
+#include <QtCore/QVector>
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Random access reader of the plain gzip ".dict.gz" files
+     *
+     * Unlike dictzip, plain gzip files have no chunk table. The whole file is
+     * inflated once, and an access point is recorded at the first deflate
+     * block boundary after every spanSize() bytes of the uncompressed data,
+     * together with the preceding 32 KB of the output that the following
+     * data may refer to. A span between two access points can then be
+     * inflated on its own. The access points are cached next to the ".oft"
+     * files of the index, see IndexCache::cacheLocations().
+     *
+     * The members of multi-member gzip files are inflated one after the
+     * other, and every member starts with an access point.
+     *
+     * \see DictionaryZip
+     */
+
+    class GzipDataFile : public AbstractDataFile
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            GzipDataFile();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~GzipDataFile();
+
+            /**
+             * Opens the gzip file, and builds its access points unless they
+             * are cached already
+             *
+             * @param   fileName    The complete file path of the gzip file
+             *
+             * @return True if the file was opened successfully, otherwise
+             * false.
+             */
+
+            bool open(const QString& fileName);
+
+            void close();
+
+            QByteArray read(quint64 start, unsigned long size, QByteArray *chunk = 0);
+
+            /**
+             * Returns the distance of the access points in the uncompressed
+             * data
+             *
+             * @return The span size in bytes
+             */
+
+            static int spanSize();
+
+            /**
+             * Writes the access points of a gzip file whose deflate stream was
+             * flushed with Z_FULL_FLUSH at the start of every chunk. Such
+             * chunks do not refer to the preceding data, so no windows are
+             * stored, and the chunks may be of any size, e.g. aligned to the
+             * articles. The file is not inflated.
+             *
+             * @param   fileName        The complete file path of the gzip file
+             * @param   chunkStarts     The uncompressed offsets of the chunks,
+             * the first one being 0
+             * @param   chunkOffsets    The file positions of the chunks
+             * @param   uncompressedSize    The uncompressed size of the file
+             *
+             * @return True if the access points were written successfully,
+             * otherwise false.
+             */
+
+            static bool saveFlushedIndex(const QString& fileName, const QVector<quint64>& chunkStarts,
+                                         const QVector<quint64>& chunkOffsets, quint64 uncompressedSize);
+
+            int chunkCount() const;
+            quint64 chunkStart(int index) const;
+            void setAccessPattern(AccessPattern accessPattern);
+
+        protected:
+            QByteArray decodeChunk(int index);
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_GZIPDATAFILE_H
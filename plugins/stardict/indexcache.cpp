@@ -0,0 +1,612 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "indexcache.h"
+
+#include "file.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDir>
+#include <QtCore/QSaveFile>
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+#include <QtCore/QStandardPaths>
+
+#include <string.h>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    const char cacheMagic[] = "Mula's StarDict offset cache";
+    const quint32 cacheVersion = 4;
+    const quint32 cacheByteOrderMark = 0x01020304;
+
+    enum CacheFlags {
+        WideOffsets = 0x1,
+        SynonymEntries = 0x2,
+        WideDataOffsets = 0x4,
+    };
+
+    struct CacheHeader
+    {
+        char magic[32];
+        quint32 version;
+        quint32 byteOrderMark;
+        quint32 flags;
+        quint32 wordCount;
+        quint32 pageEntryNumber;
+        quint32 pageCount;
+        qint64 indexModified;
+        quint64 indexSize;
+        quint64 indexDataSize;
+        quint64 collationKeyDataSize;
+        quint64 pageKeyDataSize;
+    };
+
+    qint64
+    cacheFileSize(const CacheHeader *header)
+    {
+        qint64 offsetSize = (header->flags & WideOffsets) ? sizeof(quint64) : sizeof(quint32);
+        qint64 wordCount = header->wordCount;
+        return sizeof(CacheHeader) + (3 * wordCount + header->pageCount + 3) * offsetSize + wordCount * sizeof(quint32)
+               + header->collationKeyDataSize + header->pageKeyDataSize;
+    }
+
+    template <typename T>
+    uchar*
+    writeNumbers(uchar *destination, const QVector<quint64>& numbers)
+    {
+        T *result = reinterpret_cast<T *>(destination);
+        foreach (quint64 number, numbers)
+            *result++ = number;
+
+        return reinterpret_cast<uchar *>(result);
+    }
+}
+
+class IndexCache::Private
+{
+    public:
+        Private()
+            : mappedData(0)
+            , keyOffsets(0)
+            , dataOffsets(0)
+            , collationKeyOffsets(0)
+            , dataSizes(0)
+            , collationKeys(0)
+            , pageKeyOffsets(0)
+            , pageKeys(0)
+            , wideOffsets(false)
+            , wordCount(0)
+            , pageEntryNumber(defaultPageEntryNumber)
+            , pageCount(0)
+            , synonymFile(false)
+            , indexOffsetBits(32)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        void reset()
+        {
+            if (mappedData)
+                mapFile.unmap(mappedData);
+
+            mappedData = 0;
+            mapFile.close();
+            buffer.clear();
+
+            keyOffsets = 0;
+            dataOffsets = 0;
+            collationKeyOffsets = 0;
+            dataSizes = 0;
+            collationKeys = 0;
+            pageKeyOffsets = 0;
+            pageKeys = 0;
+            wordCount = 0;
+            pageCount = 0;
+        }
+
+        void setTables(const uchar *data)
+        {
+            const CacheHeader *header = reinterpret_cast<const CacheHeader *>(data);
+            wideOffsets = header->flags & WideOffsets;
+            wordCount = header->wordCount;
+            pageCount = header->pageCount;
+
+            int offsetSize = wideOffsets ? sizeof(quint64) : sizeof(quint32);
+            keyOffsets = data + sizeof(CacheHeader);
+            dataOffsets = keyOffsets + (wordCount + 1) * offsetSize;
+            collationKeyOffsets = dataOffsets + wordCount * offsetSize;
+            pageKeyOffsets = collationKeyOffsets + (wordCount + 1) * offsetSize;
+            dataSizes = pageKeyOffsets + (pageCount + 1) * offsetSize;
+            collationKeys = reinterpret_cast<const char *>(dataSizes + wordCount * sizeof(quint32));
+            pageKeys = collationKeys + header->collationKeyDataSize;
+        }
+
+        quint64 offset(const uchar *table, long index) const
+        {
+            if (wideOffsets)
+                return reinterpret_cast<const quint64 *>(table)[index];
+
+            return reinterpret_cast<const quint32 *>(table)[index];
+        }
+
+        QByteArray key(const uchar *offsetTable, const char *keys, long index) const
+        {
+            quint64 keyOffset = offset(offsetTable, index);
+            return QByteArray::fromRawData(keys + keyOffset, offset(offsetTable, index + 1) - keyOffset);
+        }
+
+        static const int defaultPageEntryNumber = 32;
+
+        // The '\0' terminator of the word, and then the offset and the size,
+        // or the index of the original word entry in the synonym files
+        int wordEntryTailSize() const
+        {
+            if (synonymFile)
+                return 1 + sizeof(quint32);
+
+            return 1 + dataOffsetSize() + sizeof(quint32);
+        }
+
+        int dataOffsetSize() const
+        {
+            return indexOffsetBits == 64 ? sizeof(quint64) : sizeof(quint32);
+        }
+
+        QFile mapFile;
+        uchar *mappedData;
+
+        // The table is built into this buffer if it is not mapped
+        QByteArray buffer;
+
+        // The word entries parsed so far while building the table
+        QVector<quint64> pendingKeyOffsets;
+        QVector<quint64> pendingDataOffsets;
+        QVector<quint64> pendingDataSizes;
+        QVector<quint64> pendingCollationKeyOffsets;
+        QByteArray pendingCollationKeys;
+
+        const uchar *keyOffsets;
+        const uchar *dataOffsets;
+        const uchar *collationKeyOffsets;
+        const uchar *dataSizes;
+        const char *collationKeys;
+        const uchar *pageKeyOffsets;
+        const char *pageKeys;
+        bool wideOffsets;
+        long wordCount;
+        int pageEntryNumber;
+        long pageCount;
+        bool synonymFile;
+        int indexOffsetBits;
+};
+
+IndexCache::IndexCache()
+    : d(new Private)
+{
+}
+
+IndexCache::~IndexCache()
+{
+    delete d;
+}
+
+QStringList
+IndexCache::cacheLocations(const QString& indexFilePath, const QString& extension)
+{
+    QStringList result;
+    result.append(indexFilePath + '.' + extension);
+
+    QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "stardict";
+    if (!QDir().mkpath(cacheLocation))
+        return result;
+
+    // Dictionaries with the same file name in different folders must not
+    // share the same cache file
+    QFileInfo indexFileInfo(indexFilePath);
+    result.append(cacheLocation + QDir::separator() + indexFileInfo.fileName()
+                  + QString(".%1.%2").arg(qHash(indexFileInfo.absoluteFilePath()), 0, 16).arg(extension));
+    return result;
+}
+
+bool
+IndexCache::load(const QString& indexFilePath)
+{
+    QFileInfo indexFileInfo(indexFilePath);
+
+    foreach (const QString& cacheLocation, cacheLocations(indexFilePath))
+    {
+        if (!QFile::exists(cacheLocation))
+            continue;
+
+        d->reset();
+        d->mapFile.setFileName(cacheLocation);
+        if (!d->mapFile.open(QIODevice::ReadOnly))
+        {
+            qDebug() << "Failed to open file:" << cacheLocation;
+            continue;
+        }
+
+        if (d->mapFile.size() < qint64(sizeof(CacheHeader)))
+            continue;
+
+        d->mappedData = d->mapFile.map(0, d->mapFile.size());
+        if (d->mappedData == NULL)
+        {
+            qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(cacheLocation);
+            continue;
+        }
+
+        const CacheHeader *header = reinterpret_cast<const CacheHeader *>(d->mappedData);
+        if (qstrncmp(header->magic, cacheMagic, sizeof(header->magic)) != 0
+                || header->version != cacheVersion
+                || header->byteOrderMark != cacheByteOrderMark
+                || header->indexModified != indexFileInfo.lastModified().toMSecsSinceEpoch()
+                || header->indexSize != quint64(indexFileInfo.size())
+                || header->pageEntryNumber != quint32(d->pageEntryNumber)
+                || bool(header->flags & SynonymEntries) != d->synonymFile
+                || bool(header->flags & WideDataOffsets) != (d->indexOffsetBits == 64)
+                || d->mapFile.size() != cacheFileSize(header))
+        {
+            qDebug() << "Outdated cache file:" << cacheLocation;
+            continue;
+        }
+
+        d->setTables(d->mappedData);
+        return true;
+    }
+
+    d->reset();
+    return false;
+}
+
+bool
+IndexCache::save(const QString& indexFilePath)
+{
+    if (d->buffer.isEmpty())
+        return false;
+
+    QFileInfo indexFileInfo(indexFilePath);
+    CacheHeader *header = reinterpret_cast<CacheHeader *>(d->buffer.data());
+    header->indexModified = indexFileInfo.lastModified().toMSecsSinceEpoch();
+    header->indexSize = indexFileInfo.size();
+
+    foreach (const QString& cacheLocation, cacheLocations(indexFilePath))
+    {
+        // Other processes may have the old cache file mapped, so it is
+        // replaced by renaming a new file over it instead of truncating it
+        QSaveFile file(cacheLocation);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            qDebug() << "Failed to open file for writing:" << cacheLocation;
+            continue;
+        }
+
+        if (file.write(d->buffer) != d->buffer.size() || !file.commit())
+        {
+            qDebug() << "Failed to write the cache file:" << cacheLocation;
+            continue;
+        }
+
+        qDebug() << "Save to cache" << cacheLocation;
+        return true;
+    }
+
+    return false;
+}
+
+void
+IndexCache::build(const char *indexData, qint64 indexDataSize)
+{
+    beginBuild();
+    endBuild(addEntries(indexData, 0, indexDataSize));
+}
+
+void
+IndexCache::beginBuild()
+{
+    d->reset();
+
+    d->pendingKeyOffsets.clear();
+    d->pendingDataOffsets.clear();
+    d->pendingDataSizes.clear();
+    d->pendingCollationKeyOffsets.clear();
+    d->pendingCollationKeys.clear();
+}
+
+qint64
+IndexCache::addEntries(const char *indexData, qint64 position, qint64 indexDataSize)
+{
+    int wordEntryTailSize = d->wordEntryTailSize();
+    bool isWideDataOffset = !d->synonymFile && d->indexOffsetBits == 64;
+
+    while (position < indexDataSize)
+    {
+        const char *word = indexData + position;
+        const char *wordEnd = static_cast<const char *>(memchr(word, '\0', indexDataSize - position));
+
+        // The rest of the entry has not been read yet
+        if (!wordEnd || wordEnd - indexData + wordEntryTailSize > indexDataSize)
+            break;
+
+        const uchar *tail = reinterpret_cast<const uchar *>(wordEnd + 1);
+        d->pendingKeyOffsets.append(position);
+        if (isWideDataOffset)
+        {
+            d->pendingDataOffsets.append(qFromBigEndian<quint64>(tail));
+            d->pendingDataSizes.append(qFromBigEndian<quint32>(tail + sizeof(quint64)));
+        }
+        else
+        {
+            d->pendingDataOffsets.append(qFromBigEndian<quint32>(tail));
+            d->pendingDataSizes.append(d->synonymFile ? 0 : qFromBigEndian<quint32>(tail + sizeof(quint32)));
+        }
+        d->pendingCollationKeyOffsets.append(d->pendingCollationKeys.size());
+        d->pendingCollationKeys.append(stardictCollationKey(word, wordEnd - word));
+
+        position = wordEnd - indexData + wordEntryTailSize;
+    }
+
+    return position;
+}
+
+void
+IndexCache::endBuild(qint64 indexDataSize)
+{
+    QVector<quint64> keyOffsets = d->pendingKeyOffsets;
+    keyOffsets.append(indexDataSize);
+
+    QVector<quint64> collationKeyOffsets = d->pendingCollationKeyOffsets;
+    collationKeyOffsets.append(d->pendingCollationKeys.size());
+
+    // The page directory holds the shortest prefix of the first key of every
+    // page that is still greater than the last key of the previous page. The
+    // first page gets an empty key, so every word falls onto some page.
+    quint32 wordCount = d->pendingDataSizes.size();
+    quint32 pageCount = wordCount ? (wordCount - 1) / d->pageEntryNumber + 1 : 0;
+    QVector<quint64> pageKeyOffsets;
+    QByteArray pageKeys;
+
+    pageKeyOffsets.reserve(pageCount + 1);
+    for (quint32 pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+    {
+        pageKeyOffsets.append(pageKeys.size());
+        if (pageIndex == 0)
+            continue;
+
+        quint32 index = pageIndex * d->pageEntryNumber;
+        const char *previousKey = d->pendingCollationKeys.constData() + collationKeyOffsets.at(index - 1);
+        const char *pageKey = d->pendingCollationKeys.constData() + collationKeyOffsets.at(index);
+        int previousKeyLength = collationKeyOffsets.at(index) - collationKeyOffsets.at(index - 1);
+        int pageKeyLength = collationKeyOffsets.at(index + 1) - collationKeyOffsets.at(index);
+
+        int prefixLength = 0;
+        while (prefixLength < previousKeyLength && prefixLength < pageKeyLength
+               && previousKey[prefixLength] == pageKey[prefixLength])
+            ++prefixLength;
+
+        pageKeys.append(pageKey, qMin(prefixLength + 1, pageKeyLength));
+    }
+
+    pageKeyOffsets.append(pageKeys.size());
+
+    CacheHeader cacheHeader;
+    memset(&cacheHeader, 0, sizeof(cacheHeader));
+    qstrncpy(cacheHeader.magic, cacheMagic, sizeof(cacheHeader.magic));
+    cacheHeader.version = cacheVersion;
+    cacheHeader.byteOrderMark = cacheByteOrderMark;
+    cacheHeader.wordCount = wordCount;
+    cacheHeader.pageEntryNumber = d->pageEntryNumber;
+    cacheHeader.pageCount = pageCount;
+    cacheHeader.indexDataSize = indexDataSize;
+    cacheHeader.collationKeyDataSize = d->pendingCollationKeys.size();
+    cacheHeader.pageKeyDataSize = pageKeys.size();
+
+    // The tables only use 64-bits numbers if any of the offsets needs them
+    quint64 maximumDataOffset = 0;
+    foreach (quint64 dataOffset, d->pendingDataOffsets)
+        maximumDataOffset = qMax(maximumDataOffset, dataOffset);
+
+    bool wideOffsets = quint64(indexDataSize) > 0xffffffffUL
+                       || cacheHeader.collationKeyDataSize > 0xffffffffUL
+                       || maximumDataOffset > 0xffffffffUL;
+    if (wideOffsets)
+        cacheHeader.flags |= WideOffsets;
+
+    if (d->indexOffsetBits == 64)
+        cacheHeader.flags |= WideDataOffsets;
+
+    if (d->synonymFile)
+        cacheHeader.flags |= SynonymEntries;
+
+    d->buffer.fill('\0', cacheFileSize(&cacheHeader));
+    memcpy(d->buffer.data(), &cacheHeader, sizeof(cacheHeader));
+
+    uchar *tables = reinterpret_cast<uchar *>(d->buffer.data()) + sizeof(CacheHeader);
+    if (wideOffsets)
+    {
+        tables = writeNumbers<quint64>(tables, keyOffsets);
+        tables = writeNumbers<quint64>(tables, d->pendingDataOffsets);
+        tables = writeNumbers<quint64>(tables, collationKeyOffsets);
+        tables = writeNumbers<quint64>(tables, pageKeyOffsets);
+    }
+    else
+    {
+        tables = writeNumbers<quint32>(tables, keyOffsets);
+        tables = writeNumbers<quint32>(tables, d->pendingDataOffsets);
+        tables = writeNumbers<quint32>(tables, collationKeyOffsets);
+        tables = writeNumbers<quint32>(tables, pageKeyOffsets);
+    }
+
+    tables = writeNumbers<quint32>(tables, d->pendingDataSizes);
+    memcpy(tables, d->pendingCollationKeys.constData(), d->pendingCollationKeys.size());
+    memcpy(tables + d->pendingCollationKeys.size(), pageKeys.constData(), pageKeys.size());
+
+    d->pendingKeyOffsets.clear();
+    d->pendingDataOffsets.clear();
+    d->pendingDataSizes.clear();
+    d->pendingCollationKeyOffsets.clear();
+    d->pendingCollationKeys.clear();
+
+    d->setTables(reinterpret_cast<const uchar *>(d->buffer.constData()));
+}
+
+long
+IndexCache::wordCount() const
+{
+    return d->wordCount;
+}
+
+quint64
+IndexCache::keyOffset(long index) const
+{
+    return d->offset(d->keyOffsets, index);
+}
+
+int
+IndexCache::keyLength(long index) const
+{
+    return d->offset(d->keyOffsets, index + 1) - d->offset(d->keyOffsets, index) - d->wordEntryTailSize();
+}
+
+quint64
+IndexCache::dataOffset(long index) const
+{
+    return d->offset(d->dataOffsets, index);
+}
+
+quint32
+IndexCache::dataSize(long index) const
+{
+    return reinterpret_cast<const quint32 *>(d->dataSizes)[index];
+}
+
+QByteArray
+IndexCache::collationKey(long index) const
+{
+    return d->key(d->collationKeyOffsets, d->collationKeys, index);
+}
+
+void
+IndexCache::setPageEntryNumber(int pageEntryNumber)
+{
+    d->pageEntryNumber = qMax(pageEntryNumber, 1);
+}
+
+int
+IndexCache::pageEntryNumber() const
+{
+    return d->pageEntryNumber;
+}
+
+void
+IndexCache::setSynonymFile(bool synonymFile)
+{
+    d->synonymFile = synonymFile;
+}
+
+bool
+IndexCache::isSynonymFile() const
+{
+    return d->synonymFile;
+}
+
+void
+IndexCache::setIndexOffsetBits(int indexOffsetBits)
+{
+    d->indexOffsetBits = indexOffsetBits == 64 ? 64 : 32;
+}
+
+int
+IndexCache::indexOffsetBits() const
+{
+    return d->indexOffsetBits;
+}
+
+long
+IndexCache::pageCount() const
+{
+    return d->pageCount;
+}
+
+int
+IndexCache::lookup(const QByteArray& word, int *nextIndex) const
+{
+    if (d->wordCount == 0)
+    {
+        if (nextIndex)
+            *nextIndex = 0;
+
+        return -1;
+    }
+
+    QByteArray wordCollationKey = stardictCollationKey(word);
+
+    // Find the last page whose directory key is not greater than the word.
+    // The directory is small and contiguous, so this hardly touches memory.
+    long pageFrom = 1;
+    long pageTo = d->pageCount - 1;
+
+    while (pageFrom <= pageTo)
+    {
+        long pageThisIndex = (pageFrom + pageTo) / 2;
+        if (stardictCollationKeyCompare(wordCollationKey, d->key(d->pageKeyOffsets, d->pageKeys, pageThisIndex)) >= 0)
+            pageFrom = pageThisIndex + 1;
+        else
+            pageTo = pageThisIndex - 1;
+    }
+
+    // Binary search on the page
+    long indexFrom = pageTo * d->pageEntryNumber;
+    long indexTo = qMin<long>(indexFrom + d->pageEntryNumber, d->wordCount) - 1;
+
+    while (indexFrom <= indexTo)
+    {
+        long indexThisIndex = (indexFrom + indexTo) / 2;
+        int cmpint = stardictCollationKeyCompare(wordCollationKey, collationKey(indexThisIndex));
+        if (cmpint > 0)
+        {
+            indexFrom = indexThisIndex + 1;
+        }
+        else if (cmpint < 0)
+        {
+            indexTo = indexThisIndex - 1;
+        }
+        else
+        {
+            if (nextIndex)
+                *nextIndex = indexThisIndex;
+
+            return indexThisIndex;
+        }
+    }
+
+    if (nextIndex)
+        *nextIndex = indexFrom;
+
+    return -1;
+}
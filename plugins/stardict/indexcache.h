@@ -0,0 +1,364 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_INDEXCACHE_H
+#define MULA_PLUGIN_STARDICT_INDEXCACHE_H
+
+#include <QtCore/QStringList>
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Persistent table of the word entry offsets of an index file
+     *
+     * The cache holds a dense table with the position of every word entry
+     * inside the index data, and the offset and the size of the word data in
+     * the ".dict" file. Thereby any word entry can be accessed in constant
+     * time without parsing the index file again. It also holds the collation
+     * key of every word, so the words can be compared by a single memcmp()
+     * while looking up.
+     *
+     * The word entries are grouped into pages of "pageEntryNumber" entries,
+     * and the cache has a page directory with a short separator key for
+     * every page. A lookup binary searches the small page directory first,
+     * and then the collation keys of a single page.
+     *
+     * The cache is stored in a versioned ".oft" file next to the index file,
+     * or in the ${CACHE_LOCATION}/stardict/ folder if the dictionary folder is
+     * not writable. The file is memory mapped when loaded. It is validated
+     * against the modification time and the size of the index file, and it is
+     * rebuilt whenever it does not match. The file layout is the following,
+     * all the numbers are stored in the byte order of the machine:
+     *
+     * =====
+     * header:      magic, version, byte order mark, flags, word count,
+     *              page entry number, page count, index file modification
+     *              time, index file size, the size of the (uncompressed)
+     *              index data, the size of the collation key data and the
+     *              size of the page directory keys
+     * key offsets: word count + 1 numbers, the last one is the index data size
+     * data offsets: word count numbers
+     * collation key offsets: word count + 1 numbers, the last one is the
+     *              collation key data size
+     * page key offsets: page count + 1 numbers, the last one is the size of
+     *              the page directory keys
+     * data sizes:  word count 32-bits numbers
+     * collation keys: the collation keys of the words one after another
+     * page keys:   the page directory keys one after another
+     * =====
+     *
+     * The offsets are 32-bits numbers, or 64-bits numbers if the flags say so.
+     * The 64-bits numbers are only used if any of the offsets needs them, for
+     * instance for the dictionaries with "idxoffsetbits=64" and a ".dict" file
+     * larger than 4 GB.
+     *
+     * The cache of a ".syn" synonym file has the same layout. The data offset
+     * holds the index of the original word entry in the index file, and the
+     * data size is always zero.
+     *
+     * \see OffsetCacheFile, IndexFile
+     */
+
+    class IndexCache
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            IndexCache();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~IndexCache();
+
+            /**
+             * Loads and maps the cache file belonging to the index file. The
+             * loading fails if there is no cache file, or the existing one is
+             * outdated.
+             *
+             * @param   indexFilePath   The complete file path of the index file
+             *
+             * @return True if the cache loading was successful, otherwise
+             * false.
+             *
+             * @see save, build
+             */
+
+            bool load(const QString& indexFilePath);
+
+            /**
+             * Saves the previously built table into the first writable cache
+             * location of the index file.
+             *
+             * @param   indexFilePath   The complete file path of the index file
+             *
+             * @return True if the cache saving was successful, otherwise
+             * false.
+             *
+             * @see load, build
+             */
+
+            bool save(const QString& indexFilePath);
+
+            /**
+             * Builds the table by parsing the whole index data once.
+             *
+             * @param   indexData       The (uncompressed) index data
+             * @param   indexDataSize   The size of the index data
+             *
+             * @see save
+             */
+
+            void build(const char *indexData, qint64 indexDataSize);
+
+            /**
+             * Starts building the table incrementally, while the index data
+             * is still being read or decompressed.
+             *
+             * @see addEntries, endBuild, build
+             */
+
+            void beginBuild();
+
+            /**
+             * Adds the complete word entries of the index data available so
+             * far to the table being built, starting from the given position.
+             *
+             * @param   indexData       The index data read so far
+             * @param   position        The position of the first entry to add
+             * @param   indexDataSize   The size of the index data read so far
+             *
+             * @return The position after the last complete word entry, which
+             * is the position to continue from with more data
+             *
+             * @see beginBuild, endBuild
+             */
+
+            qint64 addEntries(const char *indexData, qint64 position, qint64 indexDataSize);
+
+            /**
+             * Finishes building the table incrementally.
+             *
+             * @param   indexDataSize   The size of the whole index data
+             *
+             * @see beginBuild, addEntries, save
+             */
+
+            void endBuild(qint64 indexDataSize);
+
+            /**
+             * Returns the count of the word entries in the table
+             *
+             * @return The count of the word entries
+             */
+
+            long wordCount() const;
+
+            /**
+             * Returns the position of the word entry in the index data
+             *
+             * @param   index   The index of the desired word entry
+             *
+             * @return The position of the word entry
+             *
+             * @see keyLength
+             */
+
+            quint64 keyOffset(long index) const;
+
+            /**
+             * Returns the length of the word of the word entry without the
+             * terminating '\0'
+             *
+             * @param   index   The index of the desired word entry
+             *
+             * @return The length of the word
+             *
+             * @see keyOffset
+             */
+
+            int keyLength(long index) const;
+
+            /**
+             * Returns the offset of the word data in the ".dict" file
+             *
+             * @param   index   The index of the desired word entry
+             *
+             * @return The offset of the word data
+             *
+             * @see dataSize
+             */
+
+            quint64 dataOffset(long index) const;
+
+            /**
+             * Returns the size of the word data in the ".dict" file
+             *
+             * @param   index   The index of the desired word entry
+             *
+             * @return The size of the word data
+             *
+             * @see dataOffset
+             */
+
+            quint32 dataSize(long index) const;
+
+            /**
+             * Returns the collation key of the word of the word entry as
+             * returned by stardictCollationKey()
+             *
+             * \note The returned data does not own its bytes, it points into
+             * the table.
+             *
+             * @param   index   The index of the desired word entry
+             *
+             * @return The collation key of the word
+             */
+
+            QByteArray collationKey(long index) const;
+
+            /**
+             * Sets the number of the word entries on a page of the page
+             * directory. The cache files built with a different page entry
+             * number are considered outdated.
+             *
+             * \note It has to be set before loading or building the cache.
+             *
+             * @param   pageEntryNumber The number of the word entries on a page
+             *
+             * @see pageEntryNumber
+             */
+
+            void setPageEntryNumber(int pageEntryNumber);
+
+            /**
+             * Returns the number of the word entries on a page of the page
+             * directory, the default is 32.
+             *
+             * @return The number of the word entries on a page
+             *
+             * @see setPageEntryNumber
+             */
+
+            int pageEntryNumber() const;
+
+            /**
+             * Sets whether the index data comes from a ".syn" synonym file,
+             * whose word entries hold the index of the original word entry
+             * instead of the offset and the size of the word data. The cache
+             * files of the other kind are considered outdated.
+             *
+             * \note It has to be set before loading or building the cache.
+             *
+             * @param   synonymFile Whether the index data is a synonym file
+             *
+             * @see isSynonymFile
+             */
+
+            void setSynonymFile(bool synonymFile);
+
+            /**
+             * Returns whether the index data comes from a ".syn" synonym file
+             *
+             * @return True if the index data is a synonym file, otherwise
+             * false.
+             *
+             * @see setSynonymFile
+             */
+
+            bool isSynonymFile() const;
+
+            /**
+             * Sets the size of the data offsets in the word entries of the
+             * index data as given by the "idxoffsetbits" option of the ".ifo"
+             * file. The cache files built with a different size are
+             * considered outdated.
+             *
+             * \note It has to be set before loading or building the cache.
+             *
+             * @param   indexOffsetBits The size of the data offsets in bits,
+             * either 32 or 64
+             *
+             * @see indexOffsetBits
+             */
+
+            void setIndexOffsetBits(int indexOffsetBits);
+
+            /**
+             * Returns the size of the data offsets in the word entries of the
+             * index data, the default is 32.
+             *
+             * @return The size of the data offsets in bits
+             *
+             * @see setIndexOffsetBits
+             */
+
+            int indexOffsetBits() const;
+
+            /**
+             * Returns the count of the pages in the page directory
+             *
+             * @return The count of the pages
+             */
+
+            long pageCount() const;
+
+            /**
+             * Looks up the word by searching the page directory first and then
+             * the collation keys on the relevant page.
+             *
+             * @param   word        The utf-8 encoded word to look up
+             * @param   nextIndex   If not NULL, it is set to the index of the
+             * first word entry not less than the desired word
+             *
+             * @return The index of the word entry, or -1 if there is no such a
+             * word.
+             */
+
+            int lookup(const QByteArray& word, int *nextIndex = 0) const;
+
+            /**
+             * Returns a string list of the cache locations of the index file.
+             * The first location is next to the index file, the second one is
+             * in the ${CACHE_LOCATION}/stardict/ folder where the cache path is
+             * provided by the QStandardPaths class.
+             *
+             * \note The other files caching derived data, like the access
+             * points of the ".dict.gz" files, are stored at the same places
+             * with their own extension.
+             *
+             * @param   indexFilePath   The complete file path of the index file
+             * @param   extension       The extension of the cache file
+             *
+             * @return  List of the cache locations
+             */
+
+            static QStringList cacheLocations(const QString& indexFilePath, const QString& extension = QLatin1String("oft"));
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_INDEXCACHE_H
@@ -19,14 +19,16 @@
 
 #include "indexfile.h"
 
-#include "file.h"
-#include "wordentry.h"
+#include "indexcache.h"
 
 #include <QtCore/QDebug>
-#include <QtCore/QStringList>
 #include <QtCore/QFile>
 #include <QtCore/QtEndian>
 
+#include <zlib.h>
+
+#include <string.h>
+
 using namespace MulaPluginStarDict;
 
 class IndexFile::Private
@@ -40,7 +42,19 @@ class IndexFile::Private
         {
         }
 
-        QList<WordEntry> wordEntryList;
+        // The size of the blocks read from the compressed index file
+        static const int inflateBlockSize = 0x10000;
+
+        // The progress function is called after every that many blocks
+        static const int progressBlockCount = 16;
+
+        static const uchar gzipMagic1 = 0x1f;
+        static const uchar gzipMagic2 = 0x8b;
+
+        IndexCache indexCache;
+
+        // All the index data in one arena, the word entries point into it
+        QByteArray indexData;
 };
 
 IndexFile::IndexFile()
@@ -50,6 +64,7 @@ IndexFile::IndexFile()
 
 IndexFile::~IndexFile()
 {
+    delete d;
 }
 
 bool
@@ -62,60 +77,208 @@ IndexFile::load(const QString& filePath)
         return false;
     }
 
-    d->wordEntryList.clear();
-    char ch;
-    QByteArray data;
+    if (pageEntryNumber() > 0)
+        d->indexCache.setPageEntryNumber(pageEntryNumber());
+
+    d->indexCache.setIndexOffsetBits(indexOffsetBits());
+
+    bool isCacheLoaded = d->indexCache.load(filePath);
+    qint64 indexDataSize;
+
+    QByteArray magic = file.peek(2);
+    if (magic.size() == 2 && uchar(magic.at(0)) == d->gzipMagic1 && uchar(magic.at(1)) == d->gzipMagic2)
+    {
+        indexDataSize = inflateIndexData(file, isCacheLoaded);
+        if (indexDataSize < 0)
+            return false;
+    }
+    else
+    {
+        d->indexData = file.readAll();
+        indexDataSize = d->indexData.size();
+
+        if (!isCacheLoaded)
+            d->indexCache.build(d->indexData.constData(), indexDataSize);
+    }
+
+    file.close();
+
+    if (isCacheLoaded && d->indexCache.keyOffset(d->indexCache.wordCount()) != quint64(indexDataSize))
+    {
+        d->indexCache.build(d->indexData.constData(), indexDataSize);
+        isCacheLoaded = false;
+    }
+
+    if (!isCacheLoaded && !d->indexCache.save(filePath))
+        qDebug() << "Cache update failed";
+
+    return d->indexCache.wordCount() > 0;
+}
+
+qint64
+IndexFile::inflateIndexData(QFile& file, bool isCacheLoaded)
+{
+    // The last four bytes of a gzip file hold the uncompressed size of its
+    // last member modulo 2^32, which is a good guess for the size of the
+    // index data
+    QByteArray trailer;
+    if (file.seek(file.size() - sizeof(quint32)))
+        trailer = file.read(sizeof(quint32));
+
+    if (trailer.size() != int(sizeof(quint32)))
+    {
+        qWarning() << Q_FUNC_INFO << QString("Truncated gzip file: %1").arg(file.fileName());
+        return -1;
+    }
+
+    quint32 trailerSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(trailer.constData()));
+    qint64 capacity = qMax<qint64>(d->inflateBlockSize, trailerSize);
+
+    file.seek(0);
+
+    z_stream zStream;
+    memset(&zStream, 0, sizeof(zStream));
+
+    // Let zlib parse the gzip header and the trailer
+    if (inflateInit2(&zStream, 15 + 32) != Z_OK)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot initialize inflation engine: %1").arg(zStream.msg);
+        return -1;
+    }
+
+    if (!isCacheLoaded)
+        d->indexCache.beginBuild();
+
+    QByteArray inputBuffer(d->inflateBlockSize, Qt::Uninitialized);
+    d->indexData.resize(capacity);
 
-    while (!file.atEnd()) {
-        WordEntry wordEntry;
+    qint64 size = 0;
+    qint64 position = 0;
+    int blockCount = 0;
+    int result = Z_OK;
 
-        data.clear();
+    // The output size of the current and the last completed gzip member
+    qint64 memberStart = 0;
+    qint64 memberSize = -1;
 
-        forever {
-            if (file.read(&ch, 1) != -1) {
-                if (ch) {
-                    data.append(ch);
-                } else {
-                    break;
-                }
-            } else {
-                return false;
+    forever
+    {
+        if (zStream.avail_in == 0 && !file.atEnd())
+        {
+            qint64 readSize = file.read(inputBuffer.data(), inputBuffer.size());
+            if (readSize < 0)
+            {
+                qWarning() << Q_FUNC_INFO << QString("Cannot read %1").arg(file.fileName());
+                inflateEnd(&zStream);
+                return -1;
             }
+
+            zStream.next_in = reinterpret_cast<Bytef *>(inputBuffer.data());
+            zStream.avail_in = readSize;
+        }
+
+        if (size == d->indexData.size())
+            d->indexData.resize(d->indexData.size() * 2);
+
+        // Inflate directly into the arena of the index data
+        zStream.next_out = reinterpret_cast<Bytef *>(d->indexData.data()) + size;
+        zStream.avail_out = d->indexData.size() - size;
+
+        result = inflate(&zStream, Z_NO_FLUSH);
+        size = d->indexData.size() - zStream.avail_out;
+
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+        {
+            qWarning() << Q_FUNC_INFO << QString("inflate: %1").arg(zStream.msg);
+            inflateEnd(&zStream);
+            return -1;
         }
 
-        wordEntry.setData(data);
+        // Parse the word entries while the freshly inflated data is still hot
+        if (!isCacheLoaded)
+            position = d->indexCache.addEntries(d->indexData.constData(), position, size);
 
-        wordEntry.setDataOffset(qFromBigEndian(*reinterpret_cast<quint32 *>(file.read(sizeof(quint32)).data())));
-        wordEntry.setDataSize(qFromBigEndian(*reinterpret_cast<quint32 *>(file.read(sizeof(quint32)).data())));
+        if (progressFunction() && ++blockCount % d->progressBlockCount == 0)
+            progressFunction()();
 
-        d->wordEntryList.append(wordEntry);
+        if (result == Z_STREAM_END)
+        {
+            memberSize = size - memberStart;
+            memberStart = size;
+
+            if (zStream.avail_in == 0 && file.atEnd())
+                break;
+
+            // Concatenated gzip members
+            inflateReset(&zStream);
+        }
+        else if (zStream.avail_in == 0 && zStream.avail_out != 0 && file.atEnd())
+        {
+            // The input ran out in the middle of a member
+            break;
+        }
     }
 
-    file.close();
+    inflateEnd(&zStream);
+
+    // A truncated file ends in the middle of a member, which must not be
+    // taken for the whole index, nor cached
+    if (result != Z_STREAM_END || quint32(memberSize) != trailerSize)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Truncated gzip file: %1").arg(file.fileName());
+        return -1;
+    }
+
+    d->indexData.resize(size);
+    d->indexData.squeeze();
 
-    return true;
+    if (!isCacheLoaded)
+        d->indexCache.endBuild(position);
+
+    return size;
+}
+
+long
+IndexFile::wordCount() const
+{
+    return d->indexCache.wordCount();
 }
 
 QByteArray
 IndexFile::key(long index)
 {
-    return d->wordEntryList.at(index).data();
+    setWordEntryOffset(d->indexCache.dataOffset(index));
+    setWordEntrySize(d->indexCache.dataSize(index));
+
+    return QByteArray::fromRawData(d->indexData.constData() + d->indexCache.keyOffset(index), d->indexCache.keyLength(index));
 }
 
-inline bool
-lessThanCompare(const QString string1, const QString string2)
+QByteArray
+IndexFile::keyData(long index)
 {
-    return stardictStringCompare(string1, string2) < 0;
+    return QByteArray::fromRawData(d->indexData.constData() + d->indexCache.keyOffset(index), d->indexCache.keyLength(index));
+}
+
+QByteArray
+IndexFile::collationKey(long index)
+{
+    return d->indexCache.collationKey(index);
 }
 
 int
-IndexFile::lookup(const QByteArray &word)
+IndexFile::lookup(const QByteArray &word, int *nextIndex)
 {
-    QStringList wordList;
-    foreach (const WordEntry &wordEntry, d->wordEntryList)
-        wordList.append(QString::fromUtf8(wordEntry.data()));
+    return d->indexCache.lookup(word, nextIndex);
+}
 
-    QStringList::iterator i = qBinaryFind(wordList.begin(), wordList.end(), QString::fromUtf8(word), lessThanCompare);
+quint64
+IndexFile::dataOffset(long index) const
+{
+    return d->indexCache.dataOffset(index);
+}
 
-    return i == wordList.end() ? -1 : i - wordList.begin();
+quint32
+IndexFile::dataSize(long index) const
+{
+    return d->indexCache.dataSize(index);
 }
@@ -22,8 +22,22 @@
 
 #include "abstractindexfile.h"
 
+class QFile;
+
 namespace MulaPluginStarDict
 {
+    /**
+     * \brief The class keeps the whole index data in memory
+     *
+     * It is used for the index files that cannot be mapped directly, like
+     * the compressed ".idx.gz" files. Those are inflated in large blocks into
+     * one contiguous buffer, and the word entries are parsed in place. The
+     * word entries are accessed through the dense offset table of the
+     * IndexCache class.
+     *
+     * \see OffsetCacheFile, IndexCache
+     */
+
     class IndexFile : public AbstractIndexFile
     {
         public:
@@ -44,15 +58,52 @@ namespace MulaPluginStarDict
 
             bool load(const QString& filePath);
 
+            /** Reimplemented from AbstractIndexFile::wordCount() */
+
+            long wordCount() const;
+
             /** Reimplemented from AbstractIndexFile::key() */
 
             QByteArray key(long index);
 
+            /** Reimplemented from AbstractIndexFile::keyData() */
+
+            QByteArray keyData(long index);
+
+            /** Reimplemented from AbstractIndexFile::collationKey() */
+
+            QByteArray collationKey(long index);
+
             /** Reimplemented from AbstractIndexFile::lookup() */
 
-            int lookup(const QByteArray& word);
+            int lookup(const QByteArray& word, int *nextIndex = 0);
+
+            /** Reimplemented from AbstractIndexFile::dataOffset() */
+
+            quint64 dataOffset(long index) const;
+
+            /** Reimplemented from AbstractIndexFile::dataSize() */
+
+            quint32 dataSize(long index) const;
 
         private:
+            /**
+             * Inflates the whole compressed index file into the index data in
+             * large blocks, and builds the offset table of the word entries
+             * on the fly, unless it has been loaded from the cache.
+             *
+             * \note This method is only for internal usage.
+             *
+             * @param   file            The opened ".idx.gz" file
+             * @param   isCacheLoaded   Whether the offset table is loaded
+             *
+             * @return The size of the index data, or -1 on error
+             *
+             * @see load
+             */
+
+            qint64 inflateIndexData(QFile& file, bool isCacheLoaded);
+
             class Private;
             Private *const d;
     };
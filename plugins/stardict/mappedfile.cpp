@@ -0,0 +1,135 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "mappedfile.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QString>
+
+using namespace MulaPluginStarDict;
+
+class MappedFile::Private
+{
+    public:
+        Private()
+            : data(0)
+            , size(0)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        QFile file;
+        const uchar *data;
+        quint64 size;
+
+        // Serializes the seek() and read() pairs if the file is not mapped
+        QMutex readMutex;
+};
+
+MappedFile::MappedFile()
+    : d(new Private)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+    delete d;
+}
+
+bool
+MappedFile::open(const QString& fileName)
+{
+    close();
+
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Failed to open file:" << fileName;
+        return false;
+    }
+
+    d->size = d->file.size();
+    if (d->size == 0)
+        return true;
+
+    d->data = d->file.map(0, d->size);
+    if (d->data == NULL)
+        qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed, reading it instead").arg(fileName);
+
+    return true;
+}
+
+void
+MappedFile::close()
+{
+    if (d->data)
+    {
+        d->file.unmap(const_cast<uchar *>(d->data));
+        d->data = 0;
+    }
+
+    d->size = 0;
+    d->file.close();
+}
+
+bool
+MappedFile::isOpen() const
+{
+    return d->file.isOpen();
+}
+
+quint64
+MappedFile::size() const
+{
+    return d->size;
+}
+
+const uchar*
+MappedFile::data() const
+{
+    return d->data;
+}
+
+QByteArray
+MappedFile::read(quint64 position, quint64 size)
+{
+    if (position >= d->size)
+        return QByteArray();
+
+    size = qMin(size, d->size - position);
+
+    if (d->data)
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(d->data + position), size);
+
+    QMutexLocker locker(&d->readMutex);
+    if (!d->file.seek(position))
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot seek to %1 in %2").arg(position).arg(d->file.fileName());
+        return QByteArray();
+    }
+
+    return d->file.read(size);
+}
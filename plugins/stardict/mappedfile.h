@@ -0,0 +1,119 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_MAPPEDFILE_H
+#define MULA_PLUGIN_STARDICT_MAPPEDFILE_H
+
+#include <QtCore/QByteArray>
+
+class QString;
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Read only file mapped into the memory as a whole
+     *
+     * Mapping the whole file works for files larger than 4 GB as long as the
+     * address space is large enough. If the mapping fails nevertheless, for
+     * instance on a 32-bits system or a file system without mmap() support,
+     * the file stays open and it is read with seek() and read() instead.
+     *
+     * \note read() is safe to call from several threads at once.
+     *
+     * \see PlainDataFile, GzipDataFile, ZstdDataFile
+     */
+
+    class MappedFile
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            MappedFile();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~MappedFile();
+
+            /**
+             * Opens the file and maps it if possible
+             *
+             * @param   fileName    The complete file path
+             *
+             * @return True if the file was opened successfully, otherwise
+             * false.
+             */
+
+            bool open(const QString& fileName);
+
+            /**
+             * Unmaps and closes the file
+             */
+
+            void close();
+
+            /**
+             * Returns whether the file is open
+             *
+             * @return True if the file is open, otherwise false.
+             */
+
+            bool isOpen() const;
+
+            /**
+             * Returns the size of the file
+             *
+             * @return The size of the file in bytes, or 0 if it is not open
+             */
+
+            quint64 size() const;
+
+            /**
+             * Returns the start of the mapping
+             *
+             * @return The mapped data, or NULL if the file is not mapped
+             */
+
+            const uchar *data() const;
+
+            /**
+             * Returns the bytes of the file at the given position
+             *
+             * @param   position    The offset of the bytes in the file
+             * @param   size        The number of the bytes
+             *
+             * @return A raw view into the mapping, which stays valid until the
+             * file is closed, or the bytes read from the file if it is not
+             * mapped. The returned data is shorter on error or beyond the end
+             * of the file.
+             */
+
+            QByteArray read(quint64 position, quint64 size);
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_MAPPEDFILE_H
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "matchheap.h"
+
+#include <QtCore/QSet>
+
+#include <algorithm>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    struct MatchHeapEntry
+    {
+        FuzzyIndex::Match match;
+        QString word;
+    };
+
+    bool matchLessThan(const FuzzyIndex::Match& left, const FuzzyIndex::Match& right)
+    {
+        if (left.distance != right.distance)
+            return left.distance < right.distance;
+
+        return left.index < right.index;
+    }
+
+    // The farthest match is on the top of the heap
+    bool entryLessThan(const MatchHeapEntry& left, const MatchHeapEntry& right)
+    {
+        return matchLessThan(left.match, right.match);
+    }
+}
+
+class MatchHeap::Private
+{
+    public:
+        Private()
+            : maximumCount(0)
+            , limit(0)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        QVector<MatchHeapEntry> entries;
+
+        // The words of the entries, for the deduplication
+        QSet<QString> words;
+
+        int maximumCount;
+        int limit;
+};
+
+MatchHeap::MatchHeap(int maximumCount, int limit)
+    : d(new Private)
+{
+    d->maximumCount = qMax(maximumCount, 0);
+    d->limit = limit;
+    d->entries.reserve(d->maximumCount);
+}
+
+MatchHeap::~MatchHeap()
+{
+    delete d;
+}
+
+int
+MatchHeap::limit() const
+{
+    if (d->entries.size() < d->maximumCount)
+        return d->limit;
+
+    if (d->entries.isEmpty())
+        return 0;
+
+    return d->entries.first().match.distance;
+}
+
+bool
+MatchHeap::insert(long index, int distance, const QString& word)
+{
+    if (distance >= limit())
+        return false;
+
+    if (!word.isNull() && d->words.contains(word))
+        return false;
+
+    if (d->entries.size() == d->maximumCount)
+    {
+        std::pop_heap(d->entries.begin(), d->entries.end(), entryLessThan);
+        if (!d->entries.last().word.isNull())
+            d->words.remove(d->entries.last().word);
+
+        d->entries.removeLast();
+    }
+
+    MatchHeapEntry entry;
+    entry.match.index = index;
+    entry.match.distance = distance;
+    entry.word = word;
+
+    d->entries.append(entry);
+    std::push_heap(d->entries.begin(), d->entries.end(), entryLessThan);
+
+    if (!word.isNull())
+        d->words.insert(word);
+
+    return true;
+}
+
+int
+MatchHeap::count() const
+{
+    return d->entries.size();
+}
+
+QVector<FuzzyIndex::Match>
+MatchHeap::matches() const
+{
+    QVector<FuzzyIndex::Match> result;
+    result.reserve(d->entries.size());
+
+    foreach (const MatchHeapEntry& entry, d->entries)
+        result.append(entry.match);
+
+    std::sort(result.begin(), result.end(), matchLessThan);
+    return result;
+}
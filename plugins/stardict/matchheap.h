@@ -0,0 +1,107 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_MATCHHEAP_H
+#define MULA_PLUGIN_STARDICT_MATCHHEAP_H
+
+#include "fuzzyindex.h"
+
+#include <QtCore/QString>
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Keeps the closest matches of a similar word lookup
+     *
+     * The matches are kept in a max-heap bounded to maximumCount entries, so
+     * the farthest one is replaced in logarithmic time. Once the heap is
+     * full, only the matches closer than the farthest one are accepted, and
+     * limit() tightens accordingly, which the lookups pass on to the edit
+     * distance as its cutoff. Among the equally distant matches, the one with
+     * the higher index is dropped first.
+     *
+     * \see FuzzyIndex::lookup, Dictionary::lookupSimilar
+     */
+
+    class MatchHeap
+    {
+        public:
+
+            /**
+             * Constructor
+             *
+             * @param   maximumCount    The maximum number of the matches
+             * @param   limit           The exclusive limit of the distance
+             * until the heap is full
+             */
+
+            MatchHeap(int maximumCount, int limit);
+
+            /**
+             * Destructor
+             */
+
+            virtual ~MatchHeap();
+
+            /**
+             * Returns the exclusive limit of the distance of the next match
+             *
+             * @return The initial limit, or the distance of the farthest
+             * match once the heap is full
+             */
+
+            int limit() const;
+
+            /**
+             * Inserts the match, replacing the farthest one if the heap is
+             * full
+             *
+             * @param   index       The index of the word entry
+             * @param   distance    The edit distance of the word
+             * @param   word        The word, which must not be in the heap
+             * yet, or a null string if the matches need no deduplication
+             *
+             * @return True if the match was inserted, otherwise false
+             */
+
+            bool insert(long index, int distance, const QString& word = QString());
+
+            /**
+             * Returns the number of the matches
+             *
+             * @return The number of the matches
+             */
+
+            int count() const;
+
+            /**
+             * Returns the matches ordered by their distance and their index
+             *
+             * @return The matches
+             */
+
+            QVector<FuzzyIndex::Match> matches() const;
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_MATCHHEAP_H
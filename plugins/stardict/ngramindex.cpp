@@ -0,0 +1,240 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ngramindex.h"
+
+#include "abstractindexfile.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QVarLengthArray>
+
+#include <algorithm>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    const int ngramSize = 3;
+
+    // The memory budget of the index unless it is set explicitly
+    const qint64 defaultMaximumSize = 8 * 1024 * 1024;
+
+    // Appends the trigrams of the text, and keeps the distinct ones in
+    // ascending order
+    void appendNgrams(const QByteArray& text, QVarLengthArray<quint32, 64> *ngrams)
+    {
+        const uchar *data = reinterpret_cast<const uchar*>(text.constData());
+        for (int i = 0; i + ngramSize <= text.size(); ++i)
+            ngrams->append((quint32(data[i]) << 16) | (quint32(data[i + 1]) << 8) | data[i + 2]);
+
+        std::sort(ngrams->begin(), ngrams->end());
+        ngrams->resize(std::unique(ngrams->begin(), ngrams->end()) - ngrams->begin());
+    }
+
+    // The part of the word entry list of a trigram within the looked up range
+    struct PostingList
+    {
+        const quint32 *begin;
+        const quint32 *end;
+    };
+
+    bool postingListShorterThan(const PostingList& left, const PostingList& right)
+    {
+        return left.end - left.begin < right.end - right.begin;
+    }
+}
+
+class NgramIndex::Private
+{
+    public:
+        Private()
+            : maximumSize(defaultMaximumSize)
+            , built(false)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        void clear()
+        {
+            ngrams.clear();
+            offsets.clear();
+            postings.clear();
+            built = false;
+        }
+
+        // The sorted trigrams, the word entries of the trigram i being
+        // postings[offsets[i]] ... postings[offsets[i + 1] - 1]
+        QVector<quint32> ngrams;
+        QVector<quint32> offsets;
+        QVector<quint32> postings;
+
+        qint64 maximumSize;
+        bool built;
+};
+
+NgramIndex::NgramIndex()
+    : d(new Private)
+{
+}
+
+NgramIndex::~NgramIndex()
+{
+    delete d;
+}
+
+bool
+NgramIndex::build(AbstractIndexFile *indexFile, long wordCount)
+{
+    d->clear();
+
+    // The first pass counts the word entries of the trigrams
+    QHash<quint32, quint32> counts;
+    QVarLengthArray<quint32, 64> wordNgrams;
+
+    for (long i = 0; i < wordCount; ++i)
+    {
+        wordNgrams.clear();
+        appendNgrams(indexFile->keyData(i), &wordNgrams);
+
+        for (int j = 0; j < wordNgrams.size(); ++j)
+            ++counts[wordNgrams[j]];
+    }
+
+    // The size of the lists is known before they are allocated
+    qint64 postingCount = 0;
+    for (QHash<quint32, quint32>::const_iterator it = counts.constBegin(); it != counts.constEnd(); ++it)
+        postingCount += it.value();
+
+    if ((postingCount + 2 * qint64(counts.size()) + 1) * qint64(sizeof(quint32)) > d->maximumSize)
+        return false;
+
+    d->ngrams.reserve(counts.size());
+    for (QHash<quint32, quint32>::const_iterator it = counts.constBegin(); it != counts.constEnd(); ++it)
+        d->ngrams.append(it.key());
+
+    std::sort(d->ngrams.begin(), d->ngrams.end());
+
+    // The counts are turned into the write positions of the lists
+    quint32 position = 0;
+    d->offsets.reserve(d->ngrams.size() + 1);
+    foreach (quint32 ngram, d->ngrams)
+    {
+        d->offsets.append(position);
+
+        quint32& count = counts[ngram];
+        quint32 ngramCount = count;
+        count = position;
+        position += ngramCount;
+    }
+
+    d->offsets.append(position);
+
+    // The second pass fills the lists, in ascending order of the word
+    // entries
+    d->postings.resize(postingCount);
+    quint32 *postings = d->postings.data();
+    for (long i = 0; i < wordCount; ++i)
+    {
+        wordNgrams.clear();
+        appendNgrams(indexFile->keyData(i), &wordNgrams);
+
+        for (int j = 0; j < wordNgrams.size(); ++j)
+            postings[counts[wordNgrams[j]]++] = i;
+    }
+
+    d->built = true;
+    return true;
+}
+
+void
+NgramIndex::setMaximumSize(qint64 maximumSize)
+{
+    d->maximumSize = maximumSize > 0 ? maximumSize : defaultMaximumSize;
+}
+
+qint64
+NgramIndex::size() const
+{
+    return qint64(d->ngrams.size() + d->offsets.size() + d->postings.size()) * sizeof(quint32);
+}
+
+int
+NgramIndex::gramSize()
+{
+    return ngramSize;
+}
+
+bool
+NgramIndex::candidates(const QList<QByteArray>& literals, long first, long last,
+                       QVector<quint32> *candidates) const
+{
+    candidates->clear();
+
+    if (!d->built)
+        return false;
+
+    QVarLengthArray<quint32, 64> queryNgrams;
+    foreach (const QByteArray& literal, literals)
+        appendNgrams(literal, &queryNgrams);
+
+    if (queryNgrams.isEmpty())
+        return false;
+
+    if (first >= last)
+        return true;
+
+    QVarLengthArray<PostingList, 64> lists;
+    for (int i = 0; i < queryNgrams.size(); ++i)
+    {
+        const quint32 *ngram = std::lower_bound(d->ngrams.constBegin(), d->ngrams.constEnd(), queryNgrams[i]);
+        if (ngram == d->ngrams.constEnd() || *ngram != queryNgrams[i])
+            return true;
+
+        int ngramIndex = ngram - d->ngrams.constBegin();
+        const quint32 *begin = d->postings.constData() + d->offsets.at(ngramIndex);
+        const quint32 *end = d->postings.constData() + d->offsets.at(ngramIndex + 1);
+
+        PostingList list;
+        list.begin = std::lower_bound(begin, end, quint32(first));
+        list.end = std::lower_bound(list.begin, end, quint32(last));
+        lists.append(list);
+    }
+
+    // The word entries of the shortest list are looked up in the others,
+    // which are only walked forward
+    std::sort(lists.begin(), lists.end(), postingListShorterThan);
+
+    for (const quint32 *entry = lists[0].begin; entry != lists[0].end; ++entry)
+    {
+        bool found = true;
+        for (int i = 1; i < lists.size() && found; ++i)
+        {
+            lists[i].begin = std::lower_bound(lists[i].begin, lists[i].end, *entry);
+            found = lists[i].begin != lists[i].end && *lists[i].begin == *entry;
+        }
+
+        if (found)
+            candidates->append(*entry);
+    }
+
+    return true;
+}
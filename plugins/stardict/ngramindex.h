@@ -0,0 +1,137 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_NGRAMINDEX_H
+#define MULA_PLUGIN_STARDICT_NGRAMINDEX_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QVector>
+
+namespace MulaPluginStarDict
+{
+    class AbstractIndexFile;
+
+    /**
+     * \brief Inverted index of the byte trigrams of the headwords for the
+     * pattern lookups starting with a wildcard
+     *
+     * Every trigram of the utf-8 encoded headwords maps to the ascending
+     * list of the word entries containing it. The words matching a pattern
+     * contain all the trigrams of its literal texts, so intersecting their
+     * lists gives a few candidates to match instead of the whole index. The
+     * lists are stored one after the other in one array, next to the sorted
+     * trigrams and the offsets of their lists.
+     *
+     * The index is kept in memory only, it is built in two passes over the
+     * word entries in the background once the dictionary is loaded, see
+     * Dictionary::buildNgramIndex(). It takes 4 bytes for every distinct
+     * trigram of every word entry, and 8 bytes for every distinct trigram of
+     * the dictionary. The index is not built if it would exceed its memory
+     * budget, see setMaximumSize(), and the lookups then check every word
+     * entry instead.
+     *
+     * \see Dictionary::lookupPattern, WildcardPattern
+     */
+
+    class NgramIndex
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            NgramIndex();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~NgramIndex();
+
+            /**
+             * Builds the index of the word entries
+             *
+             * @param   indexFile   The index file of the dictionary
+             * @param   wordCount   The number of the word entries
+             *
+             * @return True if the index was built, or false if it would
+             * exceed the memory budget, in which case the index is left empty
+             */
+
+            bool build(AbstractIndexFile *indexFile, long wordCount);
+
+            /**
+             * Sets the memory budget of the index
+             *
+             * \note It has to be set before building the index.
+             *
+             * @param   maximumSize The maximum size of the index in bytes, or
+             * 0 for the default of 8 MB
+             *
+             * @see size
+             */
+
+            void setMaximumSize(qint64 maximumSize);
+
+            /**
+             * Returns the memory used by the index
+             *
+             * @return The size of the index in bytes
+             *
+             * @see setMaximumSize
+             */
+
+            qint64 size() const;
+
+            /**
+             * Returns the number of the bytes the trigrams are made of
+             *
+             * @return The length of the trigrams
+             */
+
+            static int gramSize();
+
+            /**
+             * Returns the word entries in the given range that contain all
+             * the trigrams of the literal texts. The words still need to be
+             * matched, the trigrams may be in another order or overlap.
+             *
+             * \note This method is safe to call from several threads at once.
+             *
+             * @param   literals    The utf-8 encoded literal texts
+             * @param   first       The first word entry to return
+             * @param   last        The word entry after the last one to return
+             * @param   candidates  The word entries in ascending order
+             *
+             * @return False if the index was not built or no literal text is
+             * long enough to filter the word entries, otherwise true
+             */
+
+            bool candidates(const QList<QByteArray>& literals, long first, long last,
+                            QVector<quint32> *candidates) const;
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_NGRAMINDEX_H
@@ -19,18 +19,14 @@
 
 #include "offsetcachefile.h"
 
-#include "file.h"
-#include "wordentry.h"
+#include "indexcache.h"
+#include "mappedfile.h"
 
-#include <QtCore/QVector>
-#include <QtCore/QFile>
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QtGlobal>
-#include <QtCore/QDir>
-#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
-#include <QtCore/QPair>
-#include <QtCore/QtEndian>
-#include <QtCore/QStandardPaths>
 
 using namespace MulaPluginStarDict;
 
@@ -39,9 +35,9 @@ class OffsetCacheFile::Private
     public:
         Private()
             : wordCount(0)
-            , pageIndex(-1)
-            , cacheMagicString("StarDict's Cache, Version: 0.1")
-            , mappedData(0)
+            , pageCache(defaultPageCacheSize)
+            , pageCacheHitCount(0)
+            , pageCacheMissCount(0)
         {
         }
 
@@ -49,27 +45,23 @@ class OffsetCacheFile::Private
         {
         }
 
-        // The length of "word_str" should be less than 256, and then offset, size
-        static const int wordEntrySize = 256 + sizeof(quint32)*2;
+        static const int defaultPageCacheSize = 16;
 
-        static const int pageEntryNumber = 32;
+        IndexCache indexCache;
+        long wordCount;
 
-        QVector<quint32> pageOffsetList;
-        QFile indexFile;
-        int wordCount;
+        // The index file itself, which is read page by page if it cannot be
+        // mapped
+        MappedFile indexFile;
 
-        // index/date based key and value pair
-        QPair<int, QByteArray> first;
-        QPair<int, QByteArray> last;
-        QPair<int, QByteArray> middle;
-        QPair<int, QByteArray> realLast;
+        // The least recently used pages if the index file is not mapped,
+        // shared by the reading threads
+        QCache<long, QByteArray> pageCache;
+        quint64 pageCacheHitCount;
+        quint64 pageCacheMissCount;
 
-        long pageIndex;
-        QList<WordEntry> wordEntryList;
-
-        QByteArray cacheMagicString;
-        QFile mapFile;
-        uchar *mappedData;
+        // Guards the page cache and its counters
+        mutable QMutex pageMutex;
 };
 
 OffsetCacheFile::OffsetCacheFile()
@@ -79,319 +71,181 @@ OffsetCacheFile::OffsetCacheFile()
 
 OffsetCacheFile::~OffsetCacheFile()
 {
+    delete d;
 }
 
 QByteArray
-OffsetCacheFile::readFirstWordDataOnPage(long pageIndex)
+OffsetCacheFile::loadPage(long pageIndex)
 {
-    int pageSize = d->pageOffsetList.at(pageIndex + 1) - d->pageOffsetList.at(pageIndex);
-    int wordEntrySize = d->wordEntrySize;
-
-    d->indexFile.seek(d->pageOffsetList.at(pageIndex));
-    return d->indexFile.read(qMin(wordEntrySize, pageSize)); //TODO: check returned values, deal with word entry that strlen>255.
-}
-
-QByteArray
-OffsetCacheFile::firstWordDataOnPage(long pageIndex)
-{
-    if (pageIndex < d->middle.first)
-    {
-        if (pageIndex == d->first.first)
-            return d->first.second;
+    QMutexLocker locker(&d->pageMutex);
 
-        return readFirstWordDataOnPage(pageIndex);
-    }
-    else if (pageIndex > d->middle.first)
-    {
-        if (pageIndex == d->last.first)
-            return d->last.second;
-
-        return readFirstWordDataOnPage(pageIndex);
-    }
-    else
+    if (const QByteArray *pageData = d->pageCache.object(pageIndex))
     {
-        return d->middle.second;
+        ++d->pageCacheHitCount;
+        return *pageData;
     }
-}
 
-QStringList
-OffsetCacheFile::cacheLocations(const QString& completeFilePath)
-{
-    QStringList result;
-    result.append(completeFilePath + ".oft");
+    ++d->pageCacheMissCount;
 
-    QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-    QFileInfo cacheLocationFileInfo(cacheLocation);
-    QDir cacheLocationDir;
+    int pageEntryNumber = d->indexCache.pageEntryNumber();
+    long firstIndex = pageIndex * pageEntryNumber;
+    long wordEntryCountOnPage = qMin<long>(pageEntryNumber, d->wordCount - firstIndex);
 
-    if (!cacheLocationFileInfo.exists() && cacheLocationDir.mkdir(cacheLocation) == false)
-        return result;
+    quint64 pageOffset = d->indexCache.keyOffset(firstIndex);
+    quint64 pageSize = d->indexCache.keyOffset(firstIndex + wordEntryCountOnPage) - pageOffset;
+    QByteArray pageData = d->indexFile.read(pageOffset, pageSize);
+    if (quint64(pageData.size()) != pageSize)
+    {
+        qDebug() << Q_FUNC_INFO << "Failed to read the page" << pageIndex << "of the index file";
+        return QByteArray();
+    }
 
-    if (!cacheLocationFileInfo.isDir())
-        return result;
+    // The cache takes the ownership of a shallow copy, and it may evict the
+    // least recently used page
+    d->pageCache.insert(pageIndex, new QByteArray(pageData));
 
-    result.append(cacheLocation + QDir::separator() + "sdcv" + QDir::separator() + QFileInfo(completeFilePath).fileName() + ".oft");
-    return result;
+    return pageData;
 }
 
-bool
-OffsetCacheFile::loadCache(const QString& completeFilePath)
+long
+OffsetCacheFile::wordCount() const
 {
-    foreach (const QString& cacheLocation, cacheLocations(completeFilePath))
-    {
-        QFileInfo fileInfoIndex(completeFilePath);
-        QFileInfo fileInfoCache(cacheLocation);
-
-        if (fileInfoCache.lastModified() < fileInfoIndex.lastModified())
-            continue;
-
-        d->mapFile.unmap(d->mappedData);
-        d->mapFile.setFileName(cacheLocation);
-        if( !d->mapFile.open( QIODevice::ReadOnly ) )
-        {
-            qDebug() << "Failed to open file:" << cacheLocation;
-            return false;
-        }
-
-        d->mappedData = d->mapFile.map(0, d->mapFile.size());
-        if (d->mappedData == NULL)
-        {
-            qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(cacheLocation);
-            return false;
-        }
-
-        if (d->cacheMagicString != d->mappedData)
-            continue;
-
-        memcpy(d->pageOffsetList.data(), d->mappedData + d->cacheMagicString.size(), d->pageOffsetList.size()*sizeof(d->pageOffsetList.at(0)));
-        return true;
-    }
-
-    return false;
+    return d->wordCount;
 }
 
-bool
-OffsetCacheFile::saveCache(const QString& completeFilePath)
+QByteArray
+OffsetCacheFile::key(long index)
 {
-    foreach (const QString& cacheLocation, cacheLocations(completeFilePath))
-    {
-        QFile file(cacheLocation);
-        if( !file.open( QIODevice::WriteOnly ) )
-        {
-            qDebug() << "Failed to open file for writing:" << cacheLocation;
-            return false;
-        }
-
-        d->mapFile.unmap(d->mappedData);
-        d->mapFile.setFileName(cacheLocation);
-        if( !d->mapFile.open( QIODevice::ReadOnly ) )
-        {
-            qDebug() << "Failed to open file:" << cacheLocation;
-            return false;
-        }
-
-        d->mappedData = d->mapFile.map(0, d->mapFile.size());
-        if (d->mappedData == NULL)
-        {
-            qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(cacheLocation);
-            return false;
-        }
+    setWordEntryOffset(d->indexCache.dataOffset(index));
+    setWordEntrySize(d->indexCache.dataSize(index));
 
-        if (file.write(d->cacheMagicString) != d->cacheMagicString.size())
-            continue;
-
-        if (file.write(reinterpret_cast<const char*>(d->pageOffsetList.data()), sizeof(d->pageOffsetList.at(0))*d->pageOffsetList.size())
-                != d->pageOffsetList.at(0)*d->pageOffsetList.size())
-            continue;
-
-        file.close();
-
-        qDebug() << "Save to cache" << completeFilePath;
-
-        return true;
-    }
-
-    return false;
+    return keyData(index);
 }
 
-int
-OffsetCacheFile::loadPage(int pageIndex)
+QByteArray
+OffsetCacheFile::keyData(long index)
 {
-    int wordEntryCountOnPage;
+    quint64 keyOffset = d->indexCache.keyOffset(index);
+    int keyLength = d->indexCache.keyLength(index);
+    if (d->indexFile.data())
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(d->indexFile.data()) + keyOffset, keyLength);
+
+    int pageEntryNumber = d->indexCache.pageEntryNumber();
+    long pageIndex = index / pageEntryNumber;
+    QByteArray pageData = loadPage(pageIndex);
+    int position = keyOffset - d->indexCache.keyOffset(pageIndex * pageEntryNumber);
+    if (pageData.size() < position + keyLength)
+        return QByteArray();
+
+    // The page may be evicted as soon as it is returned
+    return pageData.mid(position, keyLength);
+}
 
-    if (pageIndex == (d->pageOffsetList.size() - 2) && (d->wordCount % d->pageEntryNumber) != 0)
-        wordEntryCountOnPage = d->wordCount % d->pageEntryNumber;
-    else
-        wordEntryCountOnPage = d->pageEntryNumber;
+void
+OffsetCacheFile::setSynonymFile(bool synonymFile)
+{
+    d->indexCache.setSynonymFile(synonymFile);
+}
 
-    if (pageIndex != d->pageIndex)
-    {
-        d->pageIndex = pageIndex;
-        d->indexFile.seek(d->pageOffsetList.at(pageIndex));
-        QByteArray pageData = d->indexFile.read(d->pageOffsetList.at(pageIndex + 1) - d->pageOffsetList.at(pageIndex));
-
-        ulong position = 0;
-        d->wordEntryList.clear();
-        d->wordEntryList.reserve(wordEntryCountOnPage);
-        for (int i = 0; i < wordEntryCountOnPage; ++i)
-        {
-            WordEntry wordEntry;
-            wordEntry.setData(pageData.mid(position));
-            position = qstrlen(pageData.mid(position)) + 1;
-            wordEntry.setDataOffset(qFromBigEndian(*reinterpret_cast<quint32 *>(pageData.mid(position).data())));
-            position += sizeof(quint32);
-            wordEntry.setDataSize(qFromBigEndian(*reinterpret_cast<quint32 *>(pageData.mid(position).data())));
-            position += sizeof(quint32);
-
-            d->wordEntryList.append(wordEntry);
-        }
-    }
+void
+OffsetCacheFile::setPageCacheSize(int pageCacheSize)
+{
+    if (pageCacheSize <= 0)
+        pageCacheSize = d->defaultPageCacheSize;
 
-    return wordEntryCountOnPage;
+    QMutexLocker locker(&d->pageMutex);
+    d->pageCache.setMaxCost(pageCacheSize);
 }
 
-QByteArray
-OffsetCacheFile::key(long index)
+quint64
+OffsetCacheFile::pageCacheHitCount() const
 {
-    loadPage(index / d->pageEntryNumber);
-    ulong indexInPage = index % d->pageEntryNumber;
-    setWordEntryOffset(d->wordEntryList.at(indexInPage).dataOffset());
-    setWordEntrySize(d->wordEntryList.at(indexInPage).dataSize());
+    QMutexLocker locker(&d->pageMutex);
+    return d->pageCacheHitCount;
+}
 
-    return d->wordEntryList.at(indexInPage).data();
+quint64
+OffsetCacheFile::pageCacheMissCount() const
+{
+    QMutexLocker locker(&d->pageMutex);
+    return d->pageCacheMissCount;
 }
 
 bool
 OffsetCacheFile::load(const QString& completeFilePath)
 {
-    if (!loadCache(completeFilePath))
-    { //map file will close after finish of block
-        d->mapFile.unmap(d->mappedData);
-        d->mapFile.setFileName(completeFilePath);
-        if (!d->mapFile.open(QIODevice::ReadOnly))
-        {
-            qDebug() << "Failed to open file:" << completeFilePath;
-            return -1;
-        }
+    {
+        QMutexLocker locker(&d->pageMutex);
+        d->pageCache.clear();
+    }
 
-        d->mappedData = d->mapFile.map(0, d->mapFile.size());
-        if (d->mappedData == NULL)
-        {
-            qDebug() << Q_FUNC_INFO << QString("Mapping the file %1 failed!").arg(completeFilePath);
-            return false;
-        }
+    // Keep the whole index mapped, so that the word data can be handed out as
+    // views into the mapping. If the mapping is not possible, for instance
+    // because of the limited address space, the pages are read on demand.
+    if (!d->indexFile.open(completeFilePath))
+        return false;
 
-        QByteArray byteArray = QByteArray::fromRawData(reinterpret_cast<const char*>(d->mappedData), d->mapFile.size());
+    if (pageEntryNumber() > 0)
+        d->indexCache.setPageEntryNumber(pageEntryNumber());
 
-        int position = 0;
-        d->pageOffsetList.clear();
-        int wordTerminatorOffsetSizeLength = 1 + 2 * sizeof(quint32);
-        d->wordCount = 0;
+    d->indexCache.setIndexOffsetBits(indexOffsetBits());
 
-        while (d->mapFile.size() < position)
+    if (!d->indexCache.load(completeFilePath))
+    {
+        if (d->indexFile.data())
         {
-            if (d->wordCount % d->pageEntryNumber == 0)
-                d->pageOffsetList.append(position);
-
-            position += qstrlen(byteArray.mid(position)) + wordTerminatorOffsetSizeLength;
-            ++d->wordCount;
+            d->indexCache.build(reinterpret_cast<const char*>(d->indexFile.data()), d->indexFile.size());
+        }
+        else
+        {
+            QByteArray indexData = d->indexFile.read(0, d->indexFile.size());
+            d->indexCache.build(indexData.constData(), indexData.size());
         }
 
-        d->pageOffsetList.append(position);
-
-        if (!saveCache(completeFilePath))
+        if (!d->indexCache.save(completeFilePath))
             qDebug() << "Cache update failed";
     }
 
-    d->indexFile.setFileName(completeFilePath);
-    if (!d->indexFile.open(QIODevice::ReadOnly))
-    {
-        qDebug() << "Failed to open file:" << completeFilePath;
-        d->pageOffsetList.clear();
+    d->wordCount = d->indexCache.wordCount();
+    if (d->wordCount == 0)
         return false;
-    }
-
-    d->first = qMakePair(0, readFirstWordDataOnPage(0));
-    d->last = qMakePair(d->pageOffsetList.size() - 2, readFirstWordDataOnPage(d->pageOffsetList.size() - 2));
-    d->middle = qMakePair((d->pageOffsetList.size() - 2) / 2, readFirstWordDataOnPage((d->pageOffsetList.size() - 2) / 2));
-    d->realLast = qMakePair(d->wordCount - 1, key(d->wordCount - 1));
 
     return true;
 }
 
-int
-OffsetCacheFile::lookupPage(const QByteArray& word)
+QByteArray
+OffsetCacheFile::collationKey(long index)
 {
-    int pageIndex = invalidIndex;
-
-    if (stardictStringCompare(word, d->first.second) < 0)
-    {
-        return invalidIndex;
-    }
-    else if (stardictStringCompare(word, d->realLast.second) > 0)
-    {
-        return invalidIndex;
-    }
-    else
-    {
-        int indexTo = d->pageOffsetList.size() - 2;
-        int indexFrom = 0;
-        int indexThisIndex = 0;
-        int cmpint;
-        while (indexFrom <= indexTo)
-        {
-            indexThisIndex = (indexFrom + indexTo) / 2;
-            cmpint = stardictStringCompare(word, firstWordDataOnPage(indexThisIndex));
-            if (cmpint > 0)
-                indexFrom = indexThisIndex + 1;
-            else if (cmpint < 0)
-                indexTo = indexThisIndex - 1;
-            else
-            {
-                return indexThisIndex;
-            }
-        }
-
-        pageIndex = indexTo;
-    }
-
-    return pageIndex;
+    return d->indexCache.collationKey(index);
 }
 
-inline bool
-lessThanCompare(const QString string1, const QString string2)
+int
+OffsetCacheFile::lookup(const QByteArray& word, int *nextIndex)
 {
-    return stardictStringCompare(string1, string2) < 0;
+    // The page directory and the collation keys are in the cache, so the
+    // index file itself is not touched
+    return d->indexCache.lookup(word, nextIndex);
 }
 
-int
-OffsetCacheFile::lookup(const QByteArray& word)
+quint64
+OffsetCacheFile::dataOffset(long index) const
 {
-    int index = lookupPage(word);
-
-    if (index == -1)
-    {
-        QStringList wordList;
-        foreach (const WordEntry &wordEntry, d->wordEntryList)
-            wordList.append(QString::fromUtf8(wordEntry.data()));
-
-        QStringList::iterator i = qBinaryFind(wordList.begin() + 1, wordList.end() - 1, QString::fromUtf8(word), lessThanCompare);
+    return d->indexCache.dataOffset(index);
+}
 
-        index *= d->pageEntryNumber;
+quint32
+OffsetCacheFile::dataSize(long index) const
+{
+    return d->indexCache.dataSize(index);
+}
 
-        if (i == wordList.end())
-        {
-            index = -1;
-        }
-        else
-        {
-            index = i - wordList.begin();
-        }
-    }
-    else
-    {
-        index *= d->pageEntryNumber;
-    }
+void
+OffsetCacheFile::prefetch(long index) const
+{
+    if (!d->indexFile.data())
+        return;
 
-    return index;
+    // Reading the key faults its page of the mapping in
+    const volatile uchar *word = d->indexFile.data() + d->indexCache.keyOffset(index);
+    (void)*word;
 }
@@ -31,35 +31,29 @@ namespace MulaPluginStarDict
      *
      * StarDict-2.4.8 started to support cache files. The cache file usage can
      * speed up the loading and save memory by mapping the cache file. The
-     * cache file names are ".idx.oft" and ".syn.oft".
-     * The cache file contains a utf-8 string terminated by '\0', and then
-     * 32-bits numbers. These numbers are the offset value of the cache pages.
-     * Each cache page contains "pageEntryNumber" word entries inside the index
-     * file. They are not stored in network byte order. The index file does not
-     * need to be parsed by going through every byte, thus it can provide better
-     * performance this way.
+     * cache file names are ".idx.oft" and ".syn.oft", the same class handles
+     * the ".syn" synonym files as well.
+     * The cache file contains the position of every word entry inside the
+     * index file, and the offset and the size of the word data, hence the
+     * index file does not need to be parsed by going through every byte, and
+     * any word entry can be accessed directly. The word entries are grouped
+     * into pages of "pageEntryNumber" entries, and the lookup only searches
+     * the page directory and the collation keys stored in the cache file.
      *
-     * The string must begin with:
-     * =====
-     * StarDict's oft file
-     * version=2.4.8
-     * =====
-     * The following line is something like this:
-     * url=/usr/share/stardict/dic/stardict-somedict-2.4.2/somedict.idx
-     * This line should end by '\n'.
+     * The class will try to create the ".oft" offset file in the same
+     * directory where the ".ifo" file can be found, if failed, in the
+     * ${CACHE_LOCATION}/stardict/ folder where the cache path is provided by
+     * QStandardPaths class using the CacheLocation argument.
      *
-     * The class will try to create the ".oft" offset file, if failed, in the same
-     * directory where the ".ifo" file can be found. The class will try to create
-     * the cache file in the ${CACHE_LOCATION}/stardict/ folder where the cache
-     * path is provided by QDesktopService class using the CacheLocation
-     * argument.
+     * The index file itself is kept memory mapped whenever it is possible, so
+     * the word data returned by key() is a view into the mapping and looking
+     * up a cold page only costs page faults. If the index file cannot be
+     * mapped, the pages are read on demand into a least recently used cache
+     * of pages shared by the reading threads. Its size can be tuned by
+     * setPageCacheSize(), and its hit and miss counters tell how well it
+     * serves the lookups.
      *
-     * If two or more dictionaries have the same file name, StarDict will
-     * create "somedict.idx.oft", "somedict(2).idx.oft", "somedict(3).idx.oft"
-     * and the like, for them respectively. Each starts with different "url=" in
-     * the beginning string.
-     *
-     * \see Indexfile
+     * \see Indexfile, IndexCache
      */
 
     class OffsetCacheFile : public AbstractIndexFile
@@ -83,138 +77,101 @@ namespace MulaPluginStarDict
 
             bool load(const QString& completeFilePath);
 
-            /** Reimplemented from AbstractIndexFile::key() */
-
-            QByteArray key(long index);
+            /** Reimplemented from AbstractIndexFile::wordCount() */
 
-            /** Reimplemented from AbstractIndexFile::lookup() */
-
-            int lookup(const QByteArray& string);
-
-        private:
+            long wordCount() const;
 
             /**
-             * Loads the word entries of relevant cache page into the internal
-             * data storage. It will return the number of the word entries
-             * loaded.
-             *
-             * \note It always loads the pageEntryNumber except the last page,
-             * if that is not completely reserved. This method will just load the
-             * last few entries then in that case. This method is only for
-             * internal usage.
-             *
-             * @param   pageIndex   The index of the desired page
-             *
-             * @return  The number of the word entries loaded
+             * Reimplemented from AbstractIndexFile::key()
              *
-             * @see load
+             * \note The returned data does not own its bytes if the index
+             * file is mapped, it points into the mapping. Otherwise it is
+             * copied out of the page cache.
              */
 
-            int loadPage(int pageIndex);
+            QByteArray key(long index);
 
             /**
-             * Looks up the word on the existing pages and then returns the
-             * relevant page index where the word can be found. This method also
-             * returns whether or not the desired page can be found.
-             *
-             * \note This method does not return the index of the word. It will
-             * return the index of the page where the word occurs. This method
-             * is only for internal usage.
-             *
-             * @param   word        The desired word to look up
+             * Reimplemented from AbstractIndexFile::keyData()
              *
-             * @return The index of the page where the word occurs, or -1 if
-             * there is no such a word.
-             *
-             * @see lookup
+             * \note If the index file could not be mapped, the word data is
+             * copied out of the page cache, which may be called from several
+             * threads at once.
              */
 
-            int lookupPage(const QByteArray& word);
+            QByteArray keyData(long index);
 
-            /**
-             * Returns the first word data of the desired page from the index
-             * file. It is a bit slower since it starts seeking and reading
-             * from the index file directly without using any caching mechanism
-             *
-             * \note This method is only for internal usage.
-             *
-             * @param   pageIndex The index of the desired page
-             *
-             * @return  The desired word data from the index file
-             *
-             * @see firstWordDataOnPage
-             */
+            /** Reimplemented from AbstractIndexFile::collationKey() */
 
-            QByteArray readFirstWordDataOnPage(long pageIndex);
+            QByteArray collationKey(long index);
 
-            /**
-             * Returns the first word data of the desired page from the index
-             * file by using a caching approach to make it faster to look the
-             * word up in certain cases. Hence, it is faster to use this method
-             * for reading the first word data of the cache page.
-             *
-             * \note This method is only for internal usage.
-             *
-             * @param   pageIndex The index of the desired page
-             *
-             * @return  The desired word data from the index file
-             *
-             * @see readFirstWordDataOnPage
-             */
+            /** Reimplemented from AbstractIndexFile::lookup() */
+
+            int lookup(const QByteArray& word, int *nextIndex = 0);
+
+            /** Reimplemented from AbstractIndexFile::dataOffset() */
 
-            QByteArray firstWordDataOnPage(long pageIndex);
+            quint64 dataOffset(long index) const;
+
+            /** Reimplemented from AbstractIndexFile::dataSize() */
+
+            quint32 dataSize(long index) const;
 
             /**
-             * Returns a string list of the cache locations.
-             * The method will return the location where the index file can be
-             * found and the location ${CACHE_LOCATION}/stardict/ folder where
-             * the cache path is provided by QDesktopService class using the
-             * CacheLocation argument.
-             *
-             * \note This method is only for internal usage.
+             * Reimplemented from AbstractIndexFile::prefetch()
              *
-             * @param   completeFilePath The complete file path
-             *
-             * @return  List of the cache locations
-             *
-             * @see saveCache, loadCache
+             * \note Only the mapped index file is prefetched, the page cache
+             * is filled by the lookups themselves.
              */
 
-            QStringList cacheLocations(const QString& completeFilePath);
+            void prefetch(long index) const;
 
             /**
-             * Loads the cache file according to the relevant index file path.
-             * Returns true if the cache file loading is successful, otherwise
-             * returns false.
-             *
-             * \note This method is only for internal usage.
+             * Sets whether the file is a ".syn" synonym file. The word
+             * entries of a synonym file hold the index of the original word
+             * entry in the index file, which is returned by wordEntryOffset()
+             * after calling key(), and wordEntrySize() is always zero.
              *
-             * @param   completeFilePath The complete file path
+             * \note It has to be set before loading the file.
              *
-             * @return True if the cache loading was successful, otherwise
-             * false.
-             *
-             * @see cacheLocations, saveCache
+             * @param   synonymFile Whether the file is a synonym file
              */
 
-            bool loadCache(const QString& completeFilePath);
+            void setSynonymFile(bool synonymFile);
+
+            /** Reimplemented from AbstractIndexFile::setPageCacheSize() */
+
+            void setPageCacheSize(int pageCacheSize);
+
+            /** Reimplemented from AbstractIndexFile::pageCacheHitCount() */
+
+            quint64 pageCacheHitCount() const;
+
+            /** Reimplemented from AbstractIndexFile::pageCacheMissCount() */
+
+            quint64 pageCacheMissCount() const;
+
+        private:
 
             /**
-             * Saves the cache file according to the relevant index file path.
-             * Returns true if the cache file saving is successful, otherwise
-             * returns false.
+             * Returns the word entries of the relevant page from the page
+             * cache, and loads the page into the cache first if it is not
+             * there yet. It is only used if the index file is not mapped.
              *
-             * \note This method is only for internal usage.
+             * \note It always loads the pageEntryNumber except the last page,
+             * if that is not completely reserved. This method will just load the
+             * last few entries then in that case. Loading a page may drop the
+             * least recently used one. This method is only for internal usage.
              *
-             * @param   completeFilePath The complete file path
+             * @param   pageIndex   The index of the desired page
              *
-             * @return True if the cache saving was successful, otherwise
-             * false.
+             * @return  The raw word entries of the page, which stay valid even
+             * if the page is evicted, or a null byte array on error
              *
-             * @see cacheLocations, loadCache
+             * @see keyData
              */
 
-            bool saveCache(const QString& completeFilePath);
+            QByteArray loadPage(long pageIndex);
 
             class Private;
             Private *const d;
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "plaindatafile.h"
+
+#include "mappedfile.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QString>
+
+using namespace MulaPluginStarDict;
+
+class PlainDataFile::Private
+{
+    public:
+        Private()
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        MappedFile dataFile;
+};
+
+PlainDataFile::PlainDataFile()
+    : d(new Private)
+{
+}
+
+PlainDataFile::~PlainDataFile()
+{
+    close();
+    delete d;
+}
+
+bool
+PlainDataFile::open(const QString& fileName)
+{
+    close();
+
+    if (!d->dataFile.open(fileName))
+        return false;
+
+    if (d->dataFile.size() == 0)
+    {
+        qDebug() << Q_FUNC_INFO << QString("\"%1\" is empty").arg(fileName);
+        close();
+        return false;
+    }
+
+    QByteArray magic = d->dataFile.read(0, 2);
+    if (magic.size() == 2 && uchar(magic.at(0)) == 0x1f && uchar(magic.at(1)) == 0x8b)
+    {
+        qDebug() << Q_FUNC_INFO << QString("\"%1\" is compressed").arg(fileName);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void
+PlainDataFile::close()
+{
+    d->dataFile.close();
+}
+
+QByteArray
+PlainDataFile::read(quint64 start, unsigned long size, QByteArray *chunk)
+{
+    if (!d->dataFile.isOpen())
+        return QByteArray();
+
+    if (start + size > d->dataFile.size())
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot read beyond the end of the file (%1 > %2)").arg(start + size).arg(d->dataFile.size());
+        return QByteArray();
+    }
+
+    // The data is a raw view into the mapped file, unless it was read
+    QByteArray data = d->dataFile.read(start, size);
+    if (quint64(data.size()) != size)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot read %1 bytes at %2").arg(size).arg(start);
+        return QByteArray();
+    }
+
+    if (chunk || !d->dataFile.data())
+        return data;
+
+    return QByteArray(data.constData(), data.size());
+}
+
+void
+PlainDataFile::setAccessPattern(AccessPattern accessPattern)
+{
+    adviseMapping(d->dataFile.data(), d->dataFile.size(), accessPattern);
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_PLAINDATAFILE_H
+#define MULA_PLUGIN_STARDICT_PLAINDATAFILE_H
+
+#include "abstractdatafile.h"
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Reader of the uncompressed ".dict" files
+     *
+     * The whole file is memory mapped once, so the articles are read without
+     * seeking or locking, and the readers can get a view into the mapping
+     * instead of a copy. If the file cannot be mapped, it is read with seek()
+     * and read() instead.
+     *
+     * \see DictionaryZip, MappedFile
+     */
+
+    class PlainDataFile : public AbstractDataFile
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            PlainDataFile();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~PlainDataFile();
+
+            /**
+             * Opens and maps the plain ".dict" file
+             *
+             * \note Gzip files are refused, as they are read by the other
+             * successors of AbstractDataFile.
+             *
+             * @param   fileName    The complete file path of the data file
+             *
+             * @return True if the file was opened successfully, otherwise
+             * false.
+             */
+
+            bool open(const QString& fileName);
+
+            void close();
+
+            /**
+             * Returns the data of the file at the given position
+             *
+             * @param   start   The offset of the data in the file
+             * @param   size    The size of the data
+             * @param   chunk   If not NULL and the file is mapped, the returned
+             * data is a raw view into the mapped file that stays valid until
+             * the file is closed, otherwise it is a copy. The chunk itself is
+             * left untouched.
+             *
+             * @return The data, or an empty byte array on error
+             */
+
+            QByteArray read(quint64 start, unsigned long size, QByteArray *chunk = 0);
+
+            void setAccessPattern(AccessPattern accessPattern);
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_PLAINDATAFILE_H
@@ -0,0 +1,260 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "prefetcher.h"
+
+#include "dictionary.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QHash>
+#include <QtCore/QRunnable>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    typedef QSharedPointer<QAtomicInt> CancelFlag;
+
+    // Prefetches the word entries from the first one in the direction until
+    // the count or the budget is exhausted, or the run is cancelled
+    class PrefetchTask : public QRunnable
+    {
+        public:
+            PrefetchTask(Dictionary *dictionary, long first, int direction, int count,
+                         qint64 maximumSize, const CancelFlag& cancelled, QAtomicInteger<quint64> *prefetchedCount)
+                : m_dictionary(dictionary)
+                , m_first(first)
+                , m_direction(direction)
+                , m_count(count)
+                , m_maximumSize(maximumSize)
+                , m_cancelled(cancelled)
+                , m_prefetchedCount(prefetchedCount)
+            {
+            }
+
+            void run()
+            {
+                qint64 size = 0;
+                for (int i = 0; i < m_count && size < m_maximumSize; ++i)
+                {
+                    if (m_cancelled->loadAcquire())
+                        return;
+
+                    size += m_dictionary->prefetch(m_first + i * m_direction);
+                    m_prefetchedCount->ref();
+                }
+            }
+
+        private:
+            Dictionary *m_dictionary;
+            long m_first;
+            int m_direction;
+            int m_count;
+            qint64 m_maximumSize;
+            CancelFlag m_cancelled;
+            QAtomicInteger<quint64> *m_prefetchedCount;
+    };
+
+    struct AccessState
+    {
+        AccessState()
+            : lastIndex(-1)
+            , direction(0)
+            , runLength(0)
+            , prefetchedEnd(-1)
+            , cancelled(new QAtomicInt(0))
+        {
+        }
+
+        long lastIndex;
+        int direction;
+        int runLength;
+
+        // The next entry in the direction that is not prefetched yet
+        long prefetchedEnd;
+
+        // Shared with the pending runs of the dictionary
+        CancelFlag cancelled;
+    };
+}
+
+class Prefetcher::Private
+{
+    public:
+        Private()
+            : enabled(false)
+            , entryCount(defaultEntryCount)
+            , maximumSize(defaultMaximumSize)
+            , prefetchedCount(0)
+        {
+            // One background thread keeps the runs in order, and leaves the
+            // other cores to the lookups
+            threadPool.setMaxThreadCount(1);
+        }
+
+        ~Private()
+        {
+        }
+
+        void cancelAll()
+        {
+            foreach (const AccessState& state, states)
+                state.cancelled->storeRelease(1);
+
+            states.clear();
+        }
+
+        static const int defaultEntryCount = 64;
+        static const qint64 defaultMaximumSize = 4 * 1024 * 1024;
+
+        // The sequential access has to go on for that many steps before
+        // anything is prefetched
+        static const int sequentialRunLength = 2;
+
+        bool enabled;
+        int entryCount;
+        qint64 maximumSize;
+
+        QHash<Dictionary *, AccessState> states;
+        QThreadPool threadPool;
+        QAtomicInteger<quint64> prefetchedCount;
+};
+
+Prefetcher::Prefetcher()
+    : d(new Private)
+{
+}
+
+Prefetcher::~Prefetcher()
+{
+    cancel();
+    waitForDone();
+    delete d;
+}
+
+void
+Prefetcher::setEnabled(bool enabled)
+{
+    if (!enabled)
+        cancel();
+
+    d->enabled = enabled;
+}
+
+bool
+Prefetcher::isEnabled() const
+{
+    return d->enabled;
+}
+
+void
+Prefetcher::setEntryCount(int entryCount)
+{
+    d->entryCount = (entryCount > 0) ? entryCount : int(Private::defaultEntryCount);
+}
+
+int
+Prefetcher::entryCount() const
+{
+    return d->entryCount;
+}
+
+void
+Prefetcher::setMaximumSize(qint64 maximumSize)
+{
+    d->maximumSize = (maximumSize > 0) ? maximumSize : qint64(Private::defaultMaximumSize);
+}
+
+qint64
+Prefetcher::maximumSize() const
+{
+    return d->maximumSize;
+}
+
+void
+Prefetcher::accessed(Dictionary *dictionary, long index)
+{
+    if (!d->enabled || !dictionary->isLoaded())
+        return;
+
+    AccessState& state = d->states[dictionary];
+    long step = index - state.lastIndex;
+
+    if ((step == 1 || step == -1) && (state.runLength == 0 || step == state.direction))
+    {
+        ++state.runLength;
+    }
+    else if (step != 0)
+    {
+        // A jump, the pending runs are of no use anymore
+        state.cancelled->storeRelease(1);
+        state.cancelled = CancelFlag(new QAtomicInt(0));
+        state.runLength = 0;
+        state.prefetchedEnd = -1;
+    }
+
+    state.lastIndex = index;
+    if (step == 0 || state.runLength == 0)
+        return;
+
+    state.direction = step;
+    if (state.runLength < Private::sequentialRunLength)
+        return;
+
+    if (state.prefetchedEnd < 0)
+        state.prefetchedEnd = index + state.direction;
+
+    // Request the next window once half of the previous one is used up
+    long remaining = (state.prefetchedEnd - index) * state.direction;
+    if (remaining > d->entryCount / 2)
+        return;
+
+    long windowEnd = index + d->entryCount * state.direction;
+    windowEnd = qBound<long>(-1, windowEnd, dictionary->articleCount());
+
+    int count = (windowEnd - state.prefetchedEnd) * state.direction;
+    if (count <= 0)
+        return;
+
+    d->threadPool.start(new PrefetchTask(dictionary, state.prefetchedEnd, state.direction, count,
+                                         d->maximumSize, state.cancelled, &d->prefetchedCount));
+
+    state.prefetchedEnd = windowEnd;
+}
+
+void
+Prefetcher::cancel()
+{
+    d->cancelAll();
+}
+
+void
+Prefetcher::waitForDone()
+{
+    d->threadPool.waitForDone();
+}
+
+quint64
+Prefetcher::prefetchedCount() const
+{
+    return d->prefetchedCount.loadAcquire();
+}
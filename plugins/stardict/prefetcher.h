@@ -0,0 +1,173 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_PREFETCHER_H
+#define MULA_PLUGIN_STARDICT_PREFETCHER_H
+
+#include <QtCore/QtGlobal>
+
+namespace MulaPluginStarDict
+{
+    class Dictionary;
+
+    /**
+     * \brief Reads the word entries ahead of the sequential browsing of the
+     * word list
+     *
+     * The dictionary manager reports every word entry the user steps to. Once
+     * a dictionary has been stepped through entry by entry in one direction
+     * a few times, the following entryCount() entries are prefetched on a
+     * background thread by Dictionary::prefetch(). The index pages are then
+     * mapped in and the dictzip chunks inflated into the ChunkCache before
+     * they are needed. A new window is requested when the reader has used up
+     * half of the previous one.
+     *
+     * Every prefetching run stops after maximumSize() bytes of word data, and
+     * a jump to another entry cancels the pending runs of the dictionary.
+     *
+     * \note accessed() and the settings must be used from one thread.
+     * cancel() and waitForDone() have to be called before the dictionaries
+     * are deleted.
+     *
+     * \see StarDictDictionaryManager::prefetcher
+     */
+
+    class Prefetcher
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            Prefetcher();
+
+            /**
+             * Destructor, which cancels the prefetching and waits for the
+             * background thread
+             */
+
+            virtual ~Prefetcher();
+
+            /**
+             * Sets whether the sequential access is detected and prefetched.
+             * Disabling the prefetcher cancels the pending runs.
+             *
+             * @param   enabled Whether the prefetcher is enabled
+             *
+             * @see isEnabled
+             */
+
+            void setEnabled(bool enabled);
+
+            /**
+             * Returns whether the prefetcher is enabled, which it is not by
+             * default
+             *
+             * @return True if the prefetcher is enabled, otherwise false
+             *
+             * @see setEnabled
+             */
+
+            bool isEnabled() const;
+
+            /**
+             * Sets the number of the word entries read ahead
+             *
+             * @param   entryCount  The number of the entries, or 0 for the
+             * default
+             *
+             * @see entryCount
+             */
+
+            void setEntryCount(int entryCount);
+
+            /**
+             * Returns the number of the word entries read ahead
+             *
+             * @return The number of the entries
+             *
+             * @see setEntryCount
+             */
+
+            int entryCount() const;
+
+            /**
+             * Sets the budget of the word data read by one prefetching run
+             *
+             * @param   maximumSize The maximum number of bytes, or 0 for the
+             * default
+             *
+             * @see maximumSize
+             */
+
+            void setMaximumSize(qint64 maximumSize);
+
+            /**
+             * Returns the budget of the word data read by one prefetching run
+             *
+             * @return The maximum number of bytes
+             *
+             * @see setMaximumSize
+             */
+
+            qint64 maximumSize() const;
+
+            /**
+             * Records the access of the word entry, and starts prefetching the
+             * following entries if the dictionary is read sequentially
+             *
+             * @param   dictionary  The dictionary of the entry
+             * @param   index       The index of the entry
+             */
+
+            void accessed(Dictionary *dictionary, long index);
+
+            /**
+             * Cancels the pending prefetching runs, and forgets the access
+             * history of all the dictionaries
+             *
+             * @see waitForDone
+             */
+
+            void cancel();
+
+            /**
+             * Blocks until the running prefetching finishes
+             *
+             * @see cancel
+             */
+
+            void waitForDone();
+
+            /**
+             * Returns the number of the word entries prefetched so far
+             *
+             * @return The number of the prefetched entries
+             */
+
+            quint64 prefetchedCount() const;
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_PREFETCHER_H
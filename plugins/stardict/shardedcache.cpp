@@ -0,0 +1,223 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "shardedcache.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QPair>
+
+#include <limits.h>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    typedef QPair<quint32, quint64> EntryKey;
+
+    // The entries are spread over the shards by their key, and each shard
+    // keeps its own least recently used order under its own lock
+    struct Shard
+    {
+        Shard()
+            : hitCount(0)
+            , missCount(0)
+        {
+        }
+
+        QMutex mutex;
+        QCache<EntryKey, QByteArray> cache;
+        quint64 hitCount;
+        quint64 missCount;
+    };
+}
+
+class ShardedCache::Private
+{
+    public:
+        Private(qint64 defaultMaximumSize, int entryOverhead)
+            : defaultMaximumSize(defaultMaximumSize)
+            , entryOverhead(entryOverhead)
+            , maximumSize(defaultMaximumSize)
+            , lastOwnerId(0)
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        Shard& shard(const EntryKey& key)
+        {
+            // Multiplicative hashing, so that the neighbouring positions of
+            // an owner land in different shards whatever their stride is
+            quint64 hash = ((quint64(key.first) << 32) ^ key.second) * Q_UINT64_C(0x9e3779b97f4a7c15);
+            return shards[(hash >> 32) % shardCount];
+        }
+
+        void updateShardSizes()
+        {
+            qint64 shardSize = maximumSize / shardCount;
+            if (shardSize > INT_MAX)
+                shardSize = INT_MAX;
+
+            for (int i = 0; i < shardCount; ++i)
+            {
+                QMutexLocker locker(&shards[i].mutex);
+                shards[i].cache.setMaxCost(int(shardSize));
+            }
+        }
+
+        static const int shardCount = 16;
+
+        const qint64 defaultMaximumSize;
+        const int entryOverhead;
+        Shard shards[shardCount];
+        qint64 maximumSize;
+        QAtomicInt lastOwnerId;
+};
+
+ShardedCache::ShardedCache(qint64 defaultMaximumSize, int entryOverhead)
+    : d(new Private(defaultMaximumSize, entryOverhead))
+{
+    d->updateShardSizes();
+}
+
+ShardedCache::~ShardedCache()
+{
+    delete d;
+}
+
+quint32
+ShardedCache::newOwnerId()
+{
+    return d->lastOwnerId.fetchAndAddOrdered(1) + 1;
+}
+
+QByteArray
+ShardedCache::object(quint32 ownerId, quint64 position)
+{
+    EntryKey key(ownerId, position);
+    Shard& shard = d->shard(key);
+
+    QMutexLocker locker(&shard.mutex);
+    QByteArray *object = shard.cache.object(key);
+    if (!object)
+    {
+        ++shard.missCount;
+        return QByteArray();
+    }
+
+    ++shard.hitCount;
+    return *object;
+}
+
+void
+ShardedCache::insert(quint32 ownerId, quint64 position, const QByteArray& object)
+{
+    EntryKey key(ownerId, position);
+    Shard& shard = d->shard(key);
+
+    QMutexLocker locker(&shard.mutex);
+    shard.cache.insert(key, new QByteArray(object), object.size() + d->entryOverhead);
+}
+
+void
+ShardedCache::remove(quint32 ownerId)
+{
+    for (int i = 0; i < Private::shardCount; ++i)
+    {
+        QMutexLocker locker(&d->shards[i].mutex);
+        foreach (const EntryKey& key, d->shards[i].cache.keys())
+        {
+            if (key.first == ownerId)
+                d->shards[i].cache.remove(key);
+        }
+    }
+}
+
+void
+ShardedCache::setMaximumSize(qint64 maximumSize)
+{
+    d->maximumSize = d->defaultMaximumSize;
+    if (maximumSize > 0)
+        d->maximumSize = maximumSize;
+
+    d->updateShardSizes();
+}
+
+qint64
+ShardedCache::maximumSize() const
+{
+    return d->maximumSize;
+}
+
+qint64
+ShardedCache::size() const
+{
+    qint64 size = 0;
+    for (int i = 0; i < Private::shardCount; ++i)
+    {
+        QMutexLocker locker(&d->shards[i].mutex);
+        size += d->shards[i].cache.totalCost();
+    }
+
+    return size;
+}
+
+int
+ShardedCache::count() const
+{
+    int count = 0;
+    for (int i = 0; i < Private::shardCount; ++i)
+    {
+        QMutexLocker locker(&d->shards[i].mutex);
+        count += d->shards[i].cache.count();
+    }
+
+    return count;
+}
+
+quint64
+ShardedCache::hitCount() const
+{
+    quint64 hitCount = 0;
+    for (int i = 0; i < Private::shardCount; ++i)
+    {
+        QMutexLocker locker(&d->shards[i].mutex);
+        hitCount += d->shards[i].hitCount;
+    }
+
+    return hitCount;
+}
+
+quint64
+ShardedCache::missCount() const
+{
+    quint64 missCount = 0;
+    for (int i = 0; i < Private::shardCount; ++i)
+    {
+        QMutexLocker locker(&d->shards[i].mutex);
+        missCount += d->shards[i].missCount;
+    }
+
+    return missCount;
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_SHARDEDCACHE_H
+#define MULA_PLUGIN_STARDICT_SHARDEDCACHE_H
+
+#include <QtCore/QByteArray>
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Least recently used cache of byte arrays split into shards
+     *
+     * The entries are keyed by the identifier of their owner, as returned by
+     * newOwnerId(), and their position in it. All the entries share one
+     * memory budget, and the least recently used ones are dropped once it is
+     * exceeded. Each shard has its own lock and its own part of the budget,
+     * so concurrent readers rarely wait for each other. The entries are
+     * implicitly shared byte arrays, thus the callers can keep an entry alive
+     * even if it is evicted in the meantime.
+     *
+     * \see ChunkCache, ArticleCache
+     */
+
+    class ShardedCache
+    {
+        public:
+
+            /**
+             * Constructor
+             *
+             * @param   defaultMaximumSize  The memory budget used unless
+             * setMaximumSize() is called
+             * @param   entryOverhead       The bookkeeping overhead charged
+             * for every entry in addition to its size
+             */
+
+            ShardedCache(qint64 defaultMaximumSize, int entryOverhead);
+
+            /**
+             * Destructor
+             */
+
+            virtual ~ShardedCache();
+
+            /**
+             * Removes all the entries of the owner from the cache
+             *
+             * @param   ownerId The identifier of the owner
+             */
+
+            void remove(quint32 ownerId);
+
+            /**
+             * Sets the memory budget of the cache
+             *
+             * @param   maximumSize The maximum number of the cached bytes, or
+             * 0 for the default
+             *
+             * @see maximumSize
+             */
+
+            void setMaximumSize(qint64 maximumSize);
+
+            /**
+             * Returns the memory budget of the cache
+             *
+             * @return  The maximum number of the cached bytes
+             *
+             * @see setMaximumSize
+             */
+
+            qint64 maximumSize() const;
+
+            /**
+             * Returns the number of the bytes currently cached, including the
+             * overhead of the entries
+             *
+             * @return  The size of the cached entries
+             */
+
+            qint64 size() const;
+
+            /**
+             * Returns the number of the entries currently cached
+             *
+             * @return  The number of the cached entries
+             */
+
+            int count() const;
+
+            /**
+             * Returns the number of the lookups served from the cache
+             *
+             * @return  The number of the cache hits
+             *
+             * @see missCount
+             */
+
+            quint64 hitCount() const;
+
+            /**
+             * Returns the number of the lookups not found in the cache
+             *
+             * @return  The number of the cache misses
+             *
+             * @see hitCount
+             */
+
+            quint64 missCount() const;
+
+        protected:
+
+            /**
+             * Returns a new owner identifier
+             *
+             * \note The identifiers are never reused, so a new owner cannot
+             * see the stale entries of a former one.
+             *
+             * @return The owner identifier
+             */
+
+            quint32 newOwnerId();
+
+            /**
+             * Returns the cached entry, and marks it as the most recently used
+             * one
+             *
+             * @param   ownerId     The identifier of the owner
+             * @param   position    The position of the entry in the owner
+             *
+             * @return The entry, or a null byte array if it is not cached
+             *
+             * @see insert
+             */
+
+            QByteArray object(quint32 ownerId, quint64 position);
+
+            /**
+             * Inserts the entry into the cache, and evicts the least recently
+             * used entries of its shard if the budget is exceeded
+             *
+             * @param   ownerId     The identifier of the owner
+             * @param   position    The position of the entry in the owner
+             * @param   object      The entry
+             *
+             * @see object
+             */
+
+            void insert(quint32 ownerId, quint64 position, const QByteArray& object);
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_SHARDEDCACHE_H
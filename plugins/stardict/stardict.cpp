@@ -180,7 +180,17 @@ StarDict::availableDictionaryList()
 QStringList
 StarDict::loadedDictionaryList() const
 {
-    return d->loadedDictionaries.keys();
+    // The dictionaries whose files could not be loaded keep their index, but
+    // they are not reported as loaded
+    QStringList result;
+    for (QHash<QString, int>::const_iterator it = d->loadedDictionaries.constBegin();
+         it != d->loadedDictionaries.constEnd(); ++it)
+    {
+        if (d->dictionaryManager->dictionaryState(it.value()) != StarDictDictionaryManager::DictionaryFailed)
+            result.append(it.key());
+    }
+
+    return result;
 }
 
 void
@@ -239,7 +249,7 @@ StarDict::translate(const QString &dictionary, const QString &word)
 
     return MulaCore::Translation(QString::fromUtf8(d->dictionaryManager->key(index, dictionaryIndex)),
             d->dictionaryManager->dictionaryName(dictionaryIndex),
-            parseData(d->dictionaryManager->data(index, dictionaryIndex).toUtf8(), dictionaryIndex, true,
+            parseData(d->dictionaryManager->articleView(index, dictionaryIndex), dictionaryIndex, true,
                 d->reformatLists, d->expandAbbreviations));
 }
 
@@ -266,56 +276,42 @@ StarDict::findSimilarWords(const QString &dictionary, const QString &word)
 // }
 
 QString
-StarDict::parseData(const QByteArray &data, int dictionaryIndex, bool htmlSpaces, bool reformatLists, bool expandAbbreviations)
+StarDict::parseData(const ArticleView &article, int dictionaryIndex, bool htmlSpaces, bool reformatLists, bool expandAbbreviations)
 {
     Q_UNUSED(expandAbbreviations);
 
     QString result;
-    int position;
 
-    foreach (char ch, data)
+    // Only the text sections are decoded, the sounds and the pictures are
+    // stepped over without being copied
+    for (int i = 0; i < article.sectionCount(); ++i)
     {
-        switch (ch)
+        switch (article.sectionType(i))
         {
             case 'm':
             case 'l':
             case 'g':
             {
-                position += data.length() + 1;
-                result.append(QString::fromUtf8(data));
+                result.append(QString::fromUtf8(article.section(i)));
                 break;
             }
 
             case 't':
             {
-                position += data.length() + 1;
                 result.append("<font class=\"example\">");
-                result.append(QString::fromUtf8(data));
+                result.append(QString::fromUtf8(article.section(i)));
                 result.append("</font>");
                 break;
             }
 
             case 'x':
             {
-                QString string = QString::fromUtf8(data);
-                position += data.length() + 1;
+                QString string = QString::fromUtf8(article.section(i));
                 xdxf2html(string);
                 result.append(string);
                 break;
             }
 
-            case 'y':
-            {
-                position += data.length() + 1;
-                break;
-            }
-
-            case 'W':
-            case 'P':
-            {
-                position += *reinterpret_cast<const quint32*>(data.data()) + sizeof(quint32);
-                break;
-            }
             default:
                 ; // nothing
         }
@@ -331,7 +327,7 @@ StarDict::parseData(const QByteArray &data, int dictionaryIndex, bool htmlSpaces
             if ((index = d->dictionaryManager->simpleLookupWord(result.mid(position, regExp.matchedLength()).toUtf8().data(), dictionaryIndex)) != -1)
             {
                 QString expanded = "<font class=\"explanation\">";
-                expanded += parseData(d->dictionaryManager->data(index, dictionaryIndex).toUtf8());
+                expanded += parseData(d->dictionaryManager->articleView(index, dictionaryIndex));
                 if (result[position + regExp.matchedLength() - 1] == ':')
                     expanded += ':';
 
@@ -106,7 +106,7 @@ namespace MulaPluginStarDict
             friend class SettingsDialog;
 
         private:
-            QString parseData(const QByteArray &data, int dictIndex = -1,
+            QString parseData(const ArticleView &article, int dictIndex = -1,
                     bool htmlSpaces = false, bool reformatLists = false, bool expandAbbreviations = false);
 
             QString findDictionary(const QString &name, const QStringList &dictDirs);
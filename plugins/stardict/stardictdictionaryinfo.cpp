@@ -20,6 +20,8 @@
 #include "stardictdictionaryinfo.h"
 
 #include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QDebug>
 
 using namespace MulaPluginStarDict;
 
@@ -65,110 +67,87 @@ StarDictDictionaryInfo::loadFromIfoFile(const QString& ifoFilePath,
 {
     d->ifoFilePath = ifoFilePath;
     QFile ifoFile(ifoFilePath);
-    QByteArray buffer = ifoFile.readAll();
-
-    if (buffer.isEmpty())
+    if (!ifoFile.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Failed to open file:" << ifoFilePath;
         return false;
+    }
 
-#define TREEDICT_MAGIC_DATA "StarDict's treedict ifo file\nversion=2.4.2\n"
-#define DICT_MAGIC_DATA "StarDict's dict ifo file\nversion=2.4.2\n"
+    QList<QByteArray> lines = ifoFile.readAll().split('\n');
 
-    const QByteArray magicData = isTreeDictionary ? TREEDICT_MAGIC_DATA : DICT_MAGIC_DATA;
-    if (!buffer.startsWith(magicData))
+    const QByteArray magicData = isTreeDictionary ? "StarDict's treedict ifo file" : "StarDict's dict ifo file";
+    if (lines.size() < 2 || lines.at(0).trimmed() != magicData)
         return false;
 
-    QByteArray byteArray;
-    int index;
-
-    byteArray = buffer.mid(strlen(magicData) - 1);
-
-    index = byteArray.indexOf("\nwordcount=");
-    if (index == -1)
+    QByteArray version = lines.at(1).trimmed();
+    if (version != "version=2.4.2" && version != "version=3.0.0")
         return false;
 
-    index += sizeof("\nwordcount=") - 1;
+    bool isWordCountFound = false;
+    bool isIndexFileSizeFound = false;
+    bool isBookNameFound = false;
+    const QByteArray indexFileSizeKey = isTreeDictionary ? "tdxfilesize" : "idxfilesize";
 
-    bool ok;
-    d->wordCount = byteArray.mid(index, byteArray.indexOf('\n', index) - index).toLong(&ok, 10);
+    d->indexOffsetBits = 32;
 
-    if (isTreeDictionary)
+    for (int i = 2; i < lines.size(); ++i)
     {
-        index = byteArray.indexOf("\ntdxfilesize=");
+        const QByteArray& line = lines.at(i);
+        int index = line.indexOf('=');
         if (index == -1)
-            return false;
+            continue;
 
-        index += sizeof("\ntdxfilesize=");
+        QByteArray key = line.left(index);
+        QByteArray value = line.mid(index + 1);
+        if (value.endsWith('\r'))
+            value.chop(1);
 
-        d->indexFileSize = byteArray.mid(index, byteArray.indexOf('\n', index) - index).toLong(&ok, 10);
-    }
-    else
-    {
-        index = byteArray.indexOf("\nidxfilesize=");
-        if (index == -1)
-            return false;
-
-        index += sizeof("\nidxfilesize=");
-
-        d->indexFileSize = byteArray.mid(index, byteArray.indexOf('\n', index) - index).toLong(&ok, 10);
+        if (key == "wordcount")
+        {
+            d->wordCount = value.toULong(&isWordCountFound, 10);
+        }
+        else if (key == indexFileSizeKey)
+        {
+            d->indexFileSize = value.toULong(&isIndexFileSizeFound, 10);
+        }
+        else if (key == "idxoffsetbits")
+        {
+            // Only the version 3.0.0 can have 64-bits offsets
+            if (version == "version=3.0.0")
+                d->indexOffsetBits = value.toULong(0, 10) == 64 ? 64 : 32;
+        }
+        else if (key == "bookname")
+        {
+            d->bookName = QString::fromUtf8(value);
+            isBookNameFound = true;
+        }
+        else if (key == "author")
+        {
+            d->author = QString::fromUtf8(value);
+        }
+        else if (key == "email")
+        {
+            d->email = QString::fromUtf8(value);
+        }
+        else if (key == "website")
+        {
+            d->website = QString::fromUtf8(value);
+        }
+        else if (key == "date")
+        {
+            d->date = QString::fromUtf8(value);
+        }
+        else if (key == "description")
+        {
+            d->description = QString::fromUtf8(value);
+        }
+        else if (key == "sametypesequence")
+        {
+            d->sameTypeSequence = QString::fromUtf8(value);
+        }
     }
 
-    // bookname
-    index = byteArray.indexOf("\nbookname=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\nbookname=");
-    d->bookName = byteArray.indexOf('\n', index);
-
-    // author
-    index = byteArray.indexOf("\nauthor=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\nauthor=");
-    d->author = byteArray.indexOf('\n', index);
-
-    // email
-    index = byteArray.indexOf("\nemail=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\nemail=");
-    d->email = byteArray.indexOf('\n', index);
-
-    // website
-    index = byteArray.indexOf("\nwebsite=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\nwebsite=");
-    d->website = byteArray.indexOf('\n', index);
-
-    // date
-    index = byteArray.indexOf("\ndate=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\ndate=");
-    d->date = byteArray.indexOf('\n', index);
-
-    // description
-    index = byteArray.indexOf("\ndescription=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\ndescription=");
-    d->description = byteArray.indexOf('\n', index);
-
-    // description
-    index = byteArray.indexOf("\nsametypesequence=");
-    if (index == -1)
-        return false;
-
-    index += sizeof("\nsametypesequence=");
-    d->sameTypeSequence = byteArray.indexOf('\n', index);
-
-    return true;
+    return isWordCountFound && isIndexFileSizeFound && isBookNameFound;
 }
 
 void
@@ -19,17 +19,25 @@
 
 #include "stardictdictionarymanager.h"
 
+#include "abstractdatafile.h"
 #include "distance.h"
 #include "dictionary.h"
 #include "file.h"
+#include "fuzzyindex.h"
+#include "prefetcher.h"
 
 #include <QtCore/QtAlgorithms>
 #include <QtCore/QString>
 #include <QtCore/QDir>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
 #include <QtCore/QDebug>
 
 #include <zlib.h>
 
+#include <algorithm>
+
 using namespace MulaPluginStarDict;
 
 // Notice: read src/tools/DICTFILE_FORMAT for the dictionary
@@ -57,6 +65,127 @@ isPureEnglish(const QByteArray& word)
     return true;
 }
 
+struct
+Fuzzystruct
+{
+    QByteArray pMatchWord;
+    QByteArray collationKey;
+    int matchWordDistance;
+};
+
+inline bool
+operator<(const Fuzzystruct & lh, const Fuzzystruct & rh)
+{
+    if (lh.matchWordDistance != rh.matchWordDistance)
+        return lh.matchWordDistance < rh.matchWordDistance;
+
+    if (!lh.pMatchWord.isNull() && !rh.pMatchWord.isNull())
+        return stardictCollationKeyCompare(lh.collationKey, rh.collationKey) < 0;
+
+    return false;
+}
+
+namespace
+{
+    // Loads the data, index and synonym files of a dictionary whose ".ifo"
+    // file has already been parsed, in a thread of the manager's pool, then
+    // builds its trigram index while the dictionary is already looked up
+    class DictionaryLoader : public QRunnable
+    {
+        public:
+            DictionaryLoader(Dictionary *dictionary)
+                : m_dictionary(dictionary)
+            {
+            }
+
+            void run()
+            {
+                if (!m_dictionary->loadFiles())
+                {
+                    qDebug() << "Could not load the files of the dictionary:"
+                        << m_dictionary->ifoFilePath();
+                    return;
+                }
+
+                m_dictionary->buildNgramIndex();
+            }
+
+        private:
+            Dictionary *m_dictionary;
+    };
+
+    // A range of the word entries of a dictionary scanned by one task, and
+    // the matches found in it
+    struct ScanRange
+    {
+        int dictionaryIndex;
+        long first;
+        long last;
+        QVector<int> indexList;
+        QVector<FuzzyIndex::Match> matches;
+    };
+
+    // Looks up the pattern in a range of the word entries of a dictionary
+    class PatternScanTask : public QRunnable
+    {
+        public:
+            PatternScanTask(Dictionary *dictionary, const QString& pattern, int maximumIndexListSize, ScanRange *scanRange)
+                : m_dictionary(dictionary)
+                , m_pattern(pattern)
+                , m_maximumIndexListSize(maximumIndexListSize)
+                , m_scanRange(scanRange)
+            {
+            }
+
+            void run()
+            {
+                m_scanRange->indexList = m_dictionary->lookupPattern(m_pattern, m_maximumIndexListSize,
+                                                                     m_scanRange->first, m_scanRange->last);
+            }
+
+        private:
+            Dictionary *m_dictionary;
+            QString m_pattern;
+            int m_maximumIndexListSize;
+            ScanRange *m_scanRange;
+    };
+
+    // Looks up the similar words in the fuzzy index of a dictionary, or in a
+    // range of its word entries if it has none
+    class FuzzyScanTask : public QRunnable
+    {
+        public:
+            FuzzyScanTask(Dictionary *dictionary, const QString& word, int limit, int maximumCount, ScanRange *scanRange)
+                : m_dictionary(dictionary)
+                , m_word(word)
+                , m_limit(limit)
+                , m_maximumCount(maximumCount)
+                , m_scanRange(scanRange)
+            {
+            }
+
+            void run()
+            {
+                const FuzzyIndex *fuzzyIndex = m_dictionary->fuzzyIndex();
+                if (fuzzyIndex)
+                {
+                    m_scanRange->matches = fuzzyIndex->lookup(m_word, m_limit, m_maximumCount);
+                    return;
+                }
+
+                m_scanRange->matches = m_dictionary->lookupSimilar(m_word, m_limit, m_maximumCount,
+                                                                   m_scanRange->first, m_scanRange->last);
+            }
+
+        private:
+            Dictionary *m_dictionary;
+            QString m_word;
+            int m_limit;
+            int m_maximumCount;
+            ScanRange *m_scanRange;
+    };
+}
+
 class StarDictDictionaryManager::Private
 {
     public:
@@ -73,14 +202,163 @@ class StarDictDictionaryManager::Private
         progress_func_t progressFunction;
 
         QList<Dictionary *> previous;
-        QList<Dictionary *> next;
+
+        // Runs the DictionaryLoader tasks, so the dictionaries are loaded in
+        // parallel while the list keeps the configured order
+        QThreadPool threadPool;
+
+        // Reads ahead of the sequential browsing of the word list
+        Prefetcher prefetcher;
+
+        // Runs the scans of the word entries, one thread per core
+        QThreadPool scanThreadPool;
+
+        QVector<ScanRange> scanRanges(const QList<int>& dictionaryIndexes, bool fuzzyIndexUsed) const;
+        QVector<Fuzzystruct> lookupSimilar(const QString& word, const QList<int>& dictionaryIndexes, int maximumCount);
+
+        // Returns whether each dictionary of the list is loaded. Every step
+        // of the browsing takes one such snapshot, so that all its loops
+        // agree on the dictionaries even if a load finishes meanwhile.
+        QVector<bool> loadedDictionaries() const;
+
+        // Returns the index of the loaded dictionary whose current word comes
+        // first in the merged word list, or invalidIndex
+        int currentDictionary(const int *iCurrent, const QVector<bool>& loaded) const;
 
         bool found;
         static const int maxMatchItemPerLib = 100;
         static const int maximumFuzzyDistance = 3; // at most MAX_FUZZY_DISTANCE-1 differences allowed when find similar words
 
+        // Smaller dictionaries are not worth splitting among the threads
+        static const int minimumScanRangeSize = 16384;
 };
 
+// Splits the word entries of the loaded dictionaries into the ranges scanned
+// in parallel, in the order of a serial scan
+QVector<ScanRange>
+StarDictDictionaryManager::Private::scanRanges(const QList<int>& dictionaryIndexes, bool fuzzyIndexUsed) const
+{
+    QVector<ScanRange> result;
+
+    foreach (int dictionaryIndex, dictionaryIndexes)
+    {
+        Dictionary *dictionary = dictionaryList.at(dictionaryIndex);
+        if (!dictionary->isLoaded())
+            continue;
+
+        long count = dictionary->articleCount();
+        int rangeCount = qBound<long>(1, count / minimumScanRangeSize, scanThreadPool.maxThreadCount());
+
+        // The fuzzy index is looked up as a whole
+        if (fuzzyIndexUsed && dictionary->fuzzyIndex())
+            rangeCount = 1;
+
+        for (int i = 0; i < rangeCount; ++i)
+        {
+            ScanRange scanRange;
+            scanRange.dictionaryIndex = dictionaryIndex;
+            scanRange.first = count * i / rangeCount;
+            scanRange.last = count * (i + 1) / rangeCount;
+            result.append(scanRange);
+        }
+    }
+
+    return result;
+}
+
+QVector<bool>
+StarDictDictionaryManager::Private::loadedDictionaries() const
+{
+    QVector<bool> result(dictionaryList.size());
+    for (int iLib = 0; iLib < dictionaryList.size(); ++iLib)
+        result[iLib] = dictionaryList.at(iLib)->isLoaded();
+
+    return result;
+}
+
+int
+StarDictDictionaryManager::Private::currentDictionary(const int *iCurrent, const QVector<bool>& loaded) const
+{
+    // The words are merged by their collation keys, and only the smallest one
+    // is fetched from the index
+    QByteArray currentCollationKey;
+    QByteArray collationKey;
+    int iCurrentLib = invalidIndex;
+
+    for (int iLib = 0; iLib < dictionaryList.size(); ++iLib)
+    {
+        // The dictionaries still being loaded are left out of the merge
+        if (!loaded.at(iLib))
+            continue;
+
+        if (iCurrent[iLib] == invalidIndex)
+            continue;
+
+        if (iCurrent[iLib] >= dictionaryList.at(iLib)->articleCount() || iCurrent[iLib] < 0)
+            continue;
+
+        collationKey = dictionaryList.at(iLib)->collationKey(iCurrent[iLib]);
+
+        if (iCurrentLib == invalidIndex || stardictCollationKeyCompare(currentCollationKey, collationKey) > 0)
+        {
+            currentCollationKey = collationKey;
+            iCurrentLib = iLib;
+        }
+    }
+
+    return iCurrentLib;
+}
+
+// Looks up the similar words in the given dictionaries in parallel. The
+// matches of the ranges are merged by their distance and their collation
+// key, so the result does not depend on the order the threads finish in.
+QVector<Fuzzystruct>
+StarDictDictionaryManager::Private::lookupSimilar(const QString& word, const QList<int>& dictionaryIndexes, int maximumCount)
+{
+    QVector<ScanRange> ranges = scanRanges(dictionaryIndexes, true);
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        Dictionary *dictionary = dictionaryList.at(ranges.at(i).dictionaryIndex);
+        scanThreadPool.start(new FuzzyScanTask(dictionary, word, maximumFuzzyDistance, maximumCount, &ranges[i]));
+    }
+
+    scanThreadPool.waitForDone();
+
+    QVector<Fuzzystruct> result;
+    QSet<QByteArray> matchWords;
+    foreach (const ScanRange& scanRange, ranges)
+    {
+        Dictionary *dictionary = dictionaryList.at(scanRange.dictionaryIndex);
+        foreach (const FuzzyIndex::Match& match, scanRange.matches)
+        {
+            Fuzzystruct fuzzystruct;
+            fuzzystruct.pMatchWord = dictionary->key(match.index).toUtf8();
+            if (matchWords.contains(fuzzystruct.pMatchWord))
+                continue;
+
+            fuzzystruct.collationKey = dictionary->collationKey(match.index);
+            fuzzystruct.matchWordDistance = match.distance;
+
+            matchWords.insert(fuzzystruct.pMatchWord);
+            result.append(fuzzystruct);
+        }
+    }
+
+    // Every range holds at most maximumCount matches, so only the closest
+    // ones of the merged matches need to be ordered
+    if (result.size() > maximumCount)
+    {
+        std::partial_sort(result.begin(), result.begin() + maximumCount, result.end());
+        result.resize(maximumCount);
+    }
+    else
+    {
+        std::sort(result.begin(), result.end());
+    }
+
+    return result;
+}
+
 StarDictDictionaryManager::StarDictDictionaryManager(progress_func_t progressFunction)
     : d(new Private)
 {
@@ -89,6 +367,9 @@ StarDictDictionaryManager::StarDictDictionaryManager(progress_func_t progressFun
 
 StarDictDictionaryManager::~StarDictDictionaryManager()
 {
+    d->threadPool.waitForDone();
+    d->prefetcher.cancel();
+    d->prefetcher.waitForDone();
     qDeleteAll(d->dictionaryList);
     delete d;
 }
@@ -96,12 +377,13 @@ StarDictDictionaryManager::~StarDictDictionaryManager()
 bool
 StarDictDictionaryManager::loadDictionary(const QString& ifoFilePath)
 {
+    // The progress function is meant for the thread of the caller, thus the
+    // loads in the background do without it
     Dictionary *dictionary = new Dictionary;
-    if (dictionary->load(ifoFilePath))
-    {
-        d->dictionaryList.append(dictionary);
-    }
-    else
+
+    // Only the small ".ifo" file is parsed here, so the position of the
+    // dictionary in the list is known right away
+    if (!dictionary->loadIfoFile(ifoFilePath))
     {
         qDebug() << "Could not load the dictionary according to the given ifo"
             "file:" << ifoFilePath;
@@ -109,9 +391,65 @@ StarDictDictionaryManager::loadDictionary(const QString& ifoFilePath)
         return false;
     }
 
+    d->dictionaryList.append(dictionary);
+    d->threadPool.start(new DictionaryLoader(dictionary));
+
     return true;
 }
 
+bool
+StarDictDictionaryManager::isLoading() const
+{
+    // The pool also runs the builds of the trigram indexes, which do not
+    // keep the dictionaries from being looked up
+    foreach (Dictionary *dictionary, d->dictionaryList)
+    {
+        if (!dictionary->isLoaded() && !dictionary->hasLoadFailed())
+            return true;
+    }
+
+    return false;
+}
+
+void
+StarDictDictionaryManager::waitForLoaded()
+{
+    foreach (Dictionary *dictionary, d->dictionaryList)
+        dictionary->waitForLoaded();
+}
+
+bool
+StarDictDictionaryManager::isDictionaryLoaded(int index) const
+{
+    Q_ASSERT_X( index >= 0 && index < dictionaryCount(), Q_FUNC_INFO, "index out of range in list of dictionaries" );
+    return d->dictionaryList.at(index)->isLoaded();
+}
+
+StarDictDictionaryManager::DictionaryState
+StarDictDictionaryManager::dictionaryState(int index) const
+{
+    Q_ASSERT_X( index >= 0 && index < dictionaryCount(), Q_FUNC_INFO, "index out of range in list of dictionaries" );
+    Dictionary *dictionary = d->dictionaryList.at(index);
+
+    if (dictionary->isLoaded())
+        return DictionaryLoaded;
+
+    if (dictionary->hasLoadFailed())
+        return DictionaryFailed;
+
+    return DictionaryLoading;
+}
+
+bool
+StarDictDictionaryManager::waitForDictionary(int index)
+{
+    Q_ASSERT_X( index >= 0 && index < dictionaryCount(), Q_FUNC_INFO, "index out of range in list of dictionaries" );
+
+    // Only the load of this dictionary is waited for, the others go on in
+    // the background
+    return d->dictionaryList.at(index)->waitForLoaded();
+}
+
 long
 StarDictDictionaryManager::articleCount(int index) const
 {
@@ -146,6 +484,20 @@ StarDictDictionaryManager::data(long dataIndex, int dictionaryIndex)
     return d->dictionaryList.at(dictionaryIndex)->data(dataIndex);
 }
 
+ArticleView
+StarDictDictionaryManager::articleView(long dataIndex, int dictionaryIndex)
+{
+    Q_ASSERT_X( dictionaryIndex >= 0 && dictionaryIndex < dictionaryCount(), Q_FUNC_INFO, "index out of range in list of dictionaries" );
+    return d->dictionaryList.at(dictionaryIndex)->articleView(dataIndex);
+}
+
+Dictionary *
+StarDictDictionaryManager::dictionary(int dictionaryIndex) const
+{
+    Q_ASSERT_X( dictionaryIndex >= 0 && dictionaryIndex < dictionaryCount(), Q_FUNC_INFO, "index out of range in list of dictionaries" );
+    return d->dictionaryList.at(dictionaryIndex);
+}
+
 int
 StarDictDictionaryManager::lookupWord(int dictionaryIndex, const QString& searchWord)
 {
@@ -217,10 +569,18 @@ void
 StarDictDictionaryManager::reloaderHelper(const QString &absolutePath)
 {
     Dictionary *dictionary = reloaderFind(absolutePath);
-    if (dictionary)
-        d->next.append(dictionary);
+
+    // The dictionaries whose files failed to load are loaded from scratch,
+    // since the files may have been fixed meanwhile
+    if (dictionary && !dictionary->hasLoadFailed())
+    {
+        d->dictionaryList.append(dictionary);
+    }
     else
+    {
+        delete dictionary;
         loadDictionary(absolutePath);
+    }
 }
 
 void
@@ -228,6 +588,12 @@ StarDictDictionaryManager::reload(const QStringList& dictionaryDirectoryList,
                                   const QStringList& orderList,
                                   const QStringList& disableList)
 {
+    // The previous dictionaries may still be loading, and some of them are
+    // about to be deleted
+    d->threadPool.waitForDone();
+    d->prefetcher.cancel();
+    d->prefetcher.waitForDone();
+
     d->previous = d->dictionaryList;
     d->dictionaryList.clear();
 
@@ -243,33 +609,20 @@ StarDictDictionaryManager::reload(const QStringList& dictionaryDirectoryList,
     qDeleteAll(d->previous);
 }
 
+Prefetcher *
+StarDictDictionaryManager::prefetcher() const
+{
+    return &d->prefetcher;
+}
+
 QByteArray
 StarDictDictionaryManager::poCurrentWord(int *iCurrent)
 {
-    const char *poCurrentWord = NULL;
-    const char *word;
+    int iCurrentLib = d->currentDictionary(iCurrent, d->loadedDictionaries());
+    if (iCurrentLib == invalidIndex)
+        return QByteArray();
 
-    for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
-    {
-        if (iCurrent[iLib] == invalidIndex)
-            continue;
-
-        if (iCurrent[iLib] >= articleCount(iLib) || iCurrent[iLib] < 0)
-            continue;
-
-        if (poCurrentWord == NULL )
-        {
-            poCurrentWord = key(iCurrent[iLib], iLib);
-        }
-        else
-        {
-            word = key(iCurrent[iLib], iLib);
-
-            if (stardictStringCompare(poCurrentWord, word) > 0 )
-                poCurrentWord = word;
-        }
-    }
-    return poCurrentWord;
+    return key(iCurrent[iCurrentLib], iCurrentLib);
 }
 
 QByteArray
@@ -278,14 +631,25 @@ StarDictDictionaryManager::poNextWord(QByteArray searchWord, int* iCurrent)
     // the input can be:
     // (word,iCurrent),read word,write iNext to iCurrent,and return next word. used by TopWin::NextCallback();
     // (NULL,iCurrent),read iCurrent,write iNext to iCurrent,and return next word. used by AppCore::ListWords();
-    QByteArray currentWord = NULL;
+    QByteArray currentCollationKey;
     QVector<Dictionary *>::size_type iCurrentLib = 0;
-    const char *word;
+    QByteArray collationKey;
+    QByteArray currentWord;
+    QVector<bool> loaded = d->loadedDictionaries();
 
     for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
     {
+        // The position in a dictionary still being loaded is not known, so
+        // the dictionary stays out of the browsing until the next lookup
+        if (!loaded.at(iLib))
+        {
+            iCurrent[iLib] = invalidIndex;
+            continue;
+        }
+
+        // Start from the nearest word if the word itself is not found
         if (!searchWord.isEmpty())
-            iCurrent[iLib] = d->dictionaryList.at(iLib)->lookup(searchWord);
+            d->dictionaryList.at(iLib)->lookup(searchWord, &iCurrent[iLib]);
 
         if (iCurrent[iLib] == invalidIndex)
             continue;
@@ -293,24 +657,16 @@ StarDictDictionaryManager::poNextWord(QByteArray searchWord, int* iCurrent)
         if (iCurrent[iLib] >= articleCount(iLib) || iCurrent[iLib] < 0)
             continue;
 
-        if (currentWord.isNull())
+        collationKey = d->dictionaryList.at(iLib)->collationKey(iCurrent[iLib]);
+
+        if (currentCollationKey.isNull() || stardictCollationKeyCompare(currentCollationKey, collationKey) > 0)
         {
-            currentWord = key(iCurrent[iLib], iLib);
+            currentCollationKey = collationKey;
             iCurrentLib = iLib;
         }
-        else
-        {
-            word = key(iCurrent[iLib], iLib);
-
-            if (stardictStringCompare(currentWord, word) > 0 )
-            {
-                currentWord = word;
-                iCurrentLib = iLib;
-            }
-        }
     }
 
-    if (!currentWord.isEmpty())
+    if (!currentCollationKey.isEmpty())
     {
         iCurrent[iCurrentLib]++;
         for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
@@ -318,17 +674,25 @@ StarDictDictionaryManager::poNextWord(QByteArray searchWord, int* iCurrent)
             if (iLib == iCurrentLib)
                 continue;
 
-            if (iCurrent[iLib] == invalidIndex)
+            if (!loaded.at(iLib) || iCurrent[iLib] == invalidIndex)
                 continue;
 
             if ( iCurrent[iLib] >= articleCount(iLib) || iCurrent[iLib] < 0)
                 continue;
 
-            if (strcmp(currentWord, key(iCurrent[iLib], iLib)) == 0 )
+            if (currentCollationKey == d->dictionaryList.at(iLib)->collationKey(iCurrent[iLib]))
                 iCurrent[iLib]++;
         }
 
-        currentWord = poCurrentWord(iCurrent);
+        int iNextLib = d->currentDictionary(iCurrent, loaded);
+        if (iNextLib != invalidIndex)
+            currentWord = key(iCurrent[iNextLib], iNextLib);
+
+        for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
+        {
+            if (loaded.at(iLib) && iCurrent[iLib] != invalidIndex && iCurrent[iLib] < articleCount(iLib))
+                d->prefetcher.accessed(d->dictionaryList.at(iLib), iCurrent[iLib]);
+        }
     }
     return currentWord;
 }
@@ -337,12 +701,23 @@ QByteArray
 StarDictDictionaryManager::poPreviousWord(long *iCurrent)
 {
     // used by TopWin::PreviousCallback(); the iCurrent is cached by AppCore::TopWinWordChange();
-    QByteArray poCurrentWord = NULL;
+    QByteArray currentCollationKey;
     QVector<Dictionary *>::size_type iCurrentLib = 0;
-    const char *word;
+    QByteArray collationKey;
+    QByteArray poCurrentWord;
+    QVector<bool> loaded = d->loadedDictionaries();
 
     for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
     {
+        // The position in a dictionary still being loaded is not known, so
+        // the dictionary is left before its first word, where the browsing
+        // backwards skips it
+        if (!loaded.at(iLib))
+        {
+            iCurrent[iLib] = 0;
+            continue;
+        }
+
         if (iCurrent[iLib] == invalidIndex)
             iCurrent[iLib] = articleCount(iLib);
         else
@@ -351,34 +726,31 @@ StarDictDictionaryManager::poPreviousWord(long *iCurrent)
                 continue;
         }
 
-        if ( poCurrentWord.isNull() )
+        collationKey = d->dictionaryList.at(iLib)->collationKey(iCurrent[iLib] - 1);
+
+        if (currentCollationKey.isNull() || stardictCollationKeyCompare(currentCollationKey, collationKey) < 0)
         {
-            poCurrentWord = key(iCurrent[iLib] - 1, iLib);
+            currentCollationKey = collationKey;
             iCurrentLib = iLib;
         }
-        else
-        {
-            word = key(iCurrent[iLib] - 1, iLib);
-            if (stardictStringCompare(poCurrentWord, word) < 0 )
-            {
-                poCurrentWord = word;
-                iCurrentLib = iLib;
-            }
-        }
     }
 
-    if (!poCurrentWord.isEmpty())
+    if (!currentCollationKey.isEmpty())
     {
+        poCurrentWord = key(iCurrent[iCurrentLib] - 1, iCurrentLib);
         iCurrent[iCurrentLib]--;
         for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
         {
             if (iLib == iCurrentLib)
                 continue;
 
+            if (!loaded.at(iLib))
+                continue;
+
             if (iCurrent[iLib] > articleCount(iLib) || iCurrent[iLib] <= 0)
                 continue;
 
-            if (poCurrentWord == key(iCurrent[iLib] - 1, iLib))
+            if (currentCollationKey == d->dictionaryList.at(iLib)->collationKey(iCurrent[iLib] - 1))
             {
                 iCurrent[iLib]--;
             }
@@ -388,6 +760,12 @@ StarDictDictionaryManager::poPreviousWord(long *iCurrent)
                     iCurrent[iLib] = invalidIndex;
             }
         }
+
+        for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
+        {
+            if (loaded.at(iLib) && iCurrent[iLib] != invalidIndex && iCurrent[iLib] < articleCount(iLib))
+                d->prefetcher.accessed(d->dictionaryList.at(iLib), iCurrent[iLib]);
+        }
     }
     return poCurrentWord;
 }
@@ -560,6 +938,9 @@ StarDictDictionaryManager::lookupSimilarWord(QByteArray searchWord, int iLib)
 int
 StarDictDictionaryManager::simpleLookupWord(QByteArray searchWord, int iLib)
 {
+    if (!waitForDictionary(iLib))
+        return invalidIndex;
+
     int retval;
 
     if ((retval = d->dictionaryList.at(iLib)->lookup(searchWord)) == -1) {
@@ -569,122 +950,40 @@ StarDictDictionaryManager::simpleLookupWord(QByteArray searchWord, int iLib)
     return retval;
 }
 
-struct
-Fuzzystruct
+bool
+StarDictDictionaryManager::lookupWithFuzzy(QByteArray searchWord, QStringList& resultList, int resultListSize, int iLib)
 {
-    QByteArray pMatchWord;
-    int matchWordDistance;
-};
+    if (searchWord.isEmpty() || !waitForDictionary(iLib))
+        return false;
 
-inline bool
-operator<(const Fuzzystruct & lh, const Fuzzystruct & rh)
-{
-    if (lh.matchWordDistance != rh.matchWordDistance)
-        return lh.matchWordDistance < rh.matchWordDistance;
+    if (d->progressFunction)
+        d->progressFunction();
 
-    if (!lh.pMatchWord.isNull() && !rh.pMatchWord.isNull())
-        return stardictStringCompare(lh.pMatchWord, rh.pMatchWord) < 0;
+    QVector<Fuzzystruct> oFuzzystruct = d->lookupSimilar(QString::fromUtf8(searchWord).toLower(), QList<int>() << iLib, resultListSize);
+    foreach (const Fuzzystruct& fuzzystruct, oFuzzystruct)
+        resultList.append(QString::fromUtf8(fuzzystruct.pMatchWord));
 
-    return false;
+    return !oFuzzystruct.isEmpty();
 }
 
 bool
-StarDictDictionaryManager::lookupWithFuzzy(QByteArray searchWord, QStringList resultList, int resultListSize, int iLib)
+StarDictDictionaryManager::lookupWithFuzzy(QByteArray searchWord, QStringList& resultList, int resultListSize)
 {
     if (searchWord.isEmpty())
         return false;
 
-    Fuzzystruct *oFuzzystruct = new Fuzzystruct[resultListSize];
-
-    for (int i = 0; i < resultListSize; ++i)
-    {
-        oFuzzystruct[i].pMatchWord = NULL;
-        oFuzzystruct[i].matchWordDistance = d->maximumFuzzyDistance;
-    }
-
-    int maximumDistance = d->maximumFuzzyDistance;
-    int iDistance;
-    bool found = false;
-    EditDistance oEditDistance;
-
-    long searchCheckWordLength;
-    long searchWordLength;
-    QString searchCheckWord;
-
-    searchWord.toLower();
-
     if (d->progressFunction)
         d->progressFunction();
 
+    QList<int> dictionaryIndexes;
+    for (int iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
+        dictionaryIndexes.append(iLib);
 
-    //if (stardict_strcmp(searchWord, poGetWord(0,iLib))>=0 && stardict_strcmp(searchWord, poGetWord(articleCount(iLib)-1,iLib))<=0) {
-    //there are Chinese dicts and English dicts...
-    if (true)
-    {
-        int wordNumber = articleCount(iLib);
-        for (int index = 0; index < wordNumber; ++index)
-        {
-            searchCheckWord = key(index, iLib);
-            // tolower and skip too long or too short words
-            searchCheckWordLength = searchCheckWord.length();
-            searchWordLength = searchWord.length();
-            if (searchCheckWordLength - searchWordLength >= maximumDistance
-                    || searchWordLength - searchCheckWordLength >= maximumDistance)
-                continue;
-
-            searchCheckWord.toLower();
-
-            iDistance = oEditDistance.calEditDistance(searchCheckWord, searchWord, maximumDistance);
-            if (iDistance < maximumDistance && iDistance < searchWordLength)
-            {
-                // when searchWordLength=1,2 we need less fuzzy.
-                found = true;
-                bool isAlreadyInList = false;
-                int maximumDistanceAt = 0;
-                for (int j = 0; j < resultListSize; ++j)
-                {
-                    if (!oFuzzystruct[j].pMatchWord.isNull() && searchCheckWord.compare(oFuzzystruct[j].pMatchWord) == 0)
-                    { //already in list
-                        isAlreadyInList = true;
-                        break;
-                    }
-
-                    //find the position,it will certainly be found (include the first time) as iMaxDistance is set by last time.
-                    if (oFuzzystruct[j].matchWordDistance == maximumDistance )
-                    {
-                        maximumDistanceAt = j;
-                    }
-                }
-
-                if (!isAlreadyInList)
-                {
-                    oFuzzystruct[maximumDistanceAt].pMatchWord = searchCheckWord.toUtf8();
-                    oFuzzystruct[maximumDistanceAt].matchWordDistance = iDistance;
-                    // calc new iMaxDistance
-                    maximumDistance = iDistance;
-                    int tmpVal = maximumDistance; //stupid workaround for gcc bug 44545
-                    for (int j = 0; j < resultListSize; ++j)
-                    {
-                        if (oFuzzystruct[j].matchWordDistance > maximumDistance)
-                            tmpVal = oFuzzystruct[j].matchWordDistance;
-                    } // calc new iMaxDistance
-
-                    maximumDistance = tmpVal; // end of stupid workaround
-                }   // add to list
-            }   // find one
-        }   // each word
-    }   // ok for search
-//    }   // each lib
-
-    if (found) // sort with distance
-        qSort(oFuzzystruct, oFuzzystruct + resultListSize);
-
-    for (int i = 0; i < resultListSize; ++i)
-        resultList[i] = oFuzzystruct[i].pMatchWord;
-
-    delete [] oFuzzystruct;
+    QVector<Fuzzystruct> oFuzzystruct = d->lookupSimilar(QString::fromUtf8(searchWord).toLower(), dictionaryIndexes, resultListSize);
+    foreach (const Fuzzystruct& fuzzystruct, oFuzzystruct)
+        resultList.append(QString::fromUtf8(fuzzystruct.pMatchWord));
 
-    return found;
+    return !oFuzzystruct.isEmpty();
 }
 
 inline bool
@@ -694,18 +993,42 @@ lessForCompare(QString lh, QString rh)
 }
 
 int
-StarDictDictionaryManager::lookupPattern(QByteArray patternWord, QStringList patternMatchWords)
+StarDictDictionaryManager::lookupPattern(QByteArray patternWord, QStringList& patternMatchWords)
 {
     QVector<int> indexList;
     indexList.reserve(d->maxMatchItemPerLib + 1);
     int matchCount = 0;
 
-    for (QVector<Dictionary *>::size_type iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
+    QList<int> dictionaryIndexes;
+    for (int iLib = 0; iLib < d->dictionaryList.size(); ++iLib)
+        dictionaryIndexes.append(iLib);
+
+    // The ranges of all the dictionaries are scanned in parallel
+    QString pattern = QString::fromUtf8(patternWord);
+    QVector<ScanRange> ranges = d->scanRanges(dictionaryIndexes, false);
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        Dictionary *dictionary = d->dictionaryList.at(ranges.at(i).dictionaryIndex);
+        d->scanThreadPool.start(new PatternScanTask(dictionary, pattern, d->maxMatchItemPerLib + 1, &ranges[i]));
+    }
+
+    d->scanThreadPool.waitForDone();
+
+    for (int rangeIndex = 0; rangeIndex < ranges.size(); )
     {
         //if(oStarDictDictionaryManager.LookdupWordsWithRule(pspec,indexList,MAX_MATCH_ITEM_PER_LIB+1-iMatchCount,iLib))
         // -iMatchCount,so save time,but may got less result and the word may repeat.
 
-        indexList = d->dictionaryList.at(iLib)->lookupPattern(patternWord, d->maxMatchItemPerLib + 1);
+        // The ranges are joined in their order, thus the first matches are
+        // the same as the ones of a serial scan
+        int iLib = ranges.at(rangeIndex).dictionaryIndex;
+        indexList.clear();
+        for ( ; rangeIndex < ranges.size() && ranges.at(rangeIndex).dictionaryIndex == iLib; ++rangeIndex)
+            indexList += ranges.at(rangeIndex).indexList;
+
+        if (indexList.size() > d->maxMatchItemPerLib)
+            indexList.resize(d->maxMatchItemPerLib);
+
         if (!indexList.isEmpty())
         {
             if (d->progressFunction)
@@ -717,7 +1040,10 @@ StarDictDictionaryManager::lookupPattern(QByteArray patternWord, QStringList pat
                 QByteArray searchMatchWord = key(indexList.at(i), iLib);
 
                 if (!patternMatchWords.contains(searchMatchWord))
+                {
                     patternMatchWords.append(searchMatchWord);
+                    ++matchCount;
+                }
             }
         }
     }
@@ -781,12 +1107,17 @@ StarDictDictionaryManager::lookupData(QByteArray search_word, QStringList result
     quint32 maximumSize = 0;
     for (QVector<Dictionary *>::size_type i = 0; i < d->dictionaryList.size(); ++i)
     {
-        if (!d->dictionaryList.at(i)->containFindData())
+        if (!d->dictionaryList.at(i)->isLoaded() || !d->dictionaryList.at(i)->containFindData())
             continue;
 
         if (d->progressFunction)
             d->progressFunction();
 
+        // The articles are mostly stored in the order of the index, so the
+        // data file is read front to back
+        AbstractDataFile *dataFile = d->dictionaryList.at(i)->compressedDictionaryFile();
+        dataFile->setAccessPattern(AbstractDataFile::SequentialAccess);
+
         int wordSize = articleCount(i);
         for (int j = 0; j < wordSize; ++j)
         {
@@ -799,6 +1130,8 @@ StarDictDictionaryManager::lookupData(QByteArray search_word, QStringList result
             if (d->dictionaryList.at(i)->findData(searchWords, wordEntry.dataOffset(), wordEntry.dataSize()))
                 resultList[i].append(wordEntry.data());
         }
+
+        dataFile->setAccessPattern(AbstractDataFile::NormalAccess);
     }
 
     QVector<Dictionary *>::size_type i;
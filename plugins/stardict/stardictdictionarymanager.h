@@ -20,6 +20,7 @@
 #ifndef MULA_PLUGIN_STARDICT_DICTIONARYMANAGER_H
 #define MULA_PLUGIN_STARDICT_DICTIONARYMANAGER_H
 
+#include "articleview.h"
 #include "dictionaryzip.h"
 
 #include <QtCore/QStringList>
@@ -27,6 +28,7 @@
 namespace MulaPluginStarDict
 {
     class Dictionary;
+    class Prefetcher;
     class StarDictDictionaryManager
     {
         public:
@@ -37,6 +39,17 @@ namespace MulaPluginStarDict
                 DATA,
             };
 
+            /**
+             * The state of the files of a dictionary in the list
+             */
+
+            enum DictionaryState
+            {
+                DictionaryLoading,  // Being loaded in the background
+                DictionaryLoaded,   // Can be looked up
+                DictionaryFailed    // Could not be loaded, left out of the lookups
+            };
+
             typedef void (*progress_func_t)(void);
 
             /**
@@ -53,15 +66,89 @@ namespace MulaPluginStarDict
             /**
              * Loads the dictionary according to the ifo file path
              *
+             * \note Only the ifo file is loaded synchronously, and the
+             * dictionary is appended to the list right away. Its data, index
+             * and synonym files are loaded in a background thread. Until that
+             * finishes, the browsing of the word list and the lookups of all
+             * the dictionaries skip it, and the lookups of that dictionary
+             * alone wait for it. The progress function is not called by these
+             * loads.
+             *
              * @param ifoFilePath The path of the relevant ifo file
              *
-             * @return True if the loading was successful, otherwise false.
+             * @return True if the ifo file was loaded successfully, otherwise
+             * false.
              *
-             * @see load, reload
+             * @see load, reload, isLoading, waitForLoaded, dictionaryState
              */
 
             bool loadDictionary(const QString& ifoFilePath);
 
+            /**
+             * Returns whether or not some of the dictionaries are still being
+             * loaded in the background
+             *
+             * @return True if any dictionary is being loaded, otherwise false
+             *
+             * @see waitForLoaded, isDictionaryLoaded
+             */
+
+            bool isLoading() const;
+
+            /**
+             * Blocks until all the dictionaries have been loaded
+             *
+             * @see isLoading
+             */
+
+            void waitForLoaded();
+
+            /**
+             * Returns whether or not the files of the dictionary at the given
+             * index of the dictionary list have been loaded. Index must be a
+             * valid index position, i.e. between 0 and dictionaryCount()-1.
+             *
+             * @param index The desired index in the list
+             *
+             * @return True if the dictionary can be looked up, otherwise false
+             *
+             * @see isLoading
+             */
+
+            bool isDictionaryLoaded(int index) const;
+
+            /**
+             * Returns the state of the dictionary at the given index of the
+             * dictionary list. Index must be a valid index position, i.e.
+             * between 0 and dictionaryCount()-1.
+             *
+             * The dictionaries whose files fail to load stay in the list, so
+             * the indexes do not change, but they are left out of the lookups.
+             *
+             * @param index The desired index in the list
+             *
+             * @return The state of the dictionary
+             *
+             * @see waitForDictionary
+             */
+
+            DictionaryState dictionaryState(int index) const;
+
+            /**
+             * Blocks until the dictionary at the given index of the
+             * dictionary list is not being loaded anymore. Index must be a
+             * valid index position, i.e. between 0 and dictionaryCount()-1.
+             *
+             * @param index The desired index in the list
+             *
+             * @return True if the dictionary can be looked up, false if its
+             * files could not be loaded
+             *
+             * @see dictionaryState
+             */
+
+            bool waitForDictionary(int index);
+
             void load(const QStringList& dictionaryDirs,
                       const QStringList& orderList,
                       const QStringList& disableList);
@@ -139,6 +226,47 @@ namespace MulaPluginStarDict
 
             QString data(long dataIndex, int dictionaryIndex);
 
+            /**
+             * Returns a view of the typed sections of the word data of the
+             * relevant dictionary according to the given index
+             *
+             * @param   dataIndex       The index of the desired word data
+             * @param   dictionaryIndex The index of the desired dictionary
+             *
+             * @return The view of the word data
+             *
+             * @see data
+             */
+
+            ArticleView articleView(long dataIndex, int dictionaryIndex);
+
+            /**
+             * Returns the dictionary at the given index, e.g. to export all of
+             * its articles with an ArticleIterator
+             *
+             * \note The dictionary is owned by the manager, and is deleted by
+             * reload() unless it is kept.
+             *
+             * @param   dictionaryIndex The index of the desired dictionary
+             *
+             * @return The dictionary
+             *
+             * @see ArticleIterator
+             */
+
+            Dictionary *dictionary(int dictionaryIndex) const;
+
+            /**
+             * Returns the prefetcher that reads the word entries ahead while
+             * poNextWord() and poPreviousWord() browse the word list
+             *
+             * \note The prefetcher is disabled by default.
+             *
+             * @return The prefetcher of the dictionaries
+             */
+
+            Prefetcher *prefetcher() const;
+
             QByteArray poCurrentWord(int *iCurrent);
             QByteArray poNextWord(QByteArray searchWord, int* iCurrent);
             QByteArray poPreviousWord(long *iCurrent);
@@ -153,8 +281,30 @@ namespace MulaPluginStarDict
             int lookupSimilarWord(QByteArray searchWord, int iLib);
             int simpleLookupWord(QByteArray searchWord, int iLib);
 
-            bool lookupWithFuzzy(QByteArray searchWord, QStringList resultList, int resultListSize, int iLib);
-            int lookupPattern(QByteArray searchWord, QStringList resultList);
+            bool lookupWithFuzzy(QByteArray searchWord, QStringList& resultList, int resultListSize, int iLib);
+
+            /**
+             * Looks up the words similar to the search word in all the loaded
+             * dictionaries at once. The dictionaries, and the word entries of
+             * the large ones without a fuzzy index, are scanned in parallel,
+             * and the matches are merged by their edit distance and their
+             * collation key.
+             *
+             * \note Like the other lookups of all the dictionaries, it does
+             * not wait for the dictionaries still being loaded, and leaves
+             * them out together with the ones that failed to load, see
+             * dictionaryState().
+             *
+             * @param   searchWord      The search word
+             * @param   resultList      The list the similar words are appended
+             * to, the closest first
+             * @param   resultListSize  The maximum number of the similar words
+             *
+             * @return True if any similar word was found, otherwise false
+             */
+
+            bool lookupWithFuzzy(QByteArray searchWord, QStringList& resultList, int resultListSize);
+            int lookupPattern(QByteArray searchWord, QStringList& resultList);
             bool lookupData(QByteArray searchWord, QStringList resultList);
 
             QueryType analyzeQuery(QString string, QString& result);
@@ -0,0 +1,69 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "articlecachetest.h"
+
+#include <plugins/stardict/articlecache.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+ArticleCacheTest::ArticleCacheTest()
+{
+}
+
+ArticleCacheTest::~ArticleCacheTest()
+{
+}
+
+void ArticleCacheTest::testLargeOffsets()
+{
+    ArticleCache articleCache;
+    quint32 dictionaryId = articleCache.newDictionaryId();
+    quint64 largeOffset = (quint64(1) << 32) + 100;
+
+    articleCache.insert(dictionaryId, 100, QByteArray("small"));
+    QVERIFY(articleCache.article(dictionaryId, largeOffset).isNull());
+
+    // Offsets beyond 4 GB do not collide with the small ones
+    articleCache.insert(dictionaryId, largeOffset, QByteArray("large"));
+    QCOMPARE(articleCache.article(dictionaryId, 100), QByteArray("small"));
+    QCOMPARE(articleCache.article(dictionaryId, largeOffset), QByteArray("large"));
+}
+
+void ArticleCacheTest::testEntryOverhead()
+{
+    ArticleCache articleCache;
+    quint32 dictionaryId = articleCache.newDictionaryId();
+    QByteArray article(10, 'a');
+
+    // The small articles are charged for their bookkeeping too, so that
+    // many of them cannot exceed the budget
+    articleCache.insert(dictionaryId, 0, article);
+    QVERIFY(articleCache.size() > qint64(article.size()));
+
+    qint64 entrySize = articleCache.size();
+    articleCache.insert(dictionaryId, 10, article);
+    QCOMPARE(articleCache.size(), 2 * entrySize);
+}
+
+QTEST_MAIN(ArticleCacheTest)
+
+#include "articlecachetest.moc"
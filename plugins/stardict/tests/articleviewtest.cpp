@@ -0,0 +1,105 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "articleviewtest.h"
+
+#include <plugins/stardict/articleview.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    QByteArray bigEndianSize(quint32 size)
+    {
+        uchar data[sizeof(quint32)];
+        qToBigEndian<quint32>(size, data);
+        return QByteArray(reinterpret_cast<const char *>(data), sizeof(data));
+    }
+}
+
+ArticleViewTest::ArticleViewTest()
+{
+}
+
+ArticleViewTest::~ArticleViewTest()
+{
+}
+
+void ArticleViewTest::testSameTypeSequence()
+{
+    // The size or the terminator of the last section is omitted
+    QByteArray data = QByteArray("phonetic", 9) + bigEndianSize(3) + "wav" + "meaning";
+    ArticleView article(data, "tWm");
+
+    QCOMPARE(article.indexOf('m'), 2);
+    QCOMPARE(article.sectionCount(), 3);
+    QCOMPARE(article.sectionType(0), 't');
+    QCOMPARE(article.section(0), QByteArray("phonetic"));
+    QCOMPARE(article.sectionType(1), 'W');
+    QCOMPARE(article.section(1), QByteArray("wav"));
+    QCOMPARE(article.section(2), QByteArray("meaning"));
+
+    QCOMPARE(article.sectionType(3), '\0');
+    QVERIFY(article.section(3).isNull());
+    QCOMPARE(article.indexOf('x'), -1);
+}
+
+void ArticleViewTest::testEmbeddedTypes()
+{
+    QByteArray data = QByteArray("P") + bigEndianSize(4) + QByteArray("\0png", 4) + QByteArray("mmeaning", 9);
+    ArticleView article(data);
+
+    QCOMPARE(article.sectionCount(), 2);
+    QCOMPARE(article.sectionType(0), 'P');
+    QCOMPARE(article.section(0), QByteArray("\0png", 4));
+    QCOMPARE(article.sectionType(1), 'm');
+    QCOMPARE(article.section(1), QByteArray("meaning"));
+
+    QVERIFY(ArticleView().isNull());
+    QCOMPARE(ArticleView().sectionCount(), 0);
+}
+
+void ArticleViewTest::testTypedData()
+{
+    QByteArray data = QByteArray("phonetic", 9) + bigEndianSize(3) + "wav" + "meaning";
+    QByteArray typedData = QByteArray("tphonetic", 10) + "W" + bigEndianSize(3) + "wav" + QByteArray("mmeaning", 9);
+
+    QCOMPARE(ArticleView(data, "tWm").toTypedData(), typedData);
+    QCOMPARE(ArticleView(typedData).toTypedData(), typedData);
+
+    // The last upper case section gets its size
+    QCOMPARE(ArticleView("wav", "W").toTypedData(), QByteArray("W") + bigEndianSize(3) + "wav");
+}
+
+void ArticleViewTest::testTruncated()
+{
+    // The size of the picture points beyond the end of the article
+    ArticleView article(QByteArray("P") + bigEndianSize(100) + "png");
+    QCOMPARE(article.sectionCount(), 1);
+    QCOMPARE(article.section(0), QByteArray("png"));
+
+    // The terminator of the last embedded section is missing
+    QCOMPARE(ArticleView("mmeaning").section(0), QByteArray("meaning"));
+}
+
+QTEST_MAIN(ArticleViewTest)
+
+#include "articleviewtest.moc"
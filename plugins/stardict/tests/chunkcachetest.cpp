@@ -0,0 +1,55 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "chunkcachetest.h"
+
+#include <plugins/stardict/chunkcache.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+ChunkCacheTest::ChunkCacheTest()
+{
+}
+
+ChunkCacheTest::~ChunkCacheTest()
+{
+}
+
+void ChunkCacheTest::testFileIds()
+{
+    ChunkCache chunkCache;
+    quint32 fileId1 = chunkCache.newFileId();
+    quint32 fileId2 = chunkCache.newFileId();
+    QVERIFY(fileId1 != fileId2);
+
+    chunkCache.insert(fileId1, 0, QByteArray("first"));
+    chunkCache.insert(fileId2, 0, QByteArray("second"));
+    QCOMPARE(chunkCache.chunk(fileId1, 0), QByteArray("first"));
+    QCOMPARE(chunkCache.chunk(fileId2, 0), QByteArray("second"));
+    QVERIFY(chunkCache.chunk(fileId1, 1).isNull());
+
+    // The chunks are charged for their size only
+    QCOMPARE(chunkCache.size(), qint64(11));
+}
+
+QTEST_MAIN(ChunkCacheTest)
+
+#include "chunkcachetest.moc"
@@ -0,0 +1,91 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "collationkeytest.h"
+
+#include <plugins/stardict/file.h>
+
+#include <QtTest/QtTest>
+
+CollationKeyTest::CollationKeyTest()
+{
+}
+
+CollationKeyTest::~CollationKeyTest()
+{
+}
+
+static int sign(int value)
+{
+    return value < 0 ? -1 : value > 0;
+}
+
+static void addWordPairs()
+{
+    QTest::addColumn<QString>("string1");
+    QTest::addColumn<QString>("string2");
+
+    QTest::newRow("equal") << "word" << "word";
+    QTest::newRow("case") << "Word" << "word";
+    QTest::newRow("case before letter") << "WORD" << "wore";
+    QTest::newRow("prefix") << "word" << "words";
+    QTest::newRow("empty") << "" << "a";
+    QTest::newRow("punctuation") << "a-b" << "a_b";
+    QTest::newRow("latin1") << QString::fromUtf8("Äpfel") << QString::fromUtf8("äpfel");
+    QTest::newRow("latin1 and ascii") << QString::fromUtf8("émigré") << "emigre";
+    QTest::newRow("cyrillic") << QString::fromUtf8("Слово") << QString::fromUtf8("слово");
+    QTest::newRow("cjk") << QString::fromUtf8("字典") << QString::fromUtf8("字");
+    QTest::newRow("supplementary") << QString::fromUtf8("\xf0\x9d\x90\x80") << QString::fromUtf8("\xef\xbf\xbd");
+    QTest::newRow("deseret case") << QString::fromUtf8("\xf0\x90\x90\x80") << QString::fromUtf8("\xf0\x90\x90\xa8");
+}
+
+void CollationKeyTest::testStringCompare_data()
+{
+    addWordPairs();
+}
+
+void CollationKeyTest::testStringCompare()
+{
+    QFETCH(QString, string1);
+    QFETCH(QString, string2);
+
+    QCOMPARE(sign(stardictStringCompare(string1.toUtf8(), string2.toUtf8())), sign(stardictStringCompare(string1, string2)));
+    QCOMPARE(sign(stardictStringCompare(string2.toUtf8(), string1.toUtf8())), sign(stardictStringCompare(string2, string1)));
+}
+
+void CollationKeyTest::testCollationKeyCompare_data()
+{
+    addWordPairs();
+}
+
+void CollationKeyTest::testCollationKeyCompare()
+{
+    QFETCH(QString, string1);
+    QFETCH(QString, string2);
+
+    QByteArray collationKey1 = stardictCollationKey(string1.toUtf8());
+    QByteArray collationKey2 = stardictCollationKey(string2.toUtf8());
+
+    QCOMPARE(sign(stardictCollationKeyCompare(collationKey1, collationKey2)), sign(stardictStringCompare(string1, string2)));
+    QCOMPARE(sign(stardictCollationKeyCompare(collationKey2, collationKey1)), sign(stardictStringCompare(string2, string1)));
+}
+
+QTEST_MAIN(CollationKeyTest)
+
+#include "collationkeytest.moc"
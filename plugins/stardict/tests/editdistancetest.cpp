@@ -0,0 +1,163 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "editdistancetest.h"
+
+#include <plugins/stardict/distance.h>
+
+#include <QtTest/QtTest>
+
+namespace
+{
+    // The optimal string alignment distance by the textbook matrix
+    int referenceDistance(const QString& s, const QString& t)
+    {
+        QVector<QVector<int> > d(s.length() + 1, QVector<int>(t.length() + 1));
+        for (int i = 0; i <= s.length(); ++i)
+            d[i][0] = i;
+
+        for (int j = 0; j <= t.length(); ++j)
+            d[0][j] = j;
+
+        for (int i = 1; i <= s.length(); ++i)
+        {
+            for (int j = 1; j <= t.length(); ++j)
+            {
+                int cost = s.at(i - 1) == t.at(j - 1) ? 0 : 1;
+                d[i][j] = qMin(qMin(d[i - 1][j] + 1, d[i][j - 1] + 1), d[i - 1][j - 1] + cost);
+
+                if (i > 1 && j > 1 && s.at(i - 1) == t.at(j - 2) && s.at(i - 2) == t.at(j - 1))
+                    d[i][j] = qMin(d[i][j], d[i - 2][j - 2] + 1);
+            }
+        }
+
+        return d[s.length()][t.length()];
+    }
+
+    QString randomWord(int maximumLength)
+    {
+        QString word;
+        int length = qrand() % (maximumLength + 1);
+        for (int i = 0; i < length; ++i)
+        {
+            // A small alphabet with some characters beyond Latin-1
+            if (qrand() % 16 == 0)
+                word.append(QChar(0x430 + qrand() % 2));
+            else
+                word.append(QChar('a' + qrand() % 4));
+        }
+
+        return word;
+    }
+}
+
+EditDistanceTest::EditDistanceTest()
+{
+}
+
+EditDistanceTest::~EditDistanceTest()
+{
+}
+
+void EditDistanceTest::testDistance_data()
+{
+    QTest::addColumn<QString>("s");
+    QTest::addColumn<QString>("t");
+    QTest::addColumn<int>("distance");
+
+    QTest::newRow("equal") << "test" << "test" << 0;
+    QTest::newRow("substitution") << "test" << "tent" << 1;
+    QTest::newRow("insertion") << "test" << "tests" << 1;
+    QTest::newRow("transposition") << "the" << "teh" << 1;
+    QTest::newRow("empty") << "" << "abc" << 3;
+    QTest::newRow("no reuse after transposition") << "ca" << "abc" << 3;
+    QTest::newRow("unicode") << QString::fromUtf8("слово") << QString::fromUtf8("сlово") << 1;
+}
+
+void EditDistanceTest::testDistance()
+{
+    QFETCH(QString, s);
+    QFETCH(QString, t);
+    QFETCH(int, distance);
+
+    EditDistance editDistance;
+    QCOMPARE(editDistance.calEditDistance(s, t, 100), distance);
+    QCOMPARE(editDistance.calEditDistance(t, s, 100), distance);
+}
+
+void EditDistanceTest::testLimit()
+{
+    EditDistance editDistance;
+    for (int i = 0; i < 5000; ++i)
+    {
+        QString s = randomWord(20);
+        QString t = randomWord(20);
+        int limit = 1 + qrand() % 5;
+
+        // Only the distances below the limit are exact
+        int expected = referenceDistance(s, t);
+        int distance = editDistance.calEditDistance(s, t, limit);
+        if (expected < limit)
+            QCOMPARE(distance, expected);
+        else
+            QVERIFY(distance >= limit);
+    }
+}
+
+void EditDistanceTest::testBatch()
+{
+    const int count = 2 * EditDistance::batchSize + 3;
+    QString t[count];
+    int distances[count];
+
+    EditDistance editDistance;
+    for (int i = 0; i < 500; ++i)
+    {
+        QString s = randomWord(16);
+        for (int j = 0; j < count; ++j)
+            t[j] = randomWord(24);
+
+        editDistance.calEditDistances(s, t, count, 4, distances);
+        for (int j = 0; j < count; ++j)
+        {
+            int expected = referenceDistance(s, t[j]);
+            if (expected < 4)
+                QCOMPARE(distances[j], expected);
+            else
+                QVERIFY(distances[j] >= 4);
+        }
+    }
+}
+
+void EditDistanceTest::testLongWords()
+{
+    // Beyond the 64 characters of the bit-parallel kernel
+    EditDistance editDistance;
+    QString s = QString(70, 'a') + "bc" + QString(30, 'd');
+    QString t = QString(70, 'a') + "cb" + QString(29, 'd') + 'e';
+    QString u = 'x' + QString(100, 'y') + 'z';
+    QString v = 'z' + QString(100, 'y') + 'x';
+
+    QCOMPARE(editDistance.calEditDistance(s, t, 100), referenceDistance(s, t));
+    QCOMPARE(editDistance.calEditDistance(u, v, 100), referenceDistance(u, v));
+}
+
+QTEST_MAIN(EditDistanceTest)
+
+#include "editdistancetest.moc"
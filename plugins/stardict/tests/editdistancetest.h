@@ -0,0 +1,41 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_CORE_EDITDISTANCETEST_H
+#define MULA_CORE_EDITDISTANCETEST_H
+
+#include <QtCore/QObject>
+
+class EditDistanceTest : public QObject
+{
+        Q_OBJECT
+
+    public:
+        EditDistanceTest();
+        virtual ~EditDistanceTest();
+
+    private Q_SLOTS:
+        void testDistance_data();
+        void testDistance();
+        void testLimit();
+        void testBatch();
+        void testLongWords();
+};
+
+#endif // MULA_CORE_EDITDISTANCETEST_H
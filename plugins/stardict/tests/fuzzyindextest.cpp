@@ -0,0 +1,150 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "fuzzyindextest.h"
+
+#include <plugins/stardict/distance.h>
+#include <plugins/stardict/fuzzyindex.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    QStringList words()
+    {
+        return QStringList() << "apple" << "apply" << "ample" << "maple" << "banana"
+                             << "bandana" << "Apple" << "applet" << "pale" << "peal";
+    }
+
+    void build(FuzzyIndex *fuzzyIndex, const QStringList& words)
+    {
+        fuzzyIndex->beginBuild();
+        for (int i = 0; i < words.size(); ++i)
+            fuzzyIndex->addWord(words.at(i), i);
+
+        fuzzyIndex->endBuild();
+    }
+}
+
+FuzzyIndexTest::FuzzyIndexTest()
+{
+}
+
+FuzzyIndexTest::~FuzzyIndexTest()
+{
+}
+
+void FuzzyIndexTest::testLookup()
+{
+    FuzzyIndex fuzzyIndex;
+    QVERIFY(fuzzyIndex.isEmpty());
+
+    build(&fuzzyIndex, words());
+    QVERIFY(!fuzzyIndex.isEmpty());
+
+    // A transposition counts as one difference
+    QVector<FuzzyIndex::Match> matches = fuzzyIndex.lookup("APPEL", 3, 10);
+    QVERIFY(!matches.isEmpty());
+    QCOMPARE(matches.first().index, long(0));
+    QCOMPARE(matches.first().distance, 1);
+
+    // The headwords differing in case are both found
+    QCOMPARE(matches.at(1).index, long(6));
+    QCOMPARE(matches.at(1).distance, 1);
+
+    for (int i = 0; i < matches.size(); ++i)
+    {
+        QVERIFY(matches.at(i).index != 4);
+        QVERIFY(matches.at(i).distance < 3);
+
+        if (i > 0)
+            QVERIFY(matches.at(i - 1).distance <= matches.at(i).distance);
+    }
+
+    QVERIFY(fuzzyIndex.lookup("xyz", 3, 10).isEmpty());
+}
+
+void FuzzyIndexTest::testMaximumCount()
+{
+    FuzzyIndex fuzzyIndex;
+    build(&fuzzyIndex, words());
+
+    QVector<FuzzyIndex::Match> matches = fuzzyIndex.lookup("appel", 3, 1);
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches.first().index, long(0));
+
+    QVERIFY(fuzzyIndex.lookup("appel", 3, 0).isEmpty());
+}
+
+void FuzzyIndexTest::testCaseVariants()
+{
+    QStringList dictionaryWords;
+    dictionaryWords << "Polish" << "polish" << "polish" << "POLISH" << "polishes";
+
+    FuzzyIndex fuzzyIndex;
+    build(&fuzzyIndex, dictionaryWords);
+
+    // The repeated headword is added once
+    QVector<FuzzyIndex::Match> matches = fuzzyIndex.lookup("polsh", 3, 10);
+    QCOMPARE(matches.size(), 3);
+    QCOMPARE(matches.at(0).index, long(0));
+    QCOMPARE(matches.at(1).index, long(1));
+    QCOMPARE(matches.at(2).index, long(3));
+}
+
+void FuzzyIndexTest::testFullScan()
+{
+    QStringList dictionaryWords;
+    dictionaryWords << "abandon" << "ability" << "able" << "about" << "above" << "abroad"
+                    << "absence" << "absent" << "absolute" << "absorb" << "abuse" << "academic"
+                    << "accept" << "access" << "accident" << "account" << "accurate" << "accuse"
+                    << "achieve" << "acid" << "acquire" << "across" << "act" << "action"
+                    << "active" << "actor" << "actual" << "adapt" << "add" << "address";
+
+    FuzzyIndex fuzzyIndex;
+    build(&fuzzyIndex, dictionaryWords);
+
+    QStringList searchWords;
+    searchWords << "abut" << "acess" << "adress" << "actove" << "absnet" << "ac" << "abel";
+
+    // The tree finds the same headwords as measuring all of them
+    EditDistance editDistance;
+    foreach (const QString& searchWord, searchWords)
+    {
+        QSet<long> expected;
+        for (int i = 0; i < dictionaryWords.size(); ++i)
+        {
+            int distance = editDistance.calEditDistance(dictionaryWords.at(i), searchWord, 3);
+            if (distance < 3 && distance < searchWord.length())
+                expected.insert(i);
+        }
+
+        QSet<long> found;
+        foreach (const FuzzyIndex::Match& match, fuzzyIndex.lookup(searchWord, 3, dictionaryWords.size()))
+            found.insert(match.index);
+
+        QCOMPARE(found, expected);
+    }
+}
+
+QTEST_MAIN(FuzzyIndexTest)
+
+#include "fuzzyindextest.moc"
@@ -0,0 +1,376 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "indexcachetest.h"
+
+#include <plugins/stardict/indexcache.h>
+#include <plugins/stardict/file.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+IndexCacheTest::IndexCacheTest()
+{
+    // Keeps the fallback cache location away from the cache of the user
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+IndexCacheTest::~IndexCacheTest()
+{
+}
+
+static void appendBigEndian(QByteArray& data, quint64 value, int byteCount)
+{
+    for (int i = byteCount - 1; i >= 0; --i)
+        data.append(char(value >> (i * 8)));
+}
+
+// The words in the order StarDict sorts the index files, two apart, so that
+// every gap holds a missing word
+static QStringList testWords()
+{
+    QStringList words;
+    for (int i = 0; i < 100; ++i)
+        words.append(QString("b%1").arg(2 * i, 3, 10, QChar('0')));
+
+    return words;
+}
+
+static quint64 testDataOffset(int index, quint64 base)
+{
+    return base + quint64(index) * 1000;
+}
+
+static QByteArray indexData(const QStringList& words, int indexOffsetBits = 32, quint64 base = 0)
+{
+    QByteArray data;
+    for (int i = 0; i < words.size(); ++i)
+    {
+        data.append(words.at(i).toUtf8());
+        data.append('\0');
+        appendBigEndian(data, testDataOffset(i, base), indexOffsetBits / 8);
+        appendBigEndian(data, i + 1, 4);
+    }
+
+    return data;
+}
+
+static QByteArray synonymData(const QStringList& words)
+{
+    QByteArray data;
+    for (int i = 0; i < words.size(); ++i)
+    {
+        data.append(words.at(i).toUtf8());
+        data.append('\0');
+        appendBigEndian(data, words.size() - 1 - i, 4);
+    }
+
+    return data;
+}
+
+static bool writeFile(const QString& fileName, const QByteArray& data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+static void compareEntries(const IndexCache& indexCache, const QStringList& words, const QByteArray& data)
+{
+    QCOMPARE(indexCache.wordCount(), long(words.size()));
+
+    for (int i = 0; i < words.size(); ++i)
+    {
+        QByteArray word = words.at(i).toUtf8();
+        QCOMPARE(data.mid(int(indexCache.keyOffset(i)), indexCache.keyLength(i)), word);
+        QCOMPARE(indexCache.collationKey(i), stardictCollationKey(word));
+        QCOMPARE(indexCache.lookup(word), i);
+    }
+}
+
+void IndexCacheTest::testBuild()
+{
+    QStringList words = testWords();
+    QByteArray data = indexData(words);
+
+    IndexCache indexCache;
+    indexCache.setPageEntryNumber(8);
+    indexCache.build(data.constData(), data.size());
+
+    compareEntries(indexCache, words, data);
+    QCOMPARE(indexCache.pageCount(), 13L);
+
+    for (int i = 0; i < words.size(); ++i)
+    {
+        QCOMPARE(indexCache.dataOffset(i), testDataOffset(i, 0));
+        QCOMPARE(indexCache.dataSize(i), quint32(i + 1));
+    }
+}
+
+void IndexCacheTest::testPageDirectory()
+{
+    // The separators have to tell apart the words differing in the case only
+    // or in their last letter, and the ones sharing a long prefix
+    QStringList words;
+    words << "Apple" << "apple" << "applet" << "Applets" << "b" << "ba" << "baa" << "bab"
+          << "prefix_prefix_prefix_1" << "prefix_prefix_prefix_2" << QString::fromUtf8("Äpfel")
+          << QString::fromUtf8("äpfel") << QString::fromUtf8("слово");
+
+    QByteArray data = indexData(words);
+
+    for (int pageEntryNumber = 1; pageEntryNumber <= 4; ++pageEntryNumber)
+    {
+        IndexCache indexCache;
+        indexCache.setPageEntryNumber(pageEntryNumber);
+        indexCache.build(data.constData(), data.size());
+
+        QCOMPARE(indexCache.pageCount(), long((words.size() - 1) / pageEntryNumber + 1));
+        compareEntries(indexCache, words, data);
+
+        int nextIndex;
+        QCOMPARE(indexCache.lookup("APPLE", &nextIndex), -1);
+        QCOMPARE(nextIndex, 0);
+        QCOMPARE(indexCache.lookup("apples", &nextIndex), -1);
+        QCOMPARE(nextIndex, 2);
+        QCOMPARE(indexCache.lookup("prefix_prefix_prefix_0", &nextIndex), -1);
+        QCOMPARE(nextIndex, 8);
+    }
+}
+
+void IndexCacheTest::testLookup_data()
+{
+    QTest::addColumn<QString>("word");
+    QTest::addColumn<int>("index");
+    QTest::addColumn<int>("nextIndex");
+
+    QTest::newRow("first") << "b000" << 0 << 0;
+    QTest::newRow("last on a page") << "b014" << 7 << 7;
+    QTest::newRow("first on a page") << "b016" << 8 << 8;
+    QTest::newRow("last") << "b198" << 99 << 99;
+    QTest::newRow("empty") << "" << -1 << 0;
+    QTest::newRow("before the first page") << "a" << -1 << 0;
+    QTest::newRow("on a page") << "b001" << -1 << 1;
+    QTest::newRow("between pages") << "b015" << -1 << 8;
+    QTest::newRow("case") << "B016" << -1 << 8;
+    QTest::newRow("longer") << "b0160" << -1 << 9;
+    QTest::newRow("after the last page") << "b199" << -1 << 100;
+    QTest::newRow("after the last word") << "c" << -1 << 100;
+}
+
+void IndexCacheTest::testLookup()
+{
+    QFETCH(QString, word);
+    QFETCH(int, index);
+    QFETCH(int, nextIndex);
+
+    QByteArray data = indexData(testWords());
+
+    IndexCache indexCache;
+    indexCache.setPageEntryNumber(8);
+    indexCache.build(data.constData(), data.size());
+
+    int resultNextIndex = -1;
+    QCOMPARE(indexCache.lookup(word.toUtf8(), &resultNextIndex), index);
+    QCOMPARE(resultNextIndex, nextIndex);
+}
+
+void IndexCacheTest::testAddEntries()
+{
+    QStringList words = testWords();
+    QByteArray data = indexData(words);
+
+    // The data arrives in pieces splitting the word entries anywhere
+    IndexCache indexCache;
+    indexCache.setPageEntryNumber(8);
+    indexCache.beginBuild();
+
+    qint64 position = 0;
+    for (int size = 5; size < data.size(); size += 5)
+    {
+        position = indexCache.addEntries(data.constData(), position, size);
+        QVERIFY(position <= size);
+    }
+
+    QCOMPARE(indexCache.addEntries(data.constData(), position, data.size()), qint64(data.size()));
+    indexCache.endBuild(data.size());
+
+    compareEntries(indexCache, words, data);
+    QCOMPARE(indexCache.pageCount(), 13L);
+
+    for (int i = 0; i < words.size(); ++i)
+    {
+        QCOMPARE(indexCache.dataOffset(i), testDataOffset(i, 0));
+        QCOMPARE(indexCache.dataSize(i), quint32(i + 1));
+    }
+}
+
+void IndexCacheTest::testWideDataOffsets()
+{
+    // The ".dict" file is larger than 4 GB
+    QStringList words = testWords();
+    quint64 base = quint64(5) << 32;
+    QByteArray data = indexData(words, 64, base);
+
+    IndexCache indexCache;
+    indexCache.setIndexOffsetBits(64);
+    indexCache.build(data.constData(), data.size());
+
+    compareEntries(indexCache, words, data);
+
+    for (int i = 0; i < words.size(); ++i)
+    {
+        QCOMPARE(indexCache.dataOffset(i), testDataOffset(i, base));
+        QCOMPARE(indexCache.dataSize(i), quint32(i + 1));
+    }
+}
+
+void IndexCacheTest::testSynonymFile()
+{
+    QStringList words = testWords();
+    QByteArray data = synonymData(words);
+
+    IndexCache indexCache;
+    indexCache.setSynonymFile(true);
+    indexCache.build(data.constData(), data.size());
+
+    compareEntries(indexCache, words, data);
+
+    for (int i = 0; i < words.size(); ++i)
+    {
+        QCOMPARE(indexCache.dataOffset(i), quint64(words.size() - 1 - i));
+        QCOMPARE(indexCache.dataSize(i), quint32(0));
+    }
+}
+
+void IndexCacheTest::testSaveLoad_data()
+{
+    QTest::addColumn<int>("indexOffsetBits");
+    QTest::addColumn<quint64>("base");
+
+    QTest::newRow("32-bits offsets") << 32 << quint64(0);
+    QTest::newRow("64-bits offsets") << 64 << (quint64(5) << 32);
+}
+
+void IndexCacheTest::testSaveLoad()
+{
+    QFETCH(int, indexOffsetBits);
+    QFETCH(quint64, base);
+
+    QTemporaryDir temporaryDir;
+    QVERIFY(temporaryDir.isValid());
+
+    QStringList words = testWords();
+    QByteArray data = indexData(words, indexOffsetBits, base);
+    QString indexFilePath = temporaryDir.path() + "/test.idx";
+    QVERIFY(writeFile(indexFilePath, data));
+
+    IndexCache builtCache;
+    builtCache.setPageEntryNumber(8);
+    builtCache.setIndexOffsetBits(indexOffsetBits);
+    builtCache.build(data.constData(), data.size());
+    QVERIFY(builtCache.save(indexFilePath));
+    QVERIFY(QFile::exists(indexFilePath + ".oft"));
+
+    IndexCache loadedCache;
+    loadedCache.setPageEntryNumber(8);
+    loadedCache.setIndexOffsetBits(indexOffsetBits);
+    QVERIFY(loadedCache.load(indexFilePath));
+
+    compareEntries(loadedCache, words, data);
+    QCOMPARE(loadedCache.pageCount(), builtCache.pageCount());
+
+    for (int i = 0; i < words.size(); ++i)
+    {
+        QCOMPARE(loadedCache.dataOffset(i), testDataOffset(i, base));
+        QCOMPARE(loadedCache.dataSize(i), quint32(i + 1));
+    }
+
+    int nextIndex;
+    QCOMPARE(loadedCache.lookup("b015", &nextIndex), -1);
+    QCOMPARE(nextIndex, 8);
+
+    // The cache files built with other settings are outdated
+    IndexCache otherPageCache;
+    otherPageCache.setPageEntryNumber(16);
+    otherPageCache.setIndexOffsetBits(indexOffsetBits);
+    QVERIFY(!otherPageCache.load(indexFilePath));
+
+    IndexCache synonymCache;
+    synonymCache.setPageEntryNumber(8);
+    synonymCache.setIndexOffsetBits(indexOffsetBits);
+    synonymCache.setSynonymFile(true);
+    QVERIFY(!synonymCache.load(indexFilePath));
+}
+
+void IndexCacheTest::testOutdatedCache()
+{
+    QTemporaryDir temporaryDir;
+    QVERIFY(temporaryDir.isValid());
+
+    QByteArray data = indexData(testWords());
+    QString indexFilePath = temporaryDir.path() + "/test.idx";
+    QVERIFY(writeFile(indexFilePath, data));
+
+    IndexCache indexCache;
+    QVERIFY(!indexCache.load(indexFilePath));
+
+    indexCache.build(data.constData(), data.size());
+    QVERIFY(indexCache.save(indexFilePath));
+    QVERIFY(indexCache.load(indexFilePath));
+
+    // The index file has changed since the cache was saved
+    data.append(indexData(QStringList() << "c"));
+    QVERIFY(writeFile(indexFilePath, data));
+    QVERIFY(!indexCache.load(indexFilePath));
+    QCOMPARE(indexCache.wordCount(), 0L);
+}
+
+void IndexCacheTest::testTruncatedCache()
+{
+    QTemporaryDir temporaryDir;
+    QVERIFY(temporaryDir.isValid());
+
+    QByteArray data = indexData(testWords());
+    QString indexFilePath = temporaryDir.path() + "/test.idx";
+    QVERIFY(writeFile(indexFilePath, data));
+
+    IndexCache indexCache;
+    indexCache.build(data.constData(), data.size());
+    QVERIFY(indexCache.save(indexFilePath));
+
+    QFile cacheFile(indexFilePath + ".oft");
+    qint64 cacheFileSize = cacheFile.size();
+
+    QVERIFY(cacheFile.resize(cacheFileSize - 1));
+    QVERIFY(!indexCache.load(indexFilePath));
+
+    // Shorter than the header
+    QVERIFY(cacheFile.resize(16));
+    QVERIFY(!indexCache.load(indexFilePath));
+
+    QVERIFY(cacheFile.resize(0));
+    QVERIFY(!indexCache.load(indexFilePath));
+}
+
+QTEST_MAIN(IndexCacheTest)
+
+#include "indexcachetest.moc"
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "matchheaptest.h"
+
+#include <plugins/stardict/matchheap.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+MatchHeapTest::MatchHeapTest()
+{
+}
+
+MatchHeapTest::~MatchHeapTest()
+{
+}
+
+void MatchHeapTest::testInsert()
+{
+    MatchHeap matchHeap(10, 3);
+    QVERIFY(matchHeap.insert(5, 2));
+    QVERIFY(matchHeap.insert(3, 1));
+    QVERIFY(matchHeap.insert(1, 2));
+    QVERIFY(!matchHeap.insert(7, 3));
+    QCOMPARE(matchHeap.count(), 3);
+
+    QVector<FuzzyIndex::Match> matches = matchHeap.matches();
+    QCOMPARE(matches.size(), 3);
+    QCOMPARE(matches.at(0).index, long(3));
+    QCOMPARE(matches.at(0).distance, 1);
+    QCOMPARE(matches.at(1).index, long(1));
+    QCOMPARE(matches.at(2).index, long(5));
+}
+
+void MatchHeapTest::testLimit()
+{
+    MatchHeap matchHeap(2, 3);
+    QCOMPARE(matchHeap.limit(), 3);
+
+    QVERIFY(matchHeap.insert(0, 2));
+    QCOMPARE(matchHeap.limit(), 3);
+
+    // The heap is full, only the closer matches are accepted from now on
+    QVERIFY(matchHeap.insert(1, 2));
+    QCOMPARE(matchHeap.limit(), 2);
+    QVERIFY(!matchHeap.insert(2, 2));
+
+    QVERIFY(matchHeap.insert(3, 1));
+    QCOMPARE(matchHeap.limit(), 2);
+    QVERIFY(matchHeap.insert(4, 0));
+    QCOMPARE(matchHeap.limit(), 1);
+
+    QVector<FuzzyIndex::Match> matches = matchHeap.matches();
+    QCOMPARE(matches.size(), 2);
+    QCOMPARE(matches.at(0).index, long(4));
+    QCOMPARE(matches.at(1).index, long(3));
+}
+
+void MatchHeapTest::testDuplicates()
+{
+    MatchHeap matchHeap(2, 3);
+    QVERIFY(matchHeap.insert(0, 2, "apple"));
+    QVERIFY(!matchHeap.insert(1, 1, "apple"));
+    QVERIFY(matchHeap.insert(2, 2, "apply"));
+
+    // The evicted word may come back
+    QVERIFY(matchHeap.insert(3, 1, "ample"));
+    QVERIFY(matchHeap.insert(4, 0, "apply"));
+
+    QVector<FuzzyIndex::Match> matches = matchHeap.matches();
+    QCOMPARE(matches.size(), 2);
+    QCOMPARE(matches.at(0).index, long(4));
+    QCOMPARE(matches.at(1).index, long(3));
+}
+
+void MatchHeapTest::testMaximumCount()
+{
+    MatchHeap emptyHeap(0, 3);
+    QVERIFY(!emptyHeap.insert(0, 0));
+    QVERIFY(emptyHeap.matches().isEmpty());
+
+    MatchHeap matchHeap(3, 10);
+    for (int i = 0; i < 100; ++i)
+        matchHeap.insert(i, (i * 7) % 10);
+
+    QVector<FuzzyIndex::Match> matches = matchHeap.matches();
+    QCOMPARE(matches.size(), 3);
+    QCOMPARE(matches.at(0).index, long(0));
+    QCOMPARE(matches.at(1).index, long(10));
+    QCOMPARE(matches.at(2).index, long(20));
+}
+
+QTEST_MAIN(MatchHeapTest)
+
+#include "matchheaptest.moc"
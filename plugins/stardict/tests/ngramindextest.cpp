@@ -0,0 +1,148 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ngramindextest.h"
+
+#include <plugins/stardict/abstractindexfile.h>
+#include <plugins/stardict/ngramindex.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    // Serves the words from memory, the index only reads the keys
+    class TestIndexFile : public AbstractIndexFile
+    {
+        public:
+            TestIndexFile(const QList<QByteArray>& words)
+                : m_words(words)
+            {
+            }
+
+            bool load(const QString&) { return true; }
+            long wordCount() const { return m_words.size(); }
+            QByteArray key(long index) { return m_words.at(index); }
+            QByteArray keyData(long index) { return m_words.at(index); }
+            QByteArray collationKey(long index) { return m_words.at(index); }
+            int lookup(const QByteArray& word, int *) { return m_words.indexOf(word); }
+            quint64 dataOffset(long) const { return 0; }
+            quint32 dataSize(long) const { return 0; }
+
+        private:
+            QList<QByteArray> m_words;
+    };
+
+    QList<QByteArray> words()
+    {
+        return QList<QByteArray>() << "abc" << "abcd" << "bcde" << "cabc" << "xyz"
+                                   << "xabcx" << "zabc" << "zz";
+    }
+
+    QVector<quint32> indexes(const QList<quint32>& list)
+    {
+        return list.toVector();
+    }
+}
+
+void NgramIndexTest::testCandidates_data()
+{
+    QTest::addColumn<QList<QByteArray> >("literals");
+    QTest::addColumn<int>("first");
+    QTest::addColumn<int>("last");
+    QTest::addColumn<QVector<quint32> >("expected");
+
+    QList<QByteArray> abc = QList<QByteArray>() << "abc";
+
+    QTest::newRow("whole range") << abc << 0 << 8 << indexes(QList<quint32>() << 0 << 1 << 3 << 5 << 6);
+    QTest::newRow("first bound") << abc << 1 << 8 << indexes(QList<quint32>() << 1 << 3 << 5 << 6);
+    QTest::newRow("last bound is exclusive") << abc << 0 << 6 << indexes(QList<quint32>() << 0 << 1 << 3 << 5);
+    QTest::newRow("inner range") << abc << 2 << 5 << indexes(QList<quint32>() << 3);
+    QTest::newRow("no match in range") << abc << 7 << 8 << QVector<quint32>();
+    QTest::newRow("other trigram") << (QList<QByteArray>() << "bcd") << 0 << 8 << indexes(QList<quint32>() << 1 << 2);
+    QTest::newRow("two trigrams") << (QList<QByteArray>() << "abcd") << 0 << 8 << indexes(QList<quint32>() << 1);
+    QTest::newRow("two literals") << (QList<QByteArray>() << "abc" << "x") << 0 << 8 << indexes(QList<quint32>() << 0 << 1 << 3 << 5 << 6);
+    QTest::newRow("intersection") << (QList<QByteArray>() << "abc" << "bcd") << 0 << 8 << indexes(QList<quint32>() << 1);
+    QTest::newRow("missing trigram") << (QList<QByteArray>() << "qqq") << 0 << 8 << QVector<quint32>();
+}
+
+void NgramIndexTest::testCandidates()
+{
+    QFETCH(QList<QByteArray>, literals);
+    QFETCH(int, first);
+    QFETCH(int, last);
+    QFETCH(QVector<quint32>, expected);
+
+    TestIndexFile indexFile(words());
+    NgramIndex ngramIndex;
+    QVERIFY(ngramIndex.build(&indexFile, indexFile.wordCount()));
+
+    QVector<quint32> candidates;
+    QVERIFY(ngramIndex.candidates(literals, first, last, &candidates));
+    QCOMPARE(candidates, expected);
+}
+
+void NgramIndexTest::testEmptyRange()
+{
+    TestIndexFile indexFile(words());
+    NgramIndex ngramIndex;
+    QVERIFY(ngramIndex.build(&indexFile, indexFile.wordCount()));
+
+    QVector<quint32> candidates;
+    QVERIFY(ngramIndex.candidates(QList<QByteArray>() << "abc", 3, 3, &candidates));
+    QVERIFY(candidates.isEmpty());
+
+    QVERIFY(ngramIndex.candidates(QList<QByteArray>() << "abc", 5, 2, &candidates));
+    QVERIFY(candidates.isEmpty());
+}
+
+void NgramIndexTest::testShortLiterals()
+{
+    TestIndexFile indexFile(words());
+    NgramIndex ngramIndex;
+    QVERIFY(ngramIndex.build(&indexFile, indexFile.wordCount()));
+
+    // The literals shorter than a trigram cannot filter the word entries
+    QVector<quint32> candidates;
+    QVERIFY(!ngramIndex.candidates(QList<QByteArray>() << "ab" << "x", 0, 8, &candidates));
+    QVERIFY(!ngramIndex.candidates(QList<QByteArray>(), 0, 8, &candidates));
+}
+
+void NgramIndexTest::testMaximumSize()
+{
+    TestIndexFile indexFile(words());
+    NgramIndex ngramIndex;
+    QVERIFY(ngramIndex.build(&indexFile, indexFile.wordCount()));
+    QVERIFY(ngramIndex.size() > 0);
+
+    // The index is left empty if it does not fit, and the lookups have to
+    // check every word entry instead
+    ngramIndex.setMaximumSize(ngramIndex.size() - 1);
+    QVERIFY(!ngramIndex.build(&indexFile, indexFile.wordCount()));
+    QCOMPARE(ngramIndex.size(), qint64(0));
+
+    QVector<quint32> candidates;
+    QVERIFY(!ngramIndex.candidates(QList<QByteArray>() << "abc", 0, 8, &candidates));
+    QVERIFY(candidates.isEmpty());
+}
+
+QTEST_MAIN(NgramIndexTest)
+
+#include "ngramindextest.moc"
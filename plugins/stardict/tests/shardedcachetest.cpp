@@ -0,0 +1,149 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "shardedcachetest.h"
+
+#include <plugins/stardict/shardedcache.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    // Opens up the interface that ChunkCache and ArticleCache wrap
+    class TestCache : public ShardedCache
+    {
+        public:
+            TestCache()
+                : ShardedCache(1024 * 1024, 0)
+            {
+            }
+
+            using ShardedCache::newOwnerId;
+            using ShardedCache::object;
+            using ShardedCache::insert;
+    };
+}
+
+ShardedCacheTest::ShardedCacheTest()
+{
+}
+
+ShardedCacheTest::~ShardedCacheTest()
+{
+}
+
+void ShardedCacheTest::testInsert()
+{
+    TestCache cache;
+    quint32 ownerId = cache.newOwnerId();
+    QByteArray object(100, 'a');
+
+    QVERIFY(cache.object(ownerId, 0).isNull());
+    cache.insert(ownerId, 0, object);
+    QCOMPARE(cache.object(ownerId, 0), object);
+    QVERIFY(cache.object(ownerId, 1).isNull());
+
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.size(), qint64(object.size()));
+    QCOMPARE(cache.hitCount(), quint64(1));
+    QCOMPARE(cache.missCount(), quint64(2));
+}
+
+void ShardedCacheTest::testOwnerIds()
+{
+    TestCache cache;
+    quint32 ownerId1 = cache.newOwnerId();
+    quint32 ownerId2 = cache.newOwnerId();
+    QVERIFY(ownerId1 != ownerId2);
+
+    cache.insert(ownerId1, 0, QByteArray("first"));
+    cache.insert(ownerId2, 0, QByteArray("second"));
+    QCOMPARE(cache.object(ownerId1, 0), QByteArray("first"));
+    QCOMPARE(cache.object(ownerId2, 0), QByteArray("second"));
+}
+
+void ShardedCacheTest::testRemove()
+{
+    TestCache cache;
+    quint32 ownerId1 = cache.newOwnerId();
+    quint32 ownerId2 = cache.newOwnerId();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        cache.insert(ownerId1, i, QByteArray(10, 'a'));
+        cache.insert(ownerId2, i, QByteArray(10, 'b'));
+    }
+
+    cache.remove(ownerId1);
+    QCOMPARE(cache.count(), 10);
+    QCOMPARE(cache.size(), qint64(100));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        QVERIFY(cache.object(ownerId1, i).isNull());
+        QCOMPARE(cache.object(ownerId2, i), QByteArray(10, 'b'));
+    }
+}
+
+void ShardedCacheTest::testMaximumSize()
+{
+    TestCache cache;
+    cache.setMaximumSize(64 * 1024);
+    QCOMPARE(cache.maximumSize(), qint64(64 * 1024));
+
+    quint32 ownerId = cache.newOwnerId();
+    QByteArray object(1024, 'a');
+    for (int i = 0; i < 1000; ++i)
+        cache.insert(ownerId, i, object);
+
+    QVERIFY(cache.size() <= cache.maximumSize());
+    QVERIFY(cache.count() < 1000);
+
+    // The evicted entries are still usable by the callers keeping them
+    QByteArray keptObject = cache.object(ownerId, 999);
+    QVERIFY(!keptObject.isNull());
+    cache.remove(ownerId);
+    QCOMPARE(keptObject, object);
+
+    cache.setMaximumSize(0);
+    QCOMPARE(cache.maximumSize(), qint64(1024 * 1024));
+}
+
+void ShardedCacheTest::testLeastRecentlyUsed()
+{
+    TestCache cache;
+    cache.setMaximumSize(256 * 1024);
+
+    quint32 ownerId = cache.newOwnerId();
+    QByteArray object(1024, 'a');
+    cache.insert(ownerId, 0, object);
+
+    // The frequently read entry survives a stream of one-off entries
+    for (int i = 1; i < 10000; ++i)
+    {
+        cache.insert(ownerId, i, object);
+        QVERIFY(!cache.object(ownerId, 0).isNull());
+    }
+}
+
+QTEST_MAIN(ShardedCacheTest)
+
+#include "shardedcachetest.moc"
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "wildcardpatterntest.h"
+
+#include <plugins/stardict/wildcardpattern.h>
+
+#include <QtTest/QtTest>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    QString randomText(int maximumLength, bool wildcards)
+    {
+        QString text;
+        int length = qrand() % (maximumLength + 1);
+        for (int i = 0; i < length; ++i)
+        {
+            int character = qrand() % (wildcards ? 8 : 6);
+            switch (character)
+            {
+            case 0:
+                text.append(QChar(0xe9));
+                break;
+            case 1:
+                text.append(QChar(0x4e2d));
+                break;
+            case 6:
+                text.append('*');
+                break;
+            case 7:
+                text.append('?');
+                break;
+            default:
+                text.append(QChar('a' + character - 2));
+            }
+        }
+
+        return text;
+    }
+}
+
+WildcardPatternTest::WildcardPatternTest()
+{
+}
+
+WildcardPatternTest::~WildcardPatternTest()
+{
+}
+
+void WildcardPatternTest::testExactMatch_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QString>("word");
+    QTest::addColumn<bool>("match");
+
+    QTest::newRow("literal") << "inter" << "inter" << true;
+    QTest::newRow("literal mismatch") << "inter" << "intern" << false;
+    QTest::newRow("case") << "inter" << "Inter" << false;
+    QTest::newRow("prefix") << "inter*" << "international" << true;
+    QTest::newRow("prefix empty rest") << "inter*" << "inter" << true;
+    QTest::newRow("suffix") << "*tion" << "nation" << true;
+    QTest::newRow("suffix mismatch") << "*tion" << "nations" << false;
+    QTest::newRow("infix") << "*ter*" << "international" << true;
+    QTest::newRow("question mark") << "c?t" << "cat" << true;
+    QTest::newRow("question mark empty") << "c?t" << "ct" << false;
+    QTest::newRow("question mark multibyte") << "caf?" << QString::fromUtf8("caf\xc3\xa9") << true;
+    QTest::newRow("question mark cjk") << "?" << QString::fromUtf8("\xe4\xb8\xad") << true;
+    QTest::newRow("question mark two bytes") << "caf?" << QString::fromUtf8("caf\xc3\xa9s") << false;
+    QTest::newRow("multibyte literal") << QString::fromUtf8("*\xc3\xa9*") << QString::fromUtf8("r\xc3\xa9sum\xc3\xa9") << true;
+    QTest::newRow("stars") << "a**b" << "ab" << true;
+    QTest::newRow("star only") << "*" << "" << true;
+    QTest::newRow("empty") << "" << "" << true;
+    QTest::newRow("empty mismatch") << "" << "a" << false;
+}
+
+void WildcardPatternTest::testExactMatch()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QString, word);
+    QFETCH(bool, match);
+
+    WildcardPattern wildcardPattern(pattern);
+    QVERIFY(wildcardPattern.isValid());
+    QCOMPARE(wildcardPattern.exactMatch(word.toUtf8()), match);
+}
+
+void WildcardPatternTest::testLiterals()
+{
+    WildcardPattern wildcardPattern("inter*na?al");
+    QCOMPARE(wildcardPattern.literalPrefix(), QByteArray("inter"));
+    QCOMPARE(wildcardPattern.literals(), QList<QByteArray>() << "inter" << "na" << "al");
+
+    WildcardPattern suffixPattern("*tion");
+    QVERIFY(suffixPattern.literalPrefix().isEmpty());
+    QCOMPARE(suffixPattern.literals(), QList<QByteArray>() << "tion");
+}
+
+void WildcardPatternTest::testInvalid()
+{
+    // The character sets are left to QRegExp
+    WildcardPattern setPattern("c[au]t");
+    QVERIFY(!setPattern.isValid());
+    QVERIFY(!setPattern.exactMatch(QByteArray("cat")));
+
+    WildcardPattern longPattern(QString(64, 'a'));
+    QVERIFY(!longPattern.isValid());
+
+    WildcardPattern maximumPattern(QString(63, 'a'));
+    QVERIFY(maximumPattern.isValid());
+    QVERIFY(maximumPattern.exactMatch(QByteArray(63, 'a')));
+}
+
+void WildcardPatternTest::testRandomPatterns()
+{
+    qsrand(1);
+    for (int i = 0; i < 2000; ++i)
+    {
+        QString pattern = randomText(6, true);
+        QString word = randomText(8, false);
+
+        QRegExp rx(pattern);
+        rx.setPatternSyntax(QRegExp::Wildcard);
+
+        WildcardPattern wildcardPattern(pattern);
+        QVERIFY(wildcardPattern.isValid());
+        QCOMPARE(wildcardPattern.exactMatch(word.toUtf8()), rx.exactMatch(word));
+    }
+}
+
+QTEST_MAIN(WildcardPatternTest)
+
+#include "wildcardpatterntest.moc"
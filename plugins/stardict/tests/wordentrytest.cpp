@@ -45,7 +45,7 @@ void WordEntryTest::testData()
 void WordEntryTest::testDataOffset()
 {
     WordEntry wordEntry;
-    quint32 dataOffset = 100;
+    quint64 dataOffset = 100;
     wordEntry.setDataOffset(dataOffset);
     QCOMPARE(wordEntry.dataOffset(), dataOffset);
 }
@@ -58,6 +58,14 @@ void WordEntryTest::testDataSize()
     QCOMPARE(wordEntry.dataSize(), dataSize);
 }
 
+void WordEntryTest::testCollationKey()
+{
+    WordEntry wordEntry;
+    QByteArray collationKey = QByteArray("key\0Key", 7);
+    wordEntry.setCollationKey(collationKey);
+    QCOMPARE(wordEntry.collationKey(), collationKey);
+}
+
 QTEST_MAIN(WordEntryTest)
 
 #include "wordentrytest.moc"
@@ -34,6 +34,7 @@ class WordEntryTest : public QObject
         void testData();
         void testDataOffset();
         void testDataSize();
+        void testCollationKey();
 };
 
 #endif // MULA_CORE_WORDENTRYTEST_H
@@ -0,0 +1,720 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "abstractdatafile.h"
+#include "dictionary.h"
+#include "dictionaryzip.h"
+#include "gzipdatafile.h"
+#include "wordentry.h"
+
+#ifdef HAVE_ZSTD
+#include "zstddatafile.h"
+#endif
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    // The compressed size of a dictzip chunk is stored in 16 bits, and
+    // deflate may expand incompressible data slightly, hence the same margin
+    // as the one of dictzip
+    const int maximumDictzipChunkLength = 58315;
+
+    // The extra field of the gzip header is limited to 65535 bytes, of which
+    // the random access subfield takes 10 bytes and 2 bytes per chunk
+    const int maximumDictzipChunkCount = (65535 - 10) / 2;
+
+    const int defaultChunkSize = 32 * 1024;
+    const int defaultDeflateLevel = 9;
+    const int defaultZstdLevel = 19;
+
+    // The source is read in pieces of at most that many bytes
+    const int readSize = 1024 * 1024;
+
+    enum OutputFormat
+    {
+        DictzipFormat,
+        GzipFormat,
+        ZstdFormat
+    };
+
+    struct Article
+    {
+        quint64 offset;
+        quint32 size;
+
+        bool operator<(const Article& other) const
+        {
+            return offset < other.offset || (offset == other.offset && size < other.size);
+        }
+    };
+
+    struct LayoutStatistics
+    {
+        int chunkCount;
+        double averageChunkSize;
+        double chunksPerLookup;
+        double singleChunkRatio;
+        double bytesPerLookup;
+    };
+
+    QTextStream& standardOutput()
+    {
+        static QTextStream stream(stdout);
+        return stream;
+    }
+
+    QTextStream& standardError()
+    {
+        static QTextStream stream(stderr);
+        return stream;
+    }
+
+    // The highest compression level of the output format
+    int maximumLevel(OutputFormat format)
+    {
+#ifdef HAVE_ZSTD
+        if (format == ZstdFormat)
+            return ZSTD_maxCLevel();
+#else
+        Q_UNUSED(format);
+#endif
+
+        return Z_BEST_COMPRESSION;
+    }
+
+    void printUsage()
+    {
+        standardError() << "Usage: mula-stardict-recompress [--chunk-size <bytes>] [--level <level>] <file.ifo> <output>\n"
+                        << "\n"
+                        << "Rewrites the data file of the StarDict dictionary. The format is chosen by the\n"
+                        << "extension of the output file:\n"
+                        << "  .dict.dz   dictzip with a fixed chunk length of about the chunk size\n"
+                        << "  .dict.gz   gzip flushed at the article boundaries, with a \".gzidx\" chunk index\n"
+#ifdef HAVE_ZSTD
+                        << "  .dict.zst  zstd seekable with one frame per article aligned chunk\n"
+#endif
+                        << "\n"
+                        << "The level is 0 to " << maximumLevel(GzipFormat) << " for dictzip and gzip, "
+                        << defaultDeflateLevel << " by default.\n"
+#ifdef HAVE_ZSTD
+                        << "The level is 1 to " << maximumLevel(ZstdFormat) << " for zstd, "
+                        << defaultZstdLevel << " by default.\n"
+#endif
+                        << "The default chunk size is " << defaultChunkSize << " bytes.\n";
+        standardError().flush();
+    }
+
+    // The articles of the dictionary in the order of the data file
+    QVector<Article> dictionaryArticles(Dictionary& dictionary)
+    {
+        QVector<Article> articles;
+        articles.reserve(dictionary.articleCount());
+
+        for (int i = 0; i < dictionary.articleCount(); ++i)
+        {
+            WordEntry wordEntry = dictionary.wordEntry(i);
+            Article article;
+            article.offset = wordEntry.dataOffset();
+            article.size = wordEntry.dataSize();
+            articles.append(article);
+        }
+
+        std::sort(articles.begin(), articles.end());
+        return articles;
+    }
+
+    // The chunk starts of the file followed by its size, or an empty list if
+    // the file is not chunked
+    QVector<quint64> dataFileChunkStarts(const AbstractDataFile *dataFile)
+    {
+        QVector<quint64> chunkStarts;
+
+        int chunkCount = dataFile->chunkCount();
+        if (chunkCount == 0)
+            return chunkStarts;
+
+        chunkStarts.reserve(chunkCount + 1);
+        for (int i = 0; i <= chunkCount; ++i)
+            chunkStarts.append(dataFile->chunkStart(i));
+
+        return chunkStarts;
+    }
+
+    // Cuts the data at the first article starting after every chunkSize
+    // bytes, so no article is split unless it overlaps another one
+    QVector<quint64> alignedChunkStarts(const QVector<Article>& articles, quint64 dataSize, int chunkSize)
+    {
+        QVector<quint64> chunkStarts;
+        chunkStarts.append(0);
+
+        quint64 coveredEnd = 0;
+        foreach (const Article& article, articles)
+        {
+            if (article.offset >= coveredEnd && article.offset - chunkStarts.last() >= quint64(chunkSize)
+                    && article.offset < dataSize)
+            {
+                chunkStarts.append(article.offset);
+            }
+
+            coveredEnd = qMax(coveredEnd, article.offset + article.size);
+        }
+
+        chunkStarts.append(dataSize);
+        return chunkStarts;
+    }
+
+    QVector<quint64> fixedChunkStarts(quint64 dataSize, int chunkLength)
+    {
+        QVector<quint64> chunkStarts;
+        for (quint64 start = 0; start < dataSize; start += chunkLength)
+            chunkStarts.append(start);
+
+        chunkStarts.append(dataSize);
+        return chunkStarts;
+    }
+
+    LayoutStatistics layoutStatistics(const QVector<quint64>& chunkStarts, const QVector<Article>& articles)
+    {
+        LayoutStatistics statistics;
+        statistics.chunkCount = chunkStarts.size() - 1;
+        statistics.averageChunkSize = double(chunkStarts.last()) / statistics.chunkCount;
+
+        quint64 chunkTotal = 0;
+        quint64 byteTotal = 0;
+        int singleChunkCount = 0;
+        int lookupCount = 0;
+
+        QVector<quint64>::const_iterator chunkEnd = chunkStarts.constEnd() - 1;
+        foreach (const Article& article, articles)
+        {
+            if (article.size == 0 || article.offset + article.size > chunkStarts.last())
+                continue;
+
+            int firstChunk = std::upper_bound(chunkStarts.constBegin(), chunkEnd, article.offset) - chunkStarts.constBegin() - 1;
+            int lastChunk = std::upper_bound(chunkStarts.constBegin(), chunkEnd, article.offset + article.size - 1) - chunkStarts.constBegin() - 1;
+
+            chunkTotal += lastChunk - firstChunk + 1;
+            byteTotal += chunkStarts.at(lastChunk + 1) - chunkStarts.at(firstChunk);
+            if (firstChunk == lastChunk)
+                ++singleChunkCount;
+
+            ++lookupCount;
+        }
+
+        lookupCount = qMax(lookupCount, 1);
+        statistics.chunksPerLookup = double(chunkTotal) / lookupCount;
+        statistics.singleChunkRatio = 100.0 * singleChunkCount / lookupCount;
+        statistics.bytesPerLookup = double(byteTotal) / lookupCount;
+        return statistics;
+    }
+
+    void printStatistics(const QString& title, const LayoutStatistics& statistics, qint64 fileSize)
+    {
+        standardOutput() << QString("%1 %2 %3 %4 %5% %6 %7\n")
+                            .arg(title, -8)
+                            .arg(statistics.chunkCount, 10)
+                            .arg(statistics.averageChunkSize, 12, 'f', 0)
+                            .arg(statistics.chunksPerLookup, 15, 'f', 3)
+                            .arg(statistics.singleChunkRatio, 12, 'f', 1)
+                            .arg(statistics.bytesPerLookup, 14, 'f', 0)
+                            .arg(fileSize, 12);
+    }
+
+    // The size of the compressed data file that Dictionary opens
+    qint64 sourceFileSize(const QString& dataFilePath)
+    {
+        foreach (const QString& suffix, QStringList() << ".dz" << ".zst" << ".gz")
+        {
+            QFileInfo fileInfo(dataFilePath + suffix);
+            if (fileInfo.exists())
+                return fileInfo.size();
+        }
+
+        return 0;
+    }
+
+    bool readData(AbstractDataFile *dataFile, quint64 start, quint64 size, QByteArray *data)
+    {
+        data->clear();
+        data->reserve(size);
+
+        while (quint64(data->size()) < size)
+        {
+            unsigned long pieceSize = qMin<quint64>(size - data->size(), readSize);
+            QByteArray piece = dataFile->read(start + data->size(), pieceSize);
+            if (quint64(piece.size()) != pieceSize)
+            {
+                standardError() << "Cannot read the source data at " << start + data->size() << "\n";
+                return false;
+            }
+
+            data->append(piece);
+        }
+
+        return true;
+    }
+
+    // Deflates the data, and appends the output to the file
+    bool deflateData(z_stream *zStream, const QByteArray& data, int flush, QFile& output, quint64 *compressedSize)
+    {
+        char buffer[64 * 1024];
+
+        zStream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+        zStream->avail_in = data.size();
+
+        do
+        {
+            zStream->next_out = reinterpret_cast<Bytef *>(buffer);
+            zStream->avail_out = sizeof(buffer);
+
+            int status = deflate(zStream, flush);
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+            {
+                standardError() << "Cannot deflate the data: " << zStream->msg << "\n";
+                return false;
+            }
+
+            qint64 length = sizeof(buffer) - zStream->avail_out;
+            if (output.write(buffer, length) != length)
+            {
+                standardError() << "Cannot write " << output.fileName() << "\n";
+                return false;
+            }
+
+            *compressedSize += length;
+        }
+        while (zStream->avail_out == 0);
+
+        return true;
+    }
+
+    // Writes one deflate stream with a full flush at every chunk start, so
+    // every chunk can be inflated on its own, followed by the gzip trailer.
+    // The file positions of the chunks are appended to chunkOffsets.
+    bool writeDeflateChunks(QFile& output, AbstractDataFile *source, const QVector<quint64>& chunkStarts,
+                            int level, QVector<quint64> *chunkOffsets)
+    {
+        z_stream zStream;
+        zStream.zalloc = NULL;
+        zStream.zfree = NULL;
+        zStream.opaque = NULL;
+
+        if (deflateInit2( &zStream, level, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY ) != Z_OK)
+        {
+            standardError() << "Cannot initialize deflation engine: " << zStream.msg << "\n";
+            return false;
+        }
+
+        quint32 crc = crc32(0L, Z_NULL, 0);
+        quint64 position = output.pos();
+        int chunkCount = chunkStarts.size() - 1;
+        bool result = true;
+
+        for (int i = 0; i < chunkCount && result; ++i)
+        {
+            QByteArray data;
+            result = readData(source, chunkStarts.at(i), chunkStarts.at(i + 1) - chunkStarts.at(i), &data);
+            if (!result)
+                break;
+
+            crc = crc32(crc, reinterpret_cast<const Bytef *>(data.constData()), data.size());
+
+            chunkOffsets->append(position);
+            result = deflateData(&zStream, data, (i == chunkCount - 1) ? Z_FINISH : Z_FULL_FLUSH, output, &position);
+        }
+
+        deflateEnd( &zStream );
+
+        if (!result)
+            return false;
+
+        uchar trailer[8];
+        qToLittleEndian<quint32>(crc, trailer);
+        qToLittleEndian<quint32>(chunkStarts.last() & 0xffffffff, trailer + 4);
+
+        return output.write(reinterpret_cast<const char *>(trailer), sizeof(trailer)) == sizeof(trailer);
+    }
+
+    bool writeGzip(QFile& output, AbstractDataFile *source, const QVector<quint64>& chunkStarts,
+                   int level, QVector<quint64> *chunkOffsets)
+    {
+        const uchar header[10] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, uchar(level == 9 ? 2 : 0), 3 };
+        if (output.write(reinterpret_cast<const char *>(header), sizeof(header)) != sizeof(header))
+            return false;
+
+        return writeDeflateChunks(output, source, chunkStarts, level, chunkOffsets);
+    }
+
+    bool writeDictzip(QFile& output, AbstractDataFile *source, const QVector<quint64>& chunkStarts, int level)
+    {
+        int chunkCount = chunkStarts.size() - 1;
+        int chunkLength = chunkStarts.at(1) - chunkStarts.at(0);
+
+        // The chunk sizes are filled in once the chunks are compressed
+        QByteArray header(22 + 2 * chunkCount, '\0');
+        uchar *headerData = reinterpret_cast<uchar *>(header.data());
+        headerData[0] = 0x1f;
+        headerData[1] = 0x8b;
+        headerData[2] = Z_DEFLATED;
+        headerData[3] = 0x04;   // FEXTRA
+        headerData[8] = (level == 9) ? 2 : 0;
+        headerData[9] = 3;
+        qToLittleEndian<quint16>(10 + 2 * chunkCount, headerData + 10);
+        headerData[12] = 'R';
+        headerData[13] = 'A';
+        qToLittleEndian<quint16>(6 + 2 * chunkCount, headerData + 14);
+        qToLittleEndian<quint16>(1, headerData + 16);
+        qToLittleEndian<quint16>(chunkLength, headerData + 18);
+        qToLittleEndian<quint16>(chunkCount, headerData + 20);
+
+        if (output.write(header) != header.size())
+            return false;
+
+        QVector<quint64> chunkOffsets;
+        if (!writeDeflateChunks(output, source, chunkStarts, level, &chunkOffsets))
+            return false;
+
+        // The end of the last chunk is where the trailer starts
+        chunkOffsets.append(output.pos() - 8);
+
+        for (int i = 0; i < chunkCount; ++i)
+        {
+            quint64 compressedSize = chunkOffsets.at(i + 1) - chunkOffsets.at(i);
+            if (compressedSize > 0xffff)
+            {
+                standardError() << "Chunk " << i << " does not fit into the dictzip chunk table\n";
+                return false;
+            }
+
+            qToLittleEndian<quint16>(compressedSize, headerData + 22 + 2 * i);
+        }
+
+        return output.seek(0) && output.write(header) == header.size();
+    }
+
+#ifdef HAVE_ZSTD
+    bool writeZstd(QFile& output, AbstractDataFile *source, const QVector<quint64>& chunkStarts, int level)
+    {
+        int chunkCount = chunkStarts.size() - 1;
+
+        ZSTD_CCtx *context = ZSTD_createCCtx();
+        if (!context)
+            return false;
+
+        // Skippable frame magic, frame size, the entries and the footer
+        QByteArray seekTable(8 + 8 * chunkCount + 9, '\0');
+        uchar *seekTableData = reinterpret_cast<uchar *>(seekTable.data());
+        qToLittleEndian<quint32>(0x184D2A5E, seekTableData);
+        qToLittleEndian<quint32>(8 * chunkCount + 9, seekTableData + 4);
+
+        QByteArray frame;
+        bool result = true;
+
+        for (int i = 0; i < chunkCount && result; ++i)
+        {
+            QByteArray data;
+            result = readData(source, chunkStarts.at(i), chunkStarts.at(i + 1) - chunkStarts.at(i), &data);
+            if (!result)
+                break;
+
+            frame.resize(ZSTD_compressBound(data.size()));
+            size_t frameSize = ZSTD_compressCCtx(context, frame.data(), frame.size(), data.constData(), data.size(), level);
+            if (ZSTD_isError(frameSize))
+            {
+                standardError() << "Cannot compress chunk " << i << ": " << ZSTD_getErrorName(frameSize) << "\n";
+                result = false;
+                break;
+            }
+
+            qToLittleEndian<quint32>(frameSize, seekTableData + 8 + 8 * i);
+            qToLittleEndian<quint32>(data.size(), seekTableData + 8 + 8 * i + 4);
+            result = output.write(frame.constData(), frameSize) == qint64(frameSize);
+        }
+
+        ZSTD_freeCCtx(context);
+
+        if (!result)
+            return false;
+
+        uchar *footer = seekTableData + 8 + 8 * chunkCount;
+        qToLittleEndian<quint32>(chunkCount, footer);
+        footer[4] = 0;          // No checksums
+        qToLittleEndian<quint32>(0x8F92EAB1, footer + 5);
+
+        return output.write(seekTable) == seekTable.size();
+    }
+#endif
+
+    AbstractDataFile *newDataFile(OutputFormat format)
+    {
+        switch (format)
+        {
+        case DictzipFormat:
+            return new DictionaryZip;
+        case GzipFormat:
+            return new GzipDataFile;
+#ifdef HAVE_ZSTD
+        case ZstdFormat:
+            return new ZstdDataFile;
+#else
+        case ZstdFormat:
+            break;
+#endif
+        }
+
+        return 0;
+    }
+
+    // Reads every article back from the written file
+    bool verify(const QString& fileName, OutputFormat format, AbstractDataFile *source,
+                const QVector<quint64>& chunkStarts, const QVector<Article>& articles)
+    {
+        QScopedPointer<AbstractDataFile> dataFile(newDataFile(format));
+        if (!dataFile || !dataFile->open(fileName))
+        {
+            standardError() << "Cannot open the written file " << fileName << "\n";
+            return false;
+        }
+
+        if (dataFileChunkStarts(dataFile.data()) != chunkStarts)
+        {
+            standardError() << "The chunks of the written file differ from the planned ones\n";
+            return false;
+        }
+
+        foreach (const Article& article, articles)
+        {
+            if (article.size == 0)
+                continue;
+
+            if (dataFile->read(article.offset, article.size) != source->read(article.offset, article.size))
+            {
+                standardError() << "The article at " << article.offset << " differs from the source\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    QCoreApplication app( argc, argv );
+    app.setOrganizationName( "Mula" );
+    app.setApplicationName( "Mula StarDict Recompress" );
+
+    QStringList arguments = app.arguments();
+    arguments.removeFirst();
+
+    int chunkSize = defaultChunkSize;
+    int level = -1;
+
+    while (!arguments.isEmpty() && arguments.first().startsWith("--"))
+    {
+        QString option = arguments.takeFirst();
+        bool ok = false;
+
+        if (option == "--chunk-size" && !arguments.isEmpty())
+            chunkSize = arguments.takeFirst().toInt(&ok);
+        else if (option == "--level" && !arguments.isEmpty())
+            level = arguments.takeFirst().toInt(&ok);
+
+        if (!ok || chunkSize <= 0 || (option == "--level" && level < 0))
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (arguments.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    QString ifoFilePath = arguments.at(0);
+    QString outputFilePath = arguments.at(1);
+
+    OutputFormat format;
+    if (outputFilePath.endsWith(".dz"))
+    {
+        format = DictzipFormat;
+    }
+    else if (outputFilePath.endsWith(".gz"))
+    {
+        format = GzipFormat;
+    }
+    else if (outputFilePath.endsWith(".zst"))
+    {
+#ifndef HAVE_ZSTD
+        standardError() << "This build does not support zstd\n";
+        return 1;
+#endif
+        format = ZstdFormat;
+    }
+    else
+    {
+        printUsage();
+        return 1;
+    }
+
+    // The level is checked before loading the dictionary, which may take a
+    // while, as the compressors would only reject it at the first chunk
+    if (level < 0)
+    {
+        level = (format == ZstdFormat) ? defaultZstdLevel : defaultDeflateLevel;
+    }
+    else if (level > maximumLevel(format) || (format == ZstdFormat && level == 0))
+    {
+        standardError() << "Invalid compression level: " << level << "\n";
+        printUsage();
+        return 1;
+    }
+
+    Dictionary dictionary;
+    if (!dictionary.load(ifoFilePath))
+    {
+        standardError() << "Cannot load the dictionary " << ifoFilePath << "\n";
+        return 1;
+    }
+
+    AbstractDataFile *source = dictionary.compressedDictionaryFile();
+    QVector<Article> articles = dictionaryArticles(dictionary);
+    QVector<quint64> sourceChunkStarts = dataFileChunkStarts(source);
+
+    QString dataFilePath = ifoFilePath;
+    dataFilePath.replace(dataFilePath.length() - sizeof("ifo") + 1, sizeof("ifo") - 1, "dict");
+
+    // The size of an uncompressed source is the size of the plain file
+    quint64 dataSize = sourceChunkStarts.isEmpty() ? QFileInfo(dataFilePath).size() : sourceChunkStarts.last();
+    if (dataSize == 0)
+    {
+        standardError() << "The dictionary has no data\n";
+        return 1;
+    }
+
+    QFileInfo outputFileInfo(outputFilePath);
+    foreach (const QString& suffix, QStringList() << "" << ".dz" << ".gz" << ".zst")
+    {
+        if (outputFileInfo.exists() && outputFileInfo.canonicalFilePath() == QFileInfo(dataFilePath + suffix).canonicalFilePath())
+        {
+            standardError() << "The output file cannot replace the source data file\n";
+            return 1;
+        }
+    }
+
+    QVector<quint64> chunkStarts;
+    if (format == DictzipFormat)
+    {
+        // dictzip chunks have one fixed length, so they cannot follow the
+        // articles; the length is raised if the chunk table would overflow
+        quint64 minimumChunkLength = (dataSize + maximumDictzipChunkCount - 1) / maximumDictzipChunkCount;
+        if (minimumChunkLength > quint64(maximumDictzipChunkLength))
+        {
+            standardError() << "The data is too large for dictzip, use the .gz or the .zst output\n";
+            return 1;
+        }
+
+        int chunkLength = qBound<quint64>(minimumChunkLength, chunkSize, maximumDictzipChunkLength);
+        chunkStarts = fixedChunkStarts(dataSize, chunkLength);
+    }
+    else
+    {
+        chunkStarts = alignedChunkStarts(articles, dataSize, chunkSize);
+    }
+
+    QFile output(outputFilePath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        standardError() << "Cannot open " << outputFilePath << " for writing\n";
+        return 1;
+    }
+
+    QVector<quint64> chunkOffsets;
+    bool written = false;
+
+    switch (format)
+    {
+    case DictzipFormat:
+        written = writeDictzip(output, source, chunkStarts, level);
+        break;
+    case GzipFormat:
+        written = writeGzip(output, source, chunkStarts, level, &chunkOffsets);
+        break;
+    case ZstdFormat:
+#ifdef HAVE_ZSTD
+        written = writeZstd(output, source, chunkStarts, level);
+#endif
+        break;
+    }
+
+    output.close();
+
+    if (written && format == GzipFormat)
+    {
+        QVector<quint64> accessPointStarts = chunkStarts;
+        accessPointStarts.removeLast();
+        written = GzipDataFile::saveFlushedIndex(outputFilePath, accessPointStarts, chunkOffsets, dataSize);
+    }
+
+    if (!written || !verify(outputFilePath, format, source, chunkStarts, articles))
+    {
+        standardError() << "Failed to write " << outputFilePath << "\n";
+        output.remove();
+        return 1;
+    }
+
+    standardOutput() << QString("%1 %2 %3 %4 %5 %6 %7\n")
+                        .arg("", -8)
+                        .arg("chunks", 10)
+                        .arg("chunk size", 12)
+                        .arg("chunks/lookup", 15)
+                        .arg("one chunk", 13)
+                        .arg("bytes/lookup", 14)
+                        .arg("file size", 12);
+
+    if (sourceChunkStarts.isEmpty())
+        standardOutput() << QString("%1 %2\n").arg("before", -8).arg("not compressed");
+    else
+        printStatistics("before", layoutStatistics(sourceChunkStarts, articles), sourceFileSize(dataFilePath));
+
+    printStatistics("after", layoutStatistics(chunkStarts, articles), QFileInfo(outputFilePath).size());
+
+    standardOutput().flush();
+    return 0;
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "wildcardpattern.h"
+
+#include <QtCore/QString>
+
+#include <string.h>
+
+using namespace MulaPluginStarDict;
+
+class WildcardPattern::Private
+{
+    public:
+        Private()
+            : valid(false)
+            , acceptMask(0)
+            , starMask(0)
+            , starLoopMask(0)
+            , anyLoopMask(0)
+        {
+            memset(byteMasks, 0, sizeof(byteMasks));
+        }
+
+        ~Private()
+        {
+        }
+
+        // Follows the empty transitions of the '*' elements. The consecutive
+        // '*' are merged, so one step is enough.
+        quint64 closure(quint64 states) const
+        {
+            return states | ((states & starMask) << 1);
+        }
+
+        bool valid;
+        QByteArray literalPrefix;
+        QList<QByteArray> literals;
+
+        // The state i means that the first i elements of the pattern are
+        // matched, an element being a byte of the literal text, a '?' or a
+        // '*'. The bit i of byteMasks[c] is set if the element i consumes
+        // the byte c and moves on to the next state.
+        quint64 byteMasks[256];
+        quint64 acceptMask;
+
+        // The elements i that are '*', which can be skipped
+        quint64 starMask;
+
+        // The states after a '*', which consume any byte and stay
+        quint64 starLoopMask;
+
+        // The states after a '?', which consume the continuation bytes of the
+        // character the '?' matched the first byte of
+        quint64 anyLoopMask;
+};
+
+WildcardPattern::WildcardPattern(const QString& pattern)
+    : d(new Private)
+{
+    QByteArray literal;
+    int elementCount = 0;
+    bool isPrefix = true;
+
+    // The states are the bits of a 64 bit word, the last one accepting
+    static const int maximumElementCount = 63;
+
+    for (int i = 0; i < pattern.length(); ++i)
+    {
+        QChar character = pattern.at(i);
+        if (character == '[')
+            return;
+
+        if (character == '*' || character == '?')
+        {
+            if (!literal.isEmpty())
+            {
+                d->literals.append(literal);
+                literal.clear();
+            }
+
+            isPrefix = false;
+
+            if (character == '*')
+            {
+                // '**' is the same as '*'
+                if (elementCount > 0 && (d->starMask & (Q_UINT64_C(1) << (elementCount - 1))))
+                    continue;
+
+                if (elementCount == maximumElementCount)
+                    return;
+
+                d->starMask |= Q_UINT64_C(1) << elementCount;
+                d->starLoopMask |= Q_UINT64_C(1) << (elementCount + 1);
+            }
+            else
+            {
+                if (elementCount == maximumElementCount)
+                    return;
+
+                // The '?' consumes the first byte of a character
+                for (int byte = 0; byte < 256; ++byte)
+                {
+                    if ((byte & 0xc0) != 0x80)
+                        d->byteMasks[byte] |= Q_UINT64_C(1) << elementCount;
+                }
+
+                d->anyLoopMask |= Q_UINT64_C(1) << (elementCount + 1);
+            }
+
+            ++elementCount;
+            continue;
+        }
+
+        // The surrogate pairs are encoded together
+        int characterLength = 1;
+        if (character.isHighSurrogate() && i + 1 < pattern.length() && pattern.at(i + 1).isLowSurrogate())
+            characterLength = 2;
+
+        QByteArray bytes = pattern.mid(i, characterLength).toUtf8();
+        i += characterLength - 1;
+
+        if (elementCount + bytes.size() > maximumElementCount)
+            return;
+
+        for (int j = 0; j < bytes.size(); ++j)
+            d->byteMasks[uchar(bytes.at(j))] |= Q_UINT64_C(1) << elementCount++;
+
+        literal.append(bytes);
+        if (isPrefix)
+            d->literalPrefix.append(bytes);
+    }
+
+    if (!literal.isEmpty())
+        d->literals.append(literal);
+
+    d->acceptMask = Q_UINT64_C(1) << elementCount;
+    d->valid = true;
+}
+
+WildcardPattern::~WildcardPattern()
+{
+    delete d;
+}
+
+bool
+WildcardPattern::isValid() const
+{
+    return d->valid;
+}
+
+QByteArray
+WildcardPattern::literalPrefix() const
+{
+    return d->literalPrefix;
+}
+
+QList<QByteArray>
+WildcardPattern::literals() const
+{
+    return d->literals;
+}
+
+bool
+WildcardPattern::exactMatch(const char *word, int length) const
+{
+    if (!d->valid)
+        return false;
+
+    const uchar *position = reinterpret_cast<const uchar*>(word);
+    const uchar *end = position + length;
+    quint64 states = d->closure(1);
+
+    for ( ; position != end; ++position)
+    {
+        uchar byte = *position;
+        quint64 loopMask = d->starLoopMask;
+        if ((byte & 0xc0) == 0x80)
+            loopMask |= d->anyLoopMask;
+
+        states = d->closure(((states & d->byteMasks[byte]) << 1) | (states & loopMask));
+        if (!states)
+            return false;
+    }
+
+    return states & d->acceptMask;
+}
+
+bool
+WildcardPattern::exactMatch(const QByteArray& word) const
+{
+    return exactMatch(word.constData(), word.size());
+}
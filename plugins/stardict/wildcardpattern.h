@@ -0,0 +1,115 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_WILDCARDPATTERN_H
+#define MULA_PLUGIN_STARDICT_WILDCARDPATTERN_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+
+class QString;
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Wildcard pattern compiled into an automaton over the utf-8
+     * encoded word data
+     *
+     * The '*' of the pattern matches any sequence of characters, the '?'
+     * matches one character, and every other character matches itself,
+     * case sensitively, like the QRegExp::Wildcard syntax does. The pattern
+     * is compiled into a nondeterministic automaton with one state per byte
+     * of the pattern, and the states are simulated at once as the bits of a
+     * 64 bit word, so the words of the index are matched byte by byte
+     * without being decoded.
+     *
+     * The character sets of the QRegExp::Wildcard syntax and the patterns
+     * longer than the automaton can hold are not compiled, the callers fall
+     * back to QRegExp for them.
+     *
+     * \see Dictionary::lookupPattern
+     */
+
+    class WildcardPattern
+    {
+        public:
+
+            /**
+             * Constructor
+             *
+             * @param   pattern     The wildcard pattern
+             */
+
+            explicit WildcardPattern(const QString& pattern);
+
+            /**
+             * Destructor
+             */
+
+            virtual ~WildcardPattern();
+
+            /**
+             * Returns whether or not the pattern could be compiled
+             *
+             * @return True if the pattern was compiled, otherwise false
+             */
+
+            bool isValid() const;
+
+            /**
+             * Returns the literal text before the first wildcard, which all
+             * the matching words start with
+             *
+             * @return The utf-8 encoded prefix, or an empty byte array if the
+             * pattern starts with a wildcard
+             */
+
+            QByteArray literalPrefix() const;
+
+            /**
+             * Returns the literal texts between the wildcards, which all the
+             * matching words contain
+             *
+             * @return The utf-8 encoded literal texts in their order
+             */
+
+            QList<QByteArray> literals() const;
+
+            /**
+             * Returns whether or not the whole word matches the pattern
+             *
+             * \note This method is safe to call from several threads at once.
+             *
+             * @param   word    The utf-8 encoded word
+             * @param   length  The length of the word in bytes
+             *
+             * @return True if the word matches, otherwise false
+             */
+
+            bool exactMatch(const char *word, int length) const;
+
+            bool exactMatch(const QByteArray& word) const;
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_WILDCARDPATTERN_H
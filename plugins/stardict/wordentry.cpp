@@ -35,8 +35,9 @@ class WordEntry::Private : public QSharedData
         }
  
         QByteArray data;
-        quint32 dataOffset;
+        quint64 dataOffset;
         quint32 dataSize;
+        QByteArray collationKey;
 };
 
 WordEntry::WordEntry()
@@ -73,12 +74,12 @@ WordEntry::data() const
 }
 
 void
-WordEntry::setDataOffset(quint32 dataOffset)
+WordEntry::setDataOffset(quint64 dataOffset)
 {
     d->dataOffset = dataOffset;
 }
 
-quint32
+quint64
 WordEntry::dataOffset() const
 {
     return d->dataOffset;
@@ -95,3 +96,15 @@ WordEntry::dataSize() const
 {
     return d->dataSize;
 }
+
+void
+WordEntry::setCollationKey(QByteArray collationKey)
+{
+    d->collationKey = collationKey;
+}
+
+QByteArray
+WordEntry::collationKey() const
+{
+    return d->collationKey;
+}
@@ -104,7 +104,7 @@ namespace MulaPluginStarDict
              *
              * @see offset
              */
-            void setDataOffset(quint32 dataOffset);
+            void setDataOffset(quint64 dataOffset);
 
             /**
              * Returns the offset of the word entry representing the offset of
@@ -114,7 +114,7 @@ namespace MulaPluginStarDict
              *
              * @see setOffset
              */
-            quint32 dataOffset() const;
+            quint64 dataOffset() const;
 
             /**
              * Sets the size of the word entry in this word entry representing
@@ -136,6 +136,27 @@ namespace MulaPluginStarDict
              */
             quint32 dataSize() const;
 
+            /**
+             * Sets the collation key of the word entry as returned by
+             * stardictCollationKey() for the utf-8 string
+             *
+             * @param collationKey The collation key of the utf-8 string
+             *
+             * @see collationKey
+             */
+            void setCollationKey(QByteArray collationKey);
+
+            /**
+             * Returns the collation key of the word entry. The word entries
+             * can be sorted by comparing the collation keys byte by byte in
+             * the same order as stardictStringCompare() sorts the strings.
+             *
+             * @return The collation key of the utf-8 string
+             *
+             * @see setCollationKey
+             */
+            QByteArray collationKey() const;
+
         private:
             class Private;
             QSharedDataPointer<Private> d;
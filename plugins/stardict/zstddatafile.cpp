@@ -0,0 +1,236 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "zstddatafile.h"
+
+#include "mappedfile.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+#include <zstd.h>
+
+using namespace MulaPluginStarDict;
+
+namespace
+{
+    // See the zstd seekable format specification in contrib/seekable_format
+    const quint32 skippableFrameMagic = 0x184D2A5E;
+    const quint32 seekableMagic = 0x8F92EAB1;
+    const int skippableFrameHeaderSize = 8;
+    const int seekTableFooterSize = 9;
+    const int checksumFlag = 0x80;
+    const int reservedDescriptorBits = 0x7C;
+}
+
+class ZstdDataFile::Private
+{
+    public:
+        Private()
+        {
+        }
+
+        ~Private()
+        {
+        }
+
+        bool readSeekTable();
+
+        ZSTD_DCtx *acquireContext()
+        {
+            {
+                QMutexLocker locker(&contextMutex);
+                if (!idleContexts.isEmpty())
+                    return idleContexts.takeLast();
+            }
+
+            return ZSTD_createDCtx();
+        }
+
+        void releaseContext(ZSTD_DCtx *context)
+        {
+            QMutexLocker locker(&contextMutex);
+            idleContexts.append(context);
+        }
+
+        MappedFile dataFile;
+
+        // The offsets of the frames with one more entry for the end of the
+        // last frame
+        QVector<quint64> compressedOffsets;
+        QVector<quint64> decompressedOffsets;
+
+        // The decompression contexts are reused by the concurrent readers
+        QMutex contextMutex;
+        QList<ZSTD_DCtx *> idleContexts;
+};
+
+bool
+ZstdDataFile::Private::readSeekTable()
+{
+    quint64 dataSize = dataFile.size();
+    if (dataSize < quint64(skippableFrameHeaderSize + seekTableFooterSize))
+        return false;
+
+    QByteArray footerData = dataFile.read(dataSize - seekTableFooterSize, seekTableFooterSize);
+    if (footerData.size() != seekTableFooterSize)
+        return false;
+
+    const uchar *footer = reinterpret_cast<const uchar *>(footerData.constData());
+    quint32 frameCount = qFromLittleEndian<quint32>(footer);
+    uchar descriptor = footer[4];
+
+    if (qFromLittleEndian<quint32>(footer + 5) != seekableMagic || (descriptor & reservedDescriptorBits))
+        return false;
+
+    int entrySize = (descriptor & checksumFlag) ? 12 : 8;
+    quint64 tableSize = quint64(frameCount) * entrySize + seekTableFooterSize;
+    if (tableSize + skippableFrameHeaderSize > dataSize)
+        return false;
+
+    QByteArray tableData = dataFile.read(dataSize - tableSize - skippableFrameHeaderSize, tableSize + skippableFrameHeaderSize);
+    if (quint64(tableData.size()) != tableSize + skippableFrameHeaderSize)
+        return false;
+
+    const uchar *frameHeader = reinterpret_cast<const uchar *>(tableData.constData());
+    if (qFromLittleEndian<quint32>(frameHeader) != skippableFrameMagic
+            || qFromLittleEndian<quint32>(frameHeader + 4) != tableSize)
+        return false;
+
+    compressedOffsets.resize(frameCount + 1);
+    decompressedOffsets.resize(frameCount + 1);
+    compressedOffsets[0] = 0;
+    decompressedOffsets[0] = 0;
+
+    const uchar *entry = frameHeader + skippableFrameHeaderSize;
+    for (quint32 i = 0; i < frameCount; ++i, entry += entrySize)
+    {
+        compressedOffsets[i + 1] = compressedOffsets.at(i) + qFromLittleEndian<quint32>(entry);
+        decompressedOffsets[i + 1] = decompressedOffsets.at(i) + qFromLittleEndian<quint32>(entry + 4);
+    }
+
+    // The frames must end where the seek table begins
+    return compressedOffsets.last() == dataSize - tableSize - skippableFrameHeaderSize;
+}
+
+ZstdDataFile::ZstdDataFile()
+    : d(new Private)
+{
+}
+
+ZstdDataFile::~ZstdDataFile()
+{
+    close();
+    delete d;
+}
+
+bool
+ZstdDataFile::open(const QString& fileName)
+{
+    close();
+
+    if (!d->dataFile.open(fileName))
+        return false;
+
+    if (!d->readSeekTable())
+    {
+        qDebug() << Q_FUNC_INFO << QString("\"%1\" not in zstd seekable format").arg(fileName);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void
+ZstdDataFile::close()
+{
+    removeCachedChunks();
+
+    d->compressedOffsets.clear();
+    d->decompressedOffsets.clear();
+
+    foreach (ZSTD_DCtx *context, d->idleContexts)
+        ZSTD_freeDCtx(context);
+
+    d->idleContexts.clear();
+    d->dataFile.close();
+}
+
+QByteArray
+ZstdDataFile::read(quint64 start, unsigned long size, QByteArray *chunk)
+{
+    if (d->decompressedOffsets.isEmpty())
+        return QByteArray();
+
+    return readChunks(start, size, chunk);
+}
+
+int
+ZstdDataFile::chunkCount() const
+{
+    return qMax(d->decompressedOffsets.size() - 1, 0);
+}
+
+quint64
+ZstdDataFile::chunkStart(int index) const
+{
+    return d->decompressedOffsets.at(index);
+}
+
+QByteArray
+ZstdDataFile::decodeChunk(int index)
+{
+    quint64 frameSize = d->compressedOffsets.at(index + 1) - d->compressedOffsets.at(index);
+    QByteArray frame = d->dataFile.read(d->compressedOffsets.at(index), frameSize);
+    if (quint64(frame.size()) != frameSize)
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot read frame %1").arg(index);
+        return QByteArray();
+    }
+
+    ZSTD_DCtx *context = d->acquireContext();
+    if (!context)
+        return QByteArray();
+
+    QByteArray result;
+    result.resize(d->decompressedOffsets.at(index + 1) - d->decompressedOffsets.at(index));
+
+    size_t status = ZSTD_decompressDCtx(context, result.data(), result.size(), frame.constData(), frame.size());
+    d->releaseContext(context);
+
+    if (ZSTD_isError(status) || status != size_t(result.size()))
+    {
+        qWarning() << Q_FUNC_INFO << QString("Cannot decompress frame %1: %2").arg(index)
+            .arg(ZSTD_isError(status) ? ZSTD_getErrorName(status) : "size mismatch");
+        return QByteArray();
+    }
+
+    return result;
+}
+
+void
+ZstdDataFile::setAccessPattern(AccessPattern accessPattern)
+{
+    adviseMapping(d->dataFile.data(), d->dataFile.size(), accessPattern);
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ * This file is part of the Mula project
+ * Copyright (c) 2011 Laszlo Papp <lpapp@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MULA_PLUGIN_STARDICT_ZSTDDATAFILE_H
+#define MULA_PLUGIN_STARDICT_ZSTDDATAFILE_H
+
+#include "abstractdatafile.h"
+
+namespace MulaPluginStarDict
+{
+    /**
+     * \brief Random access reader of the ".dict.zst" files in the zstd
+     * seekable format
+     *
+     * The seekable format stores the data in independent zstd frames, and a
+     * seek table with the compressed and the decompressed size of every frame
+     * in a skippable frame at the end of the file. The frames play the role
+     * of the dictzip chunks, but they decompress several times faster.
+     *
+     * \note The class is only built if the zstd library is found, in which
+     * case HAVE_ZSTD is defined.
+     *
+     * \see DictionaryZip
+     */
+
+    class ZstdDataFile : public AbstractDataFile
+    {
+        public:
+
+            /**
+             * Constructor
+             */
+
+            ZstdDataFile();
+
+            /**
+             * Destructor
+             */
+
+            virtual ~ZstdDataFile();
+
+            /**
+             * Opens the zstd file, and reads its seek table
+             *
+             * @param   fileName    The complete file path of the zstd file
+             *
+             * @return True if the file was opened successfully, otherwise
+             * false.
+             */
+
+            bool open(const QString& fileName);
+
+            void close();
+
+            QByteArray read(quint64 start, unsigned long size, QByteArray *chunk = 0);
+
+            int chunkCount() const;
+            quint64 chunkStart(int index) const;
+            void setAccessPattern(AccessPattern accessPattern);
+
+        protected:
+            QByteArray decodeChunk(int index);
+
+        private:
+            class Private;
+            Private *const d;
+    };
+}
+
+#endif // MULA_PLUGIN_STARDICT_ZSTDDATAFILE_H